@@ -0,0 +1,65 @@
+#ifndef JFR_ARENA_H
+#define JFR_ARENA_H
+
+
+#include <stdlib.h>
+#include <assert.h>
+#include <vector>
+#include <boost/thread/mutex.hpp>
+#include "Common.h"
+
+
+OPEN_NAMESPACE_JFR
+
+using namespace std;
+
+
+#define JFR_ARENA_CHUNK_SIZE		4096			// 默认块大小(字节)，超过块大小的分配单独成块
+#define JFR_ARENA_RETAIN_SIZE		(1 << 20)		// 复位时保留的块总大小上限(字节)，超过时释放多余的块
+#define JFR_ARENA_ALIGN				16				// 分配对齐(字节)
+
+
+/// 运行时内存区
+// 按块顺序分配，不单独释放，运行时回收时整体复位到基准点，基准点之前的分配(如字符串常量参数)一直保留
+// 同一实例的模块在多个工作线程中并发运行，分配加锁；复位只在没有运行中的模块时调用
+class Arena
+{
+public:
+	Arena(void);
+	~Arena(void);
+	void* Alloc(size_t size);
+	void* Grow(void* ptr, size_t size, size_t newSize);
+	char* Strdup(const char* str, size_t len);
+	void Mark(void);
+	void Reset(void);
+	static void* EnvAlloc(ModEnv_t* pEnv, size_t size);
+
+private:
+	struct Chunk_st
+	{
+		char*						m_pBuf;
+		size_t						m_nSize;
+	};
+	typedef struct Chunk_st Chunk_t;
+
+	inline void* AllocLocked(size_t size);
+
+private:
+	vector< Chunk_t >				m_vChunks;
+	size_t							m_nChunk;			// 当前块下标
+	size_t							m_nOffset;			// 当前块已分配字节数
+	size_t							m_nMarkChunk;		// 基准点
+	size_t							m_nMarkOffset;
+	void*							m_pLast;			// 最近一次分配，可原地扩展
+	boost::mutex					m_oMutex;
+
+private:
+	Arena(const Arena&);
+	Arena& operator=(const Arena&);
+};
+
+
+CLOSE_NAMESPACE_JFR
+
+
+#endif // JFR_ARENA_H
@@ -14,6 +14,7 @@
 #include <errno.h>
 #include <string>
 #include <boost/thread/mutex.hpp>
+#include <boost/atomic.hpp>
 #include <Logger/Logger.hpp>
 
 
@@ -101,23 +102,45 @@ struct ModArg_st
 	}
 };
 
+/// 参数值类型，v2接口使用
+enum ArgValueType
+{
+	AVT_UNKNOWN = 0,		// 未知，v1动态库模块的出参由模块间自行约定；v2接口出参为此类型时表示没有输出
+	AVT_STRING,				// '\0'结尾的字符串，长度不含'\0'
+	AVT_BINARY,				// 二进制内容，进程模块的出参为此类型，内容之后仍有一个'\0'
+	AVT_OPAQUE				// 不透明指针，只在动态库模块之间传递，长度由模块约定
+};
+
 /// 参数值结构
+// 出参随写入模块的结束状态发布，读写均不加锁
 struct ArgValue_st
 {
 	typedef void (*ArgFree)(void*);
     void*						m_pValue;           // 参数值指针
     ArgFree            			m_pFreeFunc;        // 释放回调函数
     ModArg_st*					m_pModArg;
-    boost::mutex				m_oMutex;
+    size_t						m_nLength;			// 参数值长度(字节)，0表示按'\0'结尾的字符串处理；进程模块的出参总是记录长度
+    unsigned int				m_nType;			// 参数值类型ArgValueType
+    size_t						m_nCapacity;		// m_pValue的缓冲区大小，大于0且有释放回调函数时回收实例后保留，供v2接口模块下次写入
+    void*						m_pSpare;			// 保留的缓冲区，见Recycle
+    ArgFree						m_pSpareFree;
+    size_t						m_nSpareCapacity;
 	ArgValue_st(void)
 	{
         m_pValue = NULL;
         m_pFreeFunc = NULL;
         m_pModArg = NULL;
+        m_nLength = 0;
+        m_nType = AVT_UNKNOWN;
+        m_nCapacity = 0;
+        m_pSpare = NULL;
+        m_pSpareFree = NULL;
+        m_nSpareCapacity = 0;
 	}
 	~ArgValue_st(void)
 	{
 		Free();
+		FreeSpare();
 	}
 	inline void Free(void)
 	{
@@ -127,6 +150,68 @@ struct ArgValue_st
 		}
 		m_pValue = NULL;
 		m_pFreeFunc = NULL;
+		m_nLength = 0;
+		m_nType = AVT_UNKNOWN;
+		m_nCapacity = 0;
+	}
+	/// 清除参数值，可复用的缓冲区不释放，保留为m_pSpare
+	inline void Recycle(void)
+	{
+		if (m_pValue && m_pFreeFunc && m_nCapacity > 0)
+		{
+			FreeSpare();
+			m_pSpare = m_pValue;
+			m_pSpareFree = m_pFreeFunc;
+			m_nSpareCapacity = m_nCapacity;
+			m_pFreeFunc = NULL;
+		}
+		Free();
+	}
+	inline void FreeSpare(void)
+	{
+		if (m_pSpareFree)
+		{
+			m_pSpareFree(m_pSpare);
+		}
+		m_pSpare = NULL;
+		m_pSpareFree = NULL;
+		m_nSpareCapacity = 0;
+	}
+};
+
+/// v2接口参数
+// 入参只读，类型和长度取自参数值；出参调用前为上次运行保留的缓冲区(m_pData，容量m_nCapacity，释放回调函数m_pFreeFunc，没有时均为空)，
+// 模块可直接写入并设置类型和长度；也可以换成自己分配的缓冲区，所有权随m_pData和m_pFreeFunc一起转给jfr，不复制，被换下的原缓冲区由jfr释放
+// 缓冲区有释放回调函数且容量大于0时，实例回收后保留，下次运行交还给模块；从运行环境m_pAlloc分配时释放回调函数置为NULL，不保留
+// 返回后m_pData和m_pFreeFunc均与移交时相同才视为沿用保留的缓冲区；m_pData不变而m_pFreeFunc被修改时，
+// jfr按原释放回调函数释放该缓冲区并丢弃本出参(按没有输出处理)，模块不应在沿用缓冲区时修改m_pFreeFunc
+struct ModArgV2_st
+{
+	unsigned int				m_nType;			// 参数值类型ArgValueType
+	void*						m_pData;
+	size_t						m_nLength;			// 内容长度(字节)
+	size_t						m_nCapacity;		// 缓冲区大小(字节)，只用于出参
+	void						(*m_pFreeFunc)(void*);
+};
+
+/// 模块运行环境，传给动态库扩展回调函数<main>_ex
+struct ModEnv_st
+{
+	boost::atomic< int >		m_nCanceled;		// 非0表示模块已被取消(超时或等效模块已满足要求)，模块应尽快返回
+	unsigned int				m_nTimeout;			// 超时时间(毫秒)，0表示不限制
+	void*						(*m_pAlloc)(ModEnv_st* pEnv, size_t size);	// 分配函数，内存在所属实例结束后统一释放；用于出参时释放回调函数置为NULL
+	void*						m_pAllocArg;		// 分配函数使用的内存区，模块不应修改
+	void*						m_pModuleState;		// <main>_init生成的模块状态，所有线程共用
+	void*						m_pThreadState;		// <main>_thread_init为调用线程生成的线程状态，只由该线程使用
+
+	ModEnv_st(void)
+	{
+		m_nCanceled = 0;
+		m_nTimeout = 0;
+		m_pAlloc = NULL;
+		m_pAllocArg = NULL;
+		m_pModuleState = NULL;
+		m_pThreadState = NULL;
 	}
 };
 
@@ -155,19 +240,32 @@ typedef struct Module_st Trigger_t;
 typedef struct Module_st StaticModule_t;
 typedef struct LineTrigger_st LineTrigger_t;
 typedef struct LineModule_st LineModule_t;
+typedef struct LineEdge_st LineEdge_t;
+typedef struct LineEquGroup_st LineEquGroup_t;
 typedef struct LineStaticModule_st LineStaticModule_t;
 typedef struct Line_st Line_t;
+typedef struct FlowGeneration_st FlowGeneration_t;
 typedef struct ArgValue_st ArgValue_t;
+typedef struct ModArgV2_st ModArgV2_t;
 typedef struct ModContext_st ModContext_t;
 typedef struct Runtime_st Runtime_t;
 typedef struct StaticRuntime_st StaticRuntime_t;
+typedef struct StaticArgVersion_st StaticArgVersion_t;
 typedef struct ConfigModule_st ConfigModule_t;
 typedef struct ConfigModule_st ConfigTrigger_t;
 typedef struct ConfigModule_st ConfigStaticModule_t;
 typedef struct ConfigMainLine_st ConfigMainLine_t;
 typedef struct RetValue_st RetValue_t;
+typedef struct ModEnv_st ModEnv_t;
+typedef struct Worker_st Worker_t;
 typedef void (*ArgFree)(void*);
 typedef int (*ModCallback)(jfr::LoggerSingleton* pLog, ArgValue_t** pInput, ArgValue_t** pOutput);
+typedef int (*ModCallbackEx)(jfr::LoggerSingleton* pLog, ArgValue_t** pInput, ArgValue_t** pOutput, ModEnv_t* pEnv);
+typedef int (*ModCallbackV2)(jfr::LoggerSingleton* pLog, const ModArgV2_t* const* pInput, ModArgV2_t** pOutput, ModEnv_t* pEnv);
+typedef int (*ModInit)(jfr::LoggerSingleton* pLog, void** ppState);
+typedef int (*ModThreadInit)(jfr::LoggerSingleton* pLog, void* pState, void** ppThreadState);
+typedef void (*ModThreadFini)(jfr::LoggerSingleton* pLog, void* pState, void* pThreadState);
+typedef void (*ModFini)(jfr::LoggerSingleton* pLog, void* pState);
 
 
 #ifndef MAIN_NAME
@@ -177,6 +275,10 @@ typedef int (*ModCallback)(jfr::LoggerSingleton* pLog, ArgValue_t** pInput, ArgV
 #define FLOW_NAME								MAIN_NAME"_flow"
 #endif // FLOW_NAME
 #define MODULE_JFR								MAIN_NAME
+/// 动态库模块接口版本，模块导出 extern "C" const int jfr_module_abi_version = 2; 时入口函数按ModCallbackV2调用，未导出时为v1接口
+#define JFR_MODULE_ABI_SYMBOL					"jfr_module_abi_version"
+#define JFR_MODULE_ABI_V1						1
+#define JFR_MODULE_ABI_V2						2
 
 
 CLOSE_NAMESPACE_JFR
@@ -29,6 +29,8 @@ using namespace rapidxml;
 #define JFR_DEFAULT_CONFIG_MAXRUNLINES				5
 #define JFR_DEFAULT_CONFIG_MAXTHREADSIZE			10
 #define JFR_DEFAULT_CONFIG_MAXJOBSIZE				20
+#define JFR_DEFAULT_CONFIG_SCHEDULERTHREADS			1
+#define JFR_DEFAULT_CONFIG_MAXREADYNUM				20
 #define JFR_DEFAULT_CONFIG_DEBUGLEVEL_MIN			0
 #define JFR_DEFAULT_CONFIG_DEBUGLEVEL_MAX			3
 #define JFR_DEFAULT_CONFIG_DEBUGLEVEL				JFR_DEFAULT_CONFIG_DEBUGLEVEL_MIN
@@ -50,6 +52,8 @@ public:
 	int SetMaxRunLines(const int max);
 	int SetMaxThreadSize(const int max);
 	int SetMaxJobSize(const int max);
+	int SetSchedulerThreads(const int num);
+	int SetMaxReadyNum(const int max);
 	int SetDebugLevel(const int level);
 	int SetDaemonFlag(const bool flag);
 	int SetLog2TermFlag(const bool flag);
@@ -62,6 +66,8 @@ public:
 	const int GetMaxRunLines(void) const;
 	const int GetMaxThreadSize(void) const;
 	const int GetMaxJobSize(void) const;
+	const int GetSchedulerThreads(void) const;
+	const int GetMaxReadyNum(void) const;
 	const int GetDebugLevel(void) const;
 	const bool GetDaemonFlag(void) const;
 	const bool GetLog2TermFlag(void) const;
@@ -83,6 +89,8 @@ private:
 	int							m_nMaxRunLines;
 	int 						m_nMaxThreadSize;
 	int							m_nMaxJobSize;
+	int							m_nSchedulerThreads;
+	int							m_nMaxReadyNum;
 	int							m_nDebugLevel;
 	bool						m_bDaemon;
 	bool						m_bCfgCheck;
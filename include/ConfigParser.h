@@ -17,6 +17,21 @@ using namespace rapidxml;
 OPEN_NAMESPACE_JFR
 
 
+#define JFR_DEFAULT_LINE_MAX_INFLIGHT		1		// 主线默认同时运行的实例数
+#define JFR_DEFAULT_LINE_PRIORITY			0		// 主线默认优先级
+#define JFR_DEFAULT_LINE_WEIGHT				1		// 主线默认权重
+#define JFR_DEFAULT_LINE_PREWARM			0		// 主线默认预先创建的运行时个数
+#define JFR_DEFAULT_MODULE_TIMEOUT			0		// 模块默认超时时间(毫秒)，0表示不限制
+#define JFR_DEFAULT_CACHE_TTL				0		// 模块结果缓存默认有效期(毫秒)，0表示不过期
+#define JFR_DEFAULT_CACHE_MAX_BYTES			1048576	// 模块结果缓存默认占用上限(字节)
+#define JFR_DEFAULT_WORKERS					1		// 常驻进程模块默认进程数
+#define JFR_DEFAULT_WORKER_MAX_REQUESTS		0		// 常驻进程默认处理请求数上限，0表示不限制
+#define JFR_DEFAULT_WORKER_MAX_REPLY_BYTES	67108864	// 常驻进程应答输出长度默认上限(字节)
+#define JFR_DEFAULT_TRANSPORT				"pipe"	// 进程模块默认出入参传递方式
+#define JFR_EQUIVALENT_POLICY_HEDGE			"hedge"			// 等效条件策略：先运行一个，超过延迟未完成再运行下一个
+#define JFR_EQUIVALENT_POLICY_FIRST_WINS	"first_wins"	// 等效条件策略：全部运行，一个满足要求后取消其余
+
+
 struct ConfigModule_st
 {
     string 				m_sName;				// 模块名称
@@ -28,12 +43,43 @@ struct ConfigModule_st
     string				m_sOutput;				// 出参
     vector< pair< string, RetValue_t > >	m_vRequirement;		// 必要条件
     vector< string >	m_vEquivalent;			// 等效条件
+    string				m_sEquPolicy;			// 等效条件策略，为空时等效模块各自运行
+    unsigned int		m_nEquDelay;			// hedge策略的延迟时间(毫秒)
+    bool				m_bStream;				// 主线模块从前驱进程模块的标准输出读取唯一入参
+    unsigned int		m_nTimeout;				// 超时时间(毫秒)
+    bool				m_bCache;				// 是否缓存模块结果
+    unsigned int		m_nCacheTtl;			// 结果有效期(毫秒)
+    unsigned int		m_nCacheMaxBytes;		// 缓存占用上限(字节)
+    unsigned int		m_nWorkers;				// 常驻进程模块的进程数
+    unsigned int		m_nMaxRequests;			// 常驻进程处理请求数上限，达到后重启，0表示不限制
+    unsigned int		m_nMaxReplyBytes;		// 常驻进程应答输出长度上限(字节)，超过时按应答格式错误处理
+    string				m_sTransport;			// 进程模块出入参传递方式，pipe或shm
+    unsigned int		m_nRefreshInterval;		// 静态模块刷新间隔(秒)，0表示只在启动时运行
+
+    ConfigModule_st(void)
+    {
+    	m_nEquDelay = 0;
+    	m_bStream = false;
+    	m_nTimeout = JFR_DEFAULT_MODULE_TIMEOUT;
+    	m_bCache = false;
+    	m_nCacheTtl = JFR_DEFAULT_CACHE_TTL;
+    	m_nCacheMaxBytes = JFR_DEFAULT_CACHE_MAX_BYTES;
+    	m_nWorkers = JFR_DEFAULT_WORKERS;
+    	m_nMaxRequests = JFR_DEFAULT_WORKER_MAX_REQUESTS;
+    	m_nMaxReplyBytes = JFR_DEFAULT_WORKER_MAX_REPLY_BYTES;
+    	m_sTransport = JFR_DEFAULT_TRANSPORT;
+    	m_nRefreshInterval = 0;
+    }
 };
 
 struct ConfigMainLine_st
 {
     string				m_sName;				// 主线名称
     string				m_sDesc;				// 描述
+    unsigned int		m_nMaxInflight;			// 同时运行的实例数
+    int					m_nPriority;			// 优先级
+    unsigned int		m_nWeight;				// 权重
+    unsigned int		m_nPrewarm;				// 预先创建的运行时个数
     ConfigTrigger_t		m_oTrigger;				// 触发器
     vector< ConfigModule_t >	m_vModules;		// 模块
 };
@@ -60,6 +106,10 @@ private:
 	int ParseTriggers(xml_node<>* pRoot);
 	int ParseStaticModules(xml_node<>* pRoot);
 	int ParseMainlines(xml_node<>* pRoot);
+	inline int ParseTimeout(xml_node<>* pNode, const char* sLable, unsigned int& nTimeout);
+	inline int ParseCache(xml_node<>* pNode, const char* sLable, ConfigModule_t& cfgModule);
+	inline int ParseWorker(xml_node<>* pNode, const char* sLable, ConfigModule_t& cfgModule);
+	inline int ParseTransport(xml_node<>* pNode, const char* sLable, ConfigModule_t& cfgModule);
 	int NameUniqCheck(void);
 	inline void FileExpand(const char* in, string& out);
 	inline bool IsInited(void);
@@ -0,0 +1,78 @@
+#ifndef JFR_EVENT_QUEUE_H
+#define JFR_EVENT_QUEUE_H
+
+
+#include <list>
+#include <vector>
+#include <boost/thread.hpp>
+#include <boost/thread/mutex.hpp>
+#include <boost/thread/condition.hpp>
+#include <boost/serialization/singleton.hpp>
+#include "Common.h"
+#include "Logger.h"
+
+
+OPEN_NAMESPACE_JFR
+
+using namespace std;
+
+
+/// 运行事件类型
+enum RuntimeEventType
+{
+	RTE_MODULE_FINISH = 1,		// 模块运行结束
+	RTE_TRIGGER_FINISH,			// 触发器运行结束
+	RTE_SLOT_FREE,				// 线程池有空位，事件不属于任何主线运行时
+	RTE_RELOAD,					// 配置已重新加载，切换到新的一代主线，事件不属于任何主线运行时
+	RTE_INVALID = 100			// 非法事件
+};
+
+/// 运行事件结构
+struct RuntimeEvent_st
+{
+	Runtime_t*						m_pRuntime;		// 事件所属主线运行时
+	ModContext_t*					m_pCtx;			// 产生事件的模块运行上下文
+	unsigned int 					m_nType;		// 事件类型
+};
+typedef struct RuntimeEvent_st RuntimeEvent_t;
+
+/// 单个调度线程的事件队列
+struct EventShard_st
+{
+	EventShard_st(void) : m_bStarved(false) {}
+	list< RuntimeEvent_t >			m_lEvents;		// 待处理事件
+	bool							m_bStarved;		// 有任务等待线程池空位
+	boost::mutex					m_oMutex;
+	boost::condition				m_oCond;
+};
+typedef struct EventShard_st EventShard_t;
+
+/// 运行事件队列
+// 模块、触发器运行结束后由线程池投递事件，调度线程阻塞等待事件
+// 调度线程只重新计算产生事件的主线运行时，不再定时轮询全部主线
+// 每个调度线程一个队列，事件投递到主线所属调度线程的队列
+class EventQueue : public boost::serialization::singleton< EventQueue >
+{
+public:
+	int Init(size_t shards);
+	int Post(size_t shard, Runtime_t* pRuntime, ModContext_t* pCtx, unsigned int type);
+	size_t Wait(size_t shard, list< RuntimeEvent_t >& lEvents, unsigned int timeout);
+	void Starve(size_t shard);
+	void WakeStarved(size_t except);
+
+protected:
+	EventQueue(void);
+	~EventQueue(void);
+
+private:
+	inline void Clear(void);
+
+private:
+	vector< EventShard_t* >			m_vShards;		// 调度线程编号 -> 事件队列
+};
+
+
+CLOSE_NAMESPACE_JFR
+
+
+#endif // JFR_EVENT_QUEUE_H
@@ -0,0 +1,288 @@
+#ifndef JFR_FAIR_QUEUE_H
+#define JFR_FAIR_QUEUE_H
+
+
+#include <list>
+#include <vector>
+#include <algorithm>
+#include "Common.h"
+
+
+OPEN_NAMESPACE_JFR
+
+using namespace std;
+
+
+/// 公平队列
+// 每个流(主线)一个FIFO队列，不同优先级之间严格按优先级出队，数值越大优先级越高
+// 同一优先级内按权重加权公平出队(自计时公平排队，SCFQ)：
+// 元素入队时计算虚拟结束时间 F = max(V, 本流上一个元素的F) + 1 / weight，V为该优先级最近出队元素的F
+// 出队时取同一优先级各流队首中F最小的元素，权重越大的流出队越频繁，空闲的流不积累额度
+// 不支持多线程
+template < typename T >
+class FairQueue
+{
+public:
+	FairQueue(void)
+	{
+		m_nSize = 0;
+		m_nFront = 0;
+		m_bFront = false;
+	}
+
+	/// 增加一个流，返回流编号；weight为0时按1处理
+	size_t AddFlow(int priority, unsigned int weight)
+	{
+		size_t level;
+		FairFlow_t flow;
+
+		level = Level(priority);
+		flow.m_nLevel = level;
+		flow.m_fCost = 1.0 / (weight ? weight : 1);
+		flow.m_fFinish = 0;
+		m_vLevels[level].m_vFlows.push_back(m_vFlows.size());
+		m_vFlows.push_back(flow);
+		m_bFront = false;
+
+		return m_vFlows.size() - 1;
+	}
+
+	/// 修改已有流的优先级和权重，流中的元素随流移到新的优先级，已计算的虚拟结束时间不变
+	void SetFlow(size_t flow, int priority, unsigned int weight)
+	{
+		size_t level;
+		vector< size_t >::iterator v_iter;
+
+		assert(flow < m_vFlows.size());
+		m_vFlows[flow].m_fCost = 1.0 / (weight ? weight : 1);
+		if (m_vLevels[m_vFlows[flow].m_nLevel].m_nPriority == priority)
+		{
+			return;
+		}
+		level = Level(priority);		// 可能插入新的优先级，之后再取流的当前优先级
+		FairFlow_t& oFlow = m_vFlows[flow];
+		FairLevel_t& oOld = m_vLevels[oFlow.m_nLevel];
+		v_iter = find(oOld.m_vFlows.begin(), oOld.m_vFlows.end(), flow);
+		assert(v_iter != oOld.m_vFlows.end());
+		oOld.m_vFlows.erase(v_iter);
+		oOld.m_nSize -= oFlow.m_lItems.size();
+		oFlow.m_nLevel = level;
+		m_vLevels[level].m_vFlows.push_back(flow);
+		m_vLevels[level].m_nSize += oFlow.m_lItems.size();
+		m_bFront = false;
+	}
+
+	void Push(size_t flow, const T& item)
+	{
+		FairItem_t oItem;
+
+		assert(flow < m_vFlows.size());
+		FairFlow_t& oFlow = m_vFlows[flow];
+		FairLevel_t& oLevel = m_vLevels[oFlow.m_nLevel];
+		oFlow.m_fFinish = (oFlow.m_fFinish > oLevel.m_fVirtual ? oFlow.m_fFinish : oLevel.m_fVirtual) + oFlow.m_fCost;
+		oItem.m_oItem = item;
+		oItem.m_fFinish = oFlow.m_fFinish;
+		oFlow.m_lItems.push_back(oItem);
+		++oLevel.m_nSize;
+		++m_nSize;
+		m_bFront = false;
+	}
+
+	/// 返回下一个出队的元素，队列为空时返回NULL
+	T* Front(void)
+	{
+		if (!m_bFront && !Locate())
+		{
+			return NULL;
+		}
+
+		return &m_vFlows[m_nFront].m_lItems.front().m_oItem;
+	}
+
+	/// 移除Front返回的元素
+	void Pop(void)
+	{
+		if (!m_bFront && !Locate())
+		{
+			return;
+		}
+		FairFlow_t& oFlow = m_vFlows[m_nFront];
+		FairLevel_t& oLevel = m_vLevels[oFlow.m_nLevel];
+		oLevel.m_fVirtual = oFlow.m_lItems.front().m_fFinish;
+		oFlow.m_lItems.pop_front();
+		--oLevel.m_nSize;
+		--m_nSize;
+		m_bFront = false;
+	}
+
+	/// 移除满足条件的元素，返回移除的个数
+	template < typename Pred >
+	size_t RemoveIf(Pred pred)
+	{
+		size_t count = 0;
+		typename list< FairItem_t >::iterator l_iter;
+
+		for (size_t i = 0; i < m_vFlows.size(); ++i)
+		{
+			FairFlow_t& oFlow = m_vFlows[i];
+			l_iter = oFlow.m_lItems.begin();
+			while (l_iter != oFlow.m_lItems.end())
+			{
+				if (pred(l_iter->m_oItem))
+				{
+					l_iter = oFlow.m_lItems.erase(l_iter);
+					--m_vLevels[oFlow.m_nLevel].m_nSize;
+					--m_nSize;
+					++count;
+				}
+				else
+				{
+					++l_iter;
+				}
+			}
+		}
+		if (count)
+		{
+			m_bFront = false;
+		}
+
+		return count;
+	}
+
+	size_t Size(void) const
+	{
+		return m_nSize;
+	}
+
+	bool Empty(void) const
+	{
+		return m_nSize == 0;
+	}
+
+	/// 清除元素，保留流
+	void Clear(void)
+	{
+		for (size_t i = 0; i < m_vFlows.size(); ++i)
+		{
+			m_vFlows[i].m_lItems.clear();
+			m_vFlows[i].m_fFinish = 0;
+		}
+		for (size_t i = 0; i < m_vLevels.size(); ++i)
+		{
+			m_vLevels[i].m_fVirtual = 0;
+			m_vLevels[i].m_nSize = 0;
+		}
+		m_nSize = 0;
+		m_bFront = false;
+	}
+
+	/// 清除元素和流
+	void Reset(void)
+	{
+		m_vFlows.clear();
+		m_vLevels.clear();
+		m_nSize = 0;
+		m_bFront = false;
+	}
+
+private:
+	/// 返回优先级的编号，不存在时按从高到低的顺序插入
+	size_t Level(int priority)
+	{
+		size_t level;
+
+		for (level = 0; level < m_vLevels.size(); ++level)
+		{
+			if (m_vLevels[level].m_nPriority <= priority)
+			{
+				break;
+			}
+		}
+		if (level == m_vLevels.size() || m_vLevels[level].m_nPriority != priority)
+		{
+			FairLevel_t oLevel;
+			oLevel.m_nPriority = priority;
+			oLevel.m_fVirtual = 0;
+			oLevel.m_nSize = 0;
+			m_vLevels.insert(m_vLevels.begin() + level, oLevel);
+			for (size_t i = 0; i < m_vFlows.size(); ++i)
+			{
+				if (m_vFlows[i].m_nLevel >= level)
+				{
+					++m_vFlows[i].m_nLevel;
+				}
+			}
+		}
+
+		return level;
+	}
+
+	/// 查找下一个出队元素所在的流
+	bool Locate(void)
+	{
+		for (size_t level = 0; level < m_vLevels.size(); ++level)
+		{
+			const FairLevel_t& oLevel = m_vLevels[level];
+			if (oLevel.m_nSize == 0)
+			{
+				continue;
+			}
+			m_bFront = false;
+			for (size_t i = 0; i < oLevel.m_vFlows.size(); ++i)
+			{
+				const FairFlow_t& oFlow = m_vFlows[oLevel.m_vFlows[i]];
+				if (oFlow.m_lItems.empty())
+				{
+					continue;
+				}
+				if (!m_bFront || oFlow.m_lItems.front().m_fFinish < m_vFlows[m_nFront].m_lItems.front().m_fFinish)
+				{
+					m_nFront = oLevel.m_vFlows[i];
+					m_bFront = true;
+				}
+			}
+			assert(m_bFront);
+			return true;
+		}
+
+		return false;
+	}
+
+private:
+	struct FairItem_st
+	{
+		T							m_oItem;
+		double						m_fFinish;			// 虚拟结束时间
+	};
+	typedef struct FairItem_st FairItem_t;
+
+	struct FairFlow_st
+	{
+		list< FairItem_t >			m_lItems;
+		size_t						m_nLevel;			// 所属优先级编号
+		double						m_fCost;			// 每个元素消耗的虚拟时间，1 / weight
+		double						m_fFinish;			// 最后入队元素的虚拟结束时间
+	};
+	typedef struct FairFlow_st FairFlow_t;
+
+	struct FairLevel_st
+	{
+		int							m_nPriority;
+		double						m_fVirtual;			// 虚拟时间
+		size_t						m_nSize;			// 本优先级元素个数
+		vector< size_t >			m_vFlows;			// 本优先级的流编号
+	};
+	typedef struct FairLevel_st FairLevel_t;
+
+	vector< FairFlow_t >			m_vFlows;
+	vector< FairLevel_t >			m_vLevels;			// 按优先级从高到低排列
+	size_t							m_nSize;
+	size_t							m_nFront;			// 下一个出队元素所在的流
+	bool							m_bFront;			// m_nFront是否有效
+};
+
+
+CLOSE_NAMESPACE_JFR
+
+
+#endif // JFR_FAIR_QUEUE_H
@@ -5,6 +5,8 @@
 #include <string>
 #include <map>
 #include <vector>
+#include <algorithm>
+#include <boost/shared_ptr.hpp>
 #include <boost/serialization/singleton.hpp>
 #include "Common.h"
 #include "ModuleManager.h"
@@ -23,6 +25,8 @@ struct LineTrigger_st
     Trigger_t*				m_pTrigger;			// 触发器指针
     vector< ModArg_t* >		m_vInputArgs;		// 入参
     vector< ModArg_t* >		m_vOutputArgs;		// 出参
+    vector< size_t >		m_vInputIndexes;	// 入参在主线参数表中的下标
+    vector< size_t >		m_vOutputIndexes;	// 出参在主线参数表中的下标
 
     LineTrigger_st(void)
     {
@@ -37,21 +41,67 @@ struct LineTrigger_st
         m_pTrigger = NULL;
         m_vInputArgs.clear();
         m_vOutputArgs.clear();
+        m_vInputIndexes.clear();
+        m_vOutputIndexes.clear();
     }
 };
 
+#define JFR_LINE_NO_GROUP			((size_t)-1)		// 模块不属于任何有策略的等效组
+
+
+/// 等效条件策略
+enum EquPolicy
+{
+	EP_NONE = 0,		// 等效模块各自运行
+	EP_HEDGE,			// 先运行一个，超过延迟未完成或失败时再运行下一个，一个满足要求后取消其余
+	EP_FIRST_WINS		// 全部运行，一个满足要求后取消其余
+};
+
+/// 主线依赖边，由前置模块指向后继模块的一个必要条件集合
+struct LineEdge_st
+{
+    size_t									m_nModule;				// 后继模块编号
+    size_t									m_nSlot;				// 后继模块的必要条件集合编号(主线内)
+    RetValue_t								m_oRetValue;			// 后继模块要求的返回值
+};
+
+/// 有策略的等效组
+struct LineEquGroup_st
+{
+    vector< size_t >						m_vMembers;				// 组内模块编号，hedge策略按此顺序运行
+    unsigned int							m_nPolicy;				// 等效条件策略
+    unsigned int							m_nDelay;				// hedge策略的延迟时间(毫秒)
+};
+
 /// 主线模块结构
 struct LineModule_st
 {
     Module_t*								m_pModule;				// 模块指针
     vector< ModArg_t* >						m_vInputArgs;			// 入参
     vector< ModArg_t* >						m_vOutputArgs;			// 出参
+    vector< size_t >						m_vInputIndexes;		// 入参在主线(静态模块)参数表中的下标
+    vector< size_t >						m_vOutputIndexes;		// 出参在主线(静态模块)参数表中的下标
     vector< pair< Module_t*, RetValue_t > >	m_vRequirement;			// 必要条件
     vector< Module_t* >						m_vEquivalent;			// 等效条件
+    size_t									m_nIndex;				// 主线内模块编号
+    size_t									m_nSlotNum;				// 必要条件集合个数，等效条件为一个集合
+    vector< LineEdge_t >					m_vSuccessors;			// 后继模块
+    unsigned int							m_nEquPolicy;			// 配置的等效条件策略
+    unsigned int							m_nEquDelay;			// 配置的hedge延迟时间(毫秒)
+    size_t									m_nGroup;				// 所属等效组编号，JFR_LINE_NO_GROUP表示无
+    bool									m_bStream;				// 配置stream='true'，唯一入参来自前驱模块的标准输出，由前驱模块同时启动
+    LineModule_st*							m_pStreamTo;			// 以流方式连接的后继模块，NULL表示无
 
     LineModule_st(void)
     {
     	m_pModule = NULL;
+    	m_nIndex = 0;
+    	m_nSlotNum = 0;
+    	m_nEquPolicy = EP_NONE;
+    	m_nEquDelay = 0;
+    	m_nGroup = JFR_LINE_NO_GROUP;
+    	m_bStream = false;
+    	m_pStreamTo = NULL;
     }
     ~LineModule_st(void)
     {
@@ -62,8 +112,18 @@ struct LineModule_st
     	m_pModule = NULL;
     	m_vInputArgs.clear();
     	m_vOutputArgs.clear();
+    	m_vInputIndexes.clear();
+    	m_vOutputIndexes.clear();
     	m_vRequirement.clear();
     	m_vEquivalent.clear();
+    	m_nIndex = 0;
+    	m_nSlotNum = 0;
+    	m_vSuccessors.clear();
+    	m_nEquPolicy = EP_NONE;
+    	m_nEquDelay = 0;
+    	m_nGroup = JFR_LINE_NO_GROUP;
+    	m_bStream = false;
+    	m_pStreamTo = NULL;
     }
 };
 
@@ -72,11 +132,13 @@ struct LineStaticModule_st
 {
 	string 						m_sName;				// 静态模块名称
 	LineModule_t 				m_oModule;				// 结构
-	vector< ModArg_t* >			m_vArgs;				// 所有参数
+	vector< ModArg_t* >			m_vArgs;				// 所有参数，下标即参数表下标
+	unsigned int				m_nRefreshInterval;		// 刷新间隔(秒)，0表示只在启动时运行
 
 	LineStaticModule_st(void)
 	{
 		m_sName = "";
+		m_nRefreshInterval = 0;
 	}
 	~LineStaticModule_st(void)
 	{
@@ -85,6 +147,7 @@ struct LineStaticModule_st
 	void Clear(void)
 	{
 		m_sName = "";
+		m_nRefreshInterval = 0;
 		m_oModule.Clear();
 		for (size_t i = 0; i < m_vArgs.size(); ++i)
 		{
@@ -99,19 +162,37 @@ struct Line_st
 {
     string						m_sName;				// 主线名称
     string						m_sDesc;				// 描述
+    unsigned int				m_nMaxInflight;			// 同时运行的实例数
+    int							m_nPriority;			// 优先级，数值越大越优先
+    unsigned int				m_nWeight;				// 同一优先级内的调度权重
+    unsigned int				m_nPrewarm;				// 启动时预先创建的运行时个数
+    size_t						m_nShard;				// 所属调度线程编号
+    size_t						m_nFlow;				// 所属调度线程内的公平队列流编号
     LineTrigger_t				m_oTrigger;				// 触发器
     vector< LineModule_t* >		m_vModules;				// 模块
     LineModule_t*				m_pEnd;					// 结束条件
-    vector< ModArg_t* >			m_vArgs;				// 所有参数
+    vector< ModArg_t* >			m_vArgs;				// 所有参数，下标即参数表下标
+    vector< ModArg_t* >			m_vStaticArgs;			// 引用的静态模块参数，参数表下标接在m_vArgs之后，不属于主线
 	map< int, vector< LineModule_t* > >	m_mapModIds;	// mod id -> mods 为所有mod编号，等效条件使用一个编号
 	map< LineModule_t*, int >			m_mapModPtr;	// mod ptr -> mod id
+	vector< LineEdge_t >		m_vTriggerSuccessors;	// 触发器的后继模块
+	vector< size_t >			m_vSlotSizes;			// 各必要条件集合的模块个数
+	vector< LineEquGroup_t >	m_vEquGroups;			// 有策略的等效组
+	ModuleStats*				m_pStats;				// 主线内模块和触发器调用的资源统计
 
 	Line_st(void)
 	{
 		m_sName = "";
 		m_sDesc = "";
+		m_nMaxInflight = 1;
+		m_nPriority = 0;
+		m_nWeight = 1;
+		m_nPrewarm = 0;
+		m_nShard = 0;
+		m_nFlow = 0;
 		m_oTrigger.Clear();
 		m_pEnd = NULL;
+		m_pStats = NULL;
 	}
 
 	~Line_st(void)
@@ -123,10 +204,20 @@ struct Line_st
 	{
         m_sName = "";
         m_sDesc = "";
+        m_nMaxInflight = 1;
+        m_nPriority = 0;
+        m_nWeight = 1;
+        m_nPrewarm = 0;
+        m_nShard = 0;
+        m_nFlow = 0;
         m_oTrigger.Clear();
         m_pEnd = NULL;
         m_mapModIds.clear();
         m_mapModPtr.clear();
+        m_vTriggerSuccessors.clear();
+        m_vSlotSizes.clear();
+        m_vEquGroups.clear();
+        m_vStaticArgs.clear();
         for (size_t i = 0; i < m_vModules.size(); ++i)
 		{
 			delete m_vModules[i];
@@ -137,8 +228,29 @@ struct Line_st
 			delete m_vArgs[i];
 		}
 		m_vArgs.clear();
+		delete m_pStats;
+		m_pStats = NULL;
+	}
+};
+
+
+/// 流程配置代
+// 每次加载配置生成新的一代，新的主线实例使用最新的一代，已运行的实例在所属的一代上运行至结束
+// 运行时使用期间持有所属的一代，最后一个持有者释放后，主线、静态模块随之释放，模块引用归还ModuleManager
+struct FlowGeneration_st
+{
+	size_t							m_nGeneration;			// 代编号，从1开始递增
+	vector< Line_t* >				m_vLines;				// 主线
+	vector< LineStaticModule_t* >	m_vStaticModules;		// 静态模块
+	vector< Module_t* >				m_vModules;				// 引用的模块
+
+	FlowGeneration_st(void)
+	{
+		m_nGeneration = 0;
 	}
+	~FlowGeneration_st(void);
 };
+typedef boost::shared_ptr< FlowGeneration_t > FlowGenerationPtr;
 
 
 class MainlineManager : public boost::serialization::singleton< MainlineManager >
@@ -147,6 +259,7 @@ public:
 	int Init(void);
 	int LoadMainlines(const vector< ConfigMainLine_t* >& vCfgMainLines);				// 主程序中后调用
 	int LoadStaticModules(const vector< ConfigStaticModule_t* >& vCfgStaticModules);	// 主程序中先调用
+	FlowGenerationPtr TakeGeneration(void);												// 加载完成后调用
 	const vector< Line_t* >& GetMainLines(void) const;
 	const vector< LineStaticModule_t* >& GetStaticModules(void) const;
 
@@ -161,6 +274,12 @@ private:
 	int LoadLineTrigger(const ConfigTrigger_t& cfgTrigger, Line_t* pLine);
 	int LoadLineModule(const ConfigModule_t& cfgModule, Line_t* pLine, LineModule_t* pMod);
 	int LoadLineModuleId(Line_t* pLine, LineModule_t* pMod, int* maxId);
+	int CompileLines(void);
+	int CompileLine(Line_t* pLine);
+	int CompileEquGroups(Line_t* pLine);
+	int CompileStreams(Line_t* pLine);
+	void CompileArgs(Line_t* pLine);
+	int CompileStaticArgs(void);
 	int ModuleLogicCheck(void);
 	int LoadModules(const vector< ConfigStaticModule_t* >& vCfgStaticModules);
 	inline bool IsInited(void);
@@ -175,6 +294,7 @@ private:
 	inline int LineLogicCheck_Rule11(void);
 	inline int CheckRequireSet(const Line_t* pLine, const LineModule_t* pModule, const map< Module_t*, LineModule_t* >& mapModules);
 	inline int ParseArgs(const string& strArgs, vector< ModArg_t* >& vAllArgs, vector< ModArg_t* >& vModArgs);
+	inline void IndexArgs(const vector< ModArg_t* >& vModArgs, map< ModArg_t*, size_t >& mapIndexes, vector< ModArg_t* >& vExternArgs, vector< size_t >& vIndexes);
 	inline ModArg_t* FindArg(const string& strArg, const vector< ModArg_t* >& vAllArgs);
 	inline int PushArg(const string& strArgs, vector< ModArg_t* >& vAllArgs, vector< ModArg_t* >& vModArgs, unsigned int type = AT_INVALID);
 	inline int TrimString(string& str);
@@ -183,6 +303,7 @@ private:
 private:
     vector< Line_t* >               m_vLines;           // 所有主线
     vector< LineStaticModule_t* >	m_vStaticModules;	// 静态模块
+    size_t							m_nGeneration;		// 最近一代的编号
     bool							m_bInited;
     ModuleManager*					m_pModule;
     jfr::LoggerSingleton*			m_pLogger;
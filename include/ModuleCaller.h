@@ -4,17 +4,26 @@
 
 #include <unistd.h>
 #include <errno.h>
+#include <fcntl.h>
+#include <spawn.h>
+#include <signal.h>
 #include <sys/types.h>
 #include <sys/wait.h>
+#include <sys/resource.h>
 #include <string>
 #include <map>
 #include <vector>
 #include <boost/thread.hpp>
 #include <boost/thread/mutex.hpp>
 #include <boost/thread/condition.hpp>
+#include <boost/thread/tss.hpp>
 #include <boost/serialization/singleton.hpp>
 #include "Common.h"
+#include "ShmSegment.h"
 #include "ThreadPool.h"
+#include "EventQueue.h"
+#include "Watchdog.h"
+#include "ProcessReactor.h"
 #include "RuntimeSet.h"
 #include "MainlineManager.h"
 #include "Logger.h"
@@ -26,29 +35,57 @@ OPEN_NAMESPACE_JFR
 using namespace std;
 
 
-#define JFR_CALLPRO_ERROR_STRING			"JFR_CALLPRO_ERROR_STRING"
-#define JFR_CALLPRO_ERROR_LEN				25
-#define JFR_CALLPRO_ERROR_NO				200
-
+/// 登记到ProcessReactor的进程模块调用，子进程结束后由反应器线程完成调用
+struct ProCall_st : public ProcWatch_st
+{
+	Module_t*						m_pModule;
+	ModContext_t*					m_pCtx;
+	const vector< size_t >*			m_pInput;
+	ArgValue_t*						m_pArgValOut;
+	ArgValue_t**					m_ppArgs;
+};
+typedef struct ProCall_st ProCall_t;
 
+/// 主线模块、触发器以非阻塞方式提交到线程池，Call返回1表示线程池已满，任务未提交
 class ModuleCaller
 {
 public:
 	static int Call(StaticRuntime_t* pRuntime);
 	static int Call(Runtime_t* pRuntime);
 	static int Call(Runtime_t* pRuntime, LineModule_t* pModule);
+	static pid_t Spawn(const string& sFileName, char** ppArgv, int fdIn, int fdOut, const int* pFds = NULL, size_t nFds = 0, pid_t nPgid = 0);
 
 private:
 	static int CallStaticModule(StaticRuntime_t* pRuntime);
 	static int CallModule(Runtime_t* pRuntime, LineModule_t* pModule);
 	static int CallTrigger(Runtime_t* pRuntime);
-	static int CallPro(Module_t* pMod, ModContext_t* pCtx, const vector< ModArg_t* >& vInput, const vector< ModArg_t* >& vOutput, map< ModArg_t*, ArgValue_t* >& mapArg);
-	static int CallSo(Module_t* pMod, ModContext_t* pCtx, const vector< ModArg_t* >& vInput, const vector< ModArg_t* >& vOutput, map< ModArg_t*, ArgValue_t* >& mapArg);
-	static char* Read(int fd);
-	static int Wait(pid_t pid);
+	/// 出入参为参数表ppArgs的下标，以指针传递，提交任务时不复制
+	static int CallPro(Module_t* pMod, ModContext_t* pCtx, const vector< size_t >* pInput, const vector< size_t >* pOutput, ArgValue_t** ppArgs);
+	static int CallStream(Runtime_t* pRuntime, LineModule_t* pModule);
+	static int CallProShm(Module_t* pMod, ModContext_t* pCtx, const vector< size_t >* pInput, const vector< size_t >* pOutput, ArgValue_t** ppArgs);
+	static int CallWorker(Module_t* pMod, ModContext_t* pCtx, const vector< size_t >* pInput, const vector< size_t >* pOutput, ArgValue_t** ppArgs);
+	static int CallSo(Module_t* pMod, ModContext_t* pCtx, const vector< size_t >* pInput, const vector< size_t >* pOutput, ArgValue_t** ppArgs);
+	static int CallSoV2(Module_t* pMod, ModContext_t* pCtx, const vector< size_t >* pInput, const vector< size_t >* pOutput, ArgValue_t** ppArgs);
+	static int CallCached(Module_t* pMod, ModContext_t* pCtx, const vector< size_t >* pInput, const vector< size_t >* pOutput, ArgValue_t** ppArgs);
+	static void CacheKey(const vector< size_t >& vInput, ArgValue_t** ppArgs, string& key);
+	static int FinishPro(Module_t* pMod, ModContext_t* pCtx, const vector< size_t >& vInput, ArgValue_t* pArgValOut, ArgValue_t** ppArgs, char* buf, size_t len, int ret);
+	static void ProDone(ProcWatch_t* pWatch);
+	static char* Read(int fd, Arena* pArena, size_t& nLength);
+	static int Wait(pid_t pid, ModContext_t* pCtx);
+	static void ClearPid(pid_t pid, ModContext_t* pCtx);
+	static inline void Begin(Module_t* pMod, ModContext_t* pCtx);
+	static inline unsigned int End(Module_t* pMod, ModContext_t* pCtx);
+	static void Record(Module_t* pMod, ModContext_t* pCtx);
+	static inline void Usage(const struct rusage& ru, ModUsage_t& usage);
+	static int Notify(Module_t* pMod, ModContext_t* pCtx);
+	static int ThreadState(Module_t* pMod, void*& pThreadState);
 
 private:
 	static ThreadPool* 						pool;
+	static EventQueue*						events;
+	static Watchdog*						watchdog;
+	static ProcessReactor*					reactor;
+	static boost::thread_specific_ptr< map< unsigned long, void* > >*	threadStates;	// 本线程的模块加载序号 -> 线程状态
 	static jfr::LoggerSingleton*			logger;
 };
 
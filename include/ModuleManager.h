@@ -4,19 +4,24 @@
 
 #include <unistd.h>
 #include <dlfcn.h>
+#include <sys/stat.h>
 #include <string>
 #include <map>
 #include <vector>
+#include <boost/thread/mutex.hpp>
 #include <boost/serialization/singleton.hpp>
 #include "Common.h"
 #include "ConfigParser.h"
+#include "ResultCache.h"
+#include "WorkerPool.h"
+#include "ModuleStats.h"
 #include "Logger.h"
 
 
 OPEN_NAMESPACE_JFR
 
 
-#define GET_MODULE_TYPE(type1, type2)	((type1) == "so" ? MT_SO | (type2) : MT_PRO | (type2))
+#define GET_MODULE_TYPE(type1, type2)	((type1) == "so" ? MT_SO | (type2) : (type1) == "worker" ? MT_WORKER | (type2) : MT_PRO | (type2))
 #define GET_MODULE_TYPE_MOD(type1)		GET_MODULE_TYPE(type1, MT_MODULE)
 #define GET_MODULE_TYPE_TRIG(type1)		GET_MODULE_TYPE(type1, MT_TRIGGER)
 #define GET_MODULE_TYPE_STATIC(type1)	GET_MODULE_TYPE(type1, MT_STATIC)
@@ -25,6 +30,12 @@ OPEN_NAMESPACE_JFR
 #define IS_STATIC(type)					(((type) & MT_STATIC) == MT_STATIC ? true : false)
 #define IS_SO(type)						(((type) & MT_SO) == MT_SO ? true : false)
 #define IS_PRO(type)					(((type) & MT_PRO) == MT_PRO ? true : false)
+#define IS_WORKER(type)					(((type) & MT_WORKER) == MT_WORKER ? true : false)
+#define JFR_MODULE_CALLBACK_EX_SUFFIX	"_ex"				// 动态库扩展回调函数名后缀
+#define JFR_MODULE_INIT_SUFFIX			"_init"				// 动态库加载后调用一次，生成模块状态
+#define JFR_MODULE_THREAD_INIT_SUFFIX	"_thread_init"		// 每个线程首次调用模块前调用，生成线程状态
+#define JFR_MODULE_THREAD_FINI_SUFFIX	"_thread_fini"		// 卸载模块时对每个线程状态调用
+#define JFR_MODULE_FINI_SUFFIX			"_fini"				// 卸载模块时最后调用，释放模块状态
 
 
 /// 模块类型 ored
@@ -34,7 +45,8 @@ enum ModuleType
 	MT_PRO 			= 			0x02,					// 进程
 	MT_MODULE 		= 			0x04,					// 模块
 	MT_TRIGGER 		= 			0x08,					// 触发器
-	MT_STATIC		=			0x10					// 静态模块
+	MT_STATIC		=			0x10,					// 静态模块
+	MT_WORKER		=			0x20					// 常驻进程，只用于普通模块
 };
 
 /// 模块结构
@@ -47,7 +59,24 @@ struct Module_st
     string 				m_sDesc;				// 描述
     void*				m_pHandle;				// 动态库handle
     ModCallback			m_pCallback;			// 动态库回调函数
+    ModCallbackEx		m_pCallbackEx;			// 动态库扩展回调函数<main>_ex，可选，存在时优先调用
+    ModCallbackV2		m_pCallbackV2;			// v2接口回调函数，与m_pCallback、m_pCallbackEx不同时存在
+    int					m_nAbi;					// 动态库模块接口版本
+    ModThreadInit		m_pThreadInit;			// 生命周期函数，均可选，见JFR_MODULE_INIT_SUFFIX
+    ModThreadFini		m_pThreadFini;
+    ModFini				m_pFini;
+    void*				m_pState;				// 模块状态
+    unsigned long		m_nSerial;				// 加载序号，各线程以此查找线程状态，不随模块地址复用
+    vector< void* >		m_vThreadStates;		// 已生成的线程状态，卸载时逐个释放
+    boost::mutex		m_oThreadMutex;			// 保护m_vThreadStates
 												// 进程调用方式：m_sFileName input1 input2 ...
+    unsigned int		m_nTimeout;				// 超时时间(毫秒)，0表示不限制
+    ResultCache*		m_pCache;				// 结果缓存，未开启时为NULL，只用于进程模块和常驻进程模块
+    WorkerPool*			m_pWorkers;				// 常驻进程池，只用于常驻进程模块
+    bool				m_bShm;					// 以共享内存传递出入参，只用于进程模块，见ShmSegment
+    ModuleStats*		m_pStats;				// 调用资源统计，复用模块时保留
+    string				m_sSignature;			// 模块配置和文件标识，重新加载配置时相同则复用模块
+    unsigned int		m_nRef;					// 引用计数，ModuleManager和使用模块的流程配置代各持有一个
 
 	Module_st(void)
 	{
@@ -58,6 +87,27 @@ struct Module_st
 		m_sDesc = "";
 		m_pHandle = NULL;
 		m_pCallback = NULL;
+		m_pCallbackEx = NULL;
+		m_pCallbackV2 = NULL;
+		m_nAbi = JFR_MODULE_ABI_V1;
+		m_pThreadInit = NULL;
+		m_pThreadFini = NULL;
+		m_pFini = NULL;
+		m_pState = NULL;
+		m_nSerial = 0;
+		m_nTimeout = 0;
+		m_pCache = NULL;
+		m_pWorkers = NULL;
+		m_bShm = false;
+		m_pStats = NULL;
+		m_sSignature = "";
+		m_nRef = 0;
+	}
+	~Module_st(void)
+	{
+		delete m_pCache;
+		delete m_pWorkers;
+		delete m_pStats;
 	}
 };
 
@@ -72,6 +122,10 @@ public:
 	const Module_t* GetModule(const string& name) const;
 	const Trigger_t* GetTrigger(const string& name) const;
 	const StaticModule_t* GetStaticModule(const string& name) const;
+	void RetainAll(vector< Module_t* >& vModules);
+	void Release(Module_t* pMod);
+	void Commit(void);
+	void Rollback(void);
 
 protected:
 	ModuleManager(void);
@@ -86,12 +140,26 @@ private:
 					const vector< ConfigStaticModule_t* >& vCfgStaticModules);
 	inline bool IsInited(void);
 	inline void Clear(void);
+	inline void ClearPrevious(void);
+	inline void RestorePrevious(void);
+	inline Module_t* Reuse(const ConfigModule_t& cfgModule, unsigned int nType);
+	inline void Signature(const ConfigModule_t& cfgModule, unsigned int nType, string& sSignature);
+	inline int LoadCallback(Module_t* pMod, void* pMain);
+	inline int LoadHooks(Module_t* pMod);
+	inline void Finalize(Module_t* pMod);
 
 private:
 	map< string, Module_t* > 					m_mapAllModule;			// 所有模块map
 	map< string, Module_t* > 					m_mapModule;			// 普通模块map
 	map< string, Trigger_t* > 					m_mapTrigger;			// 触发器模块map
 	map< string, StaticModule_t* > 				m_mapStaticModule;		// 静态模块map
+	map< string, Module_t* >					m_mapPrevious;			// 重新加载时上一次加载的模块，未改变的模块直接复用
+	map< string, Module_t* >					m_mapPrevModule;		// 上一次加载的普通模块，重新加载失败时恢复
+	map< string, Trigger_t* >					m_mapPrevTrigger;		// 上一次加载的触发器模块
+	map< string, StaticModule_t* >				m_mapPrevStaticModule;	// 上一次加载的静态模块
+	bool										m_bPrevious;			// 是否保留着上一次加载的模块，等待Commit或Rollback
+	boost::mutex								m_oMutex;				// 保护模块引用计数
+	unsigned long								m_nSerial;				// 最近分配的动态库模块加载序号
 	bool										m_bInited;
 	jfr::LoggerSingleton*						m_pLogger;
 };
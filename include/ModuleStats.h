@@ -0,0 +1,78 @@
+#ifndef JFR_MODULE_STATS_H
+#define JFR_MODULE_STATS_H
+
+
+#include <time.h>
+#include <stdint.h>
+#include <sys/time.h>
+#include <string>
+#include <boost/thread.hpp>
+#include <boost/thread/mutex.hpp>
+#include "Common.h"
+#include "Logger.h"
+
+
+OPEN_NAMESPACE_JFR
+
+using namespace std;
+
+
+#define JFR_MODULE_STATS_REPORT_INTERVAL	60000		// 资源统计输出间隔(毫秒)
+
+
+/// 一次模块调用的资源占用
+struct ModUsage_st
+{
+	uint64_t					m_nQueueUs;			// 提交到线程池至开始运行(微秒)，同步调用为0
+	uint64_t					m_nWallUs;			// 开始运行至结束(微秒)
+	uint64_t					m_nUserUs;			// 用户态CPU时间(微秒)
+	uint64_t					m_nSysUs;			// 内核态CPU时间(微秒)
+	long						m_nMaxRss;			// 最大常驻内存(KB)，无法单独统计时为0
+
+	void Clear(void)
+	{
+		m_nQueueUs = 0;
+		m_nWallUs = 0;
+		m_nUserUs = 0;
+		m_nSysUs = 0;
+		m_nMaxRss = 0;
+	}
+};
+typedef struct ModUsage_st ModUsage_t;
+
+/// 模块、主线的调用资源统计
+// 进程模块的CPU时间和最大常驻内存来自wait4回收子进程时的rusage，动态库模块的CPU时间来自回调前后本线程的rusage，
+// 常驻进程模块多次调用共用进程，只统计排队和运行时间；按间隔和释放时以INFO级别输出，多个线程共享，加锁访问
+class ModuleStats
+{
+public:
+	ModuleStats(const string& kind, const string& name);
+	~ModuleStats(void);
+	static uint64_t Now(void);
+	static uint64_t Micros(const struct timeval& tv) { return (uint64_t)tv.tv_sec * 1000000 + tv.tv_usec; }
+	void Record(const ModUsage_t& usage);
+	void Report(void);
+
+private:
+	inline void TryReport(void);
+	inline void LogStats(void);
+
+private:
+	string							m_sKind;			// module、line
+	string							m_sName;
+	unsigned long					m_nCalls;
+	uint64_t						m_nQueueUs;
+	uint64_t						m_nWallUs;
+	uint64_t						m_nUserUs;
+	uint64_t						m_nSysUs;
+	long							m_nMaxRss;
+	boost::system_time				m_oReport;			// 上次输出统计的时间点
+	boost::mutex					m_oMutex;
+	jfr::LoggerSingleton*			m_pLogger;
+};
+
+
+CLOSE_NAMESPACE_JFR
+
+
+#endif // JFR_MODULE_STATS_H
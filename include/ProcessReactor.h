@@ -0,0 +1,97 @@
+#ifndef JFR_PROCESS_REACTOR_H
+#define JFR_PROCESS_REACTOR_H
+
+
+#include <unistd.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <sys/types.h>
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <sys/syscall.h>
+#include <map>
+#include <boost/thread.hpp>
+#include <boost/thread/mutex.hpp>
+#include <boost/serialization/singleton.hpp>
+#include "Common.h"
+#include "Arena.h"
+#include "Logger.h"
+
+
+OPEN_NAMESPACE_JFR
+
+using namespace std;
+
+
+#define JFR_REACTOR_MAX_EVENTS		64				// 每次epoll_wait处理的事件数上限
+
+
+/// 子进程监控项
+// 输出读完且子进程退出后，在反应器线程中调用m_pDone，此时两个描述符已关闭，子进程尚未回收；回调函数负责回收子进程并释放监控项
+struct ProcWatch_st
+{
+	pid_t						m_nPid;				// 子进程号
+	int							m_nPidFd;			// pidfd，可读表示子进程已退出
+	int							m_nFd;				// 子进程标准输出的读端，非阻塞
+	Arena*						m_pArena;			// 输出从所属运行时的内存区分配
+	char*						m_pBuf;				// 输出，以'\0'结尾；读取出错时为NULL
+	size_t						m_nCap;
+	size_t						m_nLength;			// 输出长度
+	bool						m_bEof;
+	bool						m_bExited;
+	void						(*m_pDone)(ProcWatch_st* pWatch);
+
+	ProcWatch_st(void)
+	{
+		m_nPid = 0;
+		m_nPidFd = -1;
+		m_nFd = -1;
+		m_pArena = NULL;
+		m_pBuf = NULL;
+		m_nCap = 0;
+		m_nLength = 0;
+		m_bEof = false;
+		m_bExited = false;
+		m_pDone = NULL;
+	}
+	virtual ~ProcWatch_st(void)
+	{
+	}
+};
+typedef struct ProcWatch_st ProcWatch_t;
+
+/// 进程模块的子进程监控
+// 线程池线程启动子进程后登记到反应器即返回，由反应器线程以epoll读取子进程输出、以pidfd等待子进程退出，
+// 同时运行的子进程数不再受线程池大小限制；内核不支持pidfd时Add之前OpenPidFd失败，调用者同步等待
+class ProcessReactor : public boost::serialization::singleton< ProcessReactor >
+{
+public:
+	int Start(void);
+	void Stop(void);
+	int Add(ProcWatch_t* pWatch);
+	static int OpenPidFd(pid_t pid);
+
+protected:
+	ProcessReactor(void);
+	~ProcessReactor(void);
+
+private:
+	void Run(void);
+	inline void OnOutput(ProcWatch_t* pWatch);
+	inline void Remove(int fd);
+
+private:
+	int								m_nEpoll;
+	int								m_nWake;			// eventfd，Stop时唤醒反应器线程
+	map< int, ProcWatch_t* >		m_mapFds;			// 描述符 -> 监控项，登记在调用线程，删除在反应器线程
+	boost::thread*					m_pThread;
+	bool							m_bStop;
+	boost::mutex					m_oMutex;
+	jfr::LoggerSingleton*			m_pLogger;
+};
+
+
+CLOSE_NAMESPACE_JFR
+
+
+#endif // JFR_PROCESS_REACTOR_H
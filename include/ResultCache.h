@@ -0,0 +1,74 @@
+#ifndef JFR_RESULT_CACHE_H
+#define JFR_RESULT_CACHE_H
+
+
+#include <string>
+#include <list>
+#include <boost/unordered_map.hpp>
+#include <boost/thread.hpp>
+#include <boost/thread/mutex.hpp>
+#include "Common.h"
+#include "Arena.h"
+#include "Logger.h"
+
+
+OPEN_NAMESPACE_JFR
+
+using namespace std;
+
+
+#define JFR_RESULT_CACHE_REPORT_INTERVAL	60000		// 缓存统计输出间隔(毫秒)
+
+
+/// 模块结果缓存
+// 以入参内容为键，缓存模块的返回值和出参，按LRU淘汰，占用超过上限时淘汰最久未使用的结果
+// 只用于进程模块，入参和出参按长度保存字节内容，可含'\0'；动态库模块的参数为不透明指针，无法比较和复制
+// 多个调度线程共享，加锁访问
+class ResultCache
+{
+public:
+	ResultCache(const string& name, unsigned int ttl, size_t maxBytes);
+	~ResultCache(void);
+	static void AppendKey(string& key, const char* value, size_t len);
+	bool Lookup(const string& key, int& nRetValue, char*& pOutput, size_t& nLength, unsigned int& nType, Arena* pArena);
+	void Store(const string& key, int nRetValue, const char* pOutput, size_t nLength, unsigned int nType);
+	void Report(void);
+
+private:
+	struct CacheEntry_st
+	{
+		string						m_sKey;
+		string						m_sOutput;
+		bool						m_bOutput;			// 是否有出参，进程无输出时出参为NULL
+		unsigned int				m_nType;			// 出参类型ArgValueType
+		int							m_nRetValue;
+		boost::system_time			m_oExpire;			// 过期时间点，ttl为0时不过期
+		size_t						m_nBytes;			// 占用字节数
+	};
+	typedef struct CacheEntry_st CacheEntry_t;
+	typedef list< CacheEntry_t >::iterator EntryIter;
+
+	inline void Evict(EntryIter iter);
+	inline void TryReport(void);
+	inline void LogStats(void);
+
+private:
+	string							m_sName;			// 模块名称
+	unsigned int					m_nTtl;				// 结果有效期(毫秒)，0表示不过期
+	size_t							m_nMaxBytes;		// 占用上限(字节)
+	size_t							m_nBytes;			// 当前占用(字节)
+	list< CacheEntry_t >			m_lEntries;			// 按使用时间排列，表头为最近使用
+	boost::unordered_map< string, EntryIter >	m_mapIndex;		// 入参 -> 缓存项
+	unsigned long					m_nHits;
+	unsigned long					m_nMisses;
+	unsigned long					m_nEvictions;
+	boost::system_time				m_oReport;			// 上次输出统计的时间点
+	boost::mutex					m_oMutex;
+	jfr::LoggerSingleton*			m_pLogger;
+};
+
+
+CLOSE_NAMESPACE_JFR
+
+
+#endif // JFR_RESULT_CACHE_H
@@ -5,13 +5,20 @@
 #include <string>
 #include <map>
 #include <vector>
+#include <signal.h>
 #include <boost/thread.hpp>
 #include <boost/thread/mutex.hpp>
 #include <boost/thread/condition.hpp>
 #include <boost/serialization/singleton.hpp>
 #include "Common.h"
+#include "ConfigParser.h"
+#include "ModuleManager.h"
+#include "MainlineManager.h"
 #include "RuntimeSet.h"
 #include "ModuleCaller.h"
+#include "EventQueue.h"
+#include "RuntimeShard.h"
+#include "Watchdog.h"
 #include "Logger.h"
 
 
@@ -19,11 +26,20 @@ OPEN_NAMESPACE_JFR
 
 using namespace std;
 
+
+#define JFR_RELOAD_SIGNAL				SIGHUP		// 重新加载流程配置文件的信号
+#define JFR_RELOAD_WAIT_INTERVAL		1			// 等待信号的超时时间(秒)，超时后检查线程是否被中断
+
+
+/// 运行时管理
+// 收到JFR_RELOAD_SIGNAL时重新加载流程配置文件，生成新的流程配置代，新的主线实例使用新的一代
+// 加载失败或新一代的静态模块运行失败时继续使用当前的一代
 class RuntimeManager : public boost::serialization::singleton< RuntimeManager >
 {
 public:
-	int Init(size_t max, const vector< Line_t* >& vLines, const vector< LineStaticModule_t* >& vStaticModules);
+	int Init(size_t max, size_t threads, size_t ready, const FlowGenerationPtr& pGeneration);
 	int Run(void);
+	int Reload(void);
 
 protected:
     RuntimeManager(void);
@@ -31,18 +47,14 @@ protected:
 
 private:
 	int RunStaticModules(void);
+	StaticRuntime_t* RunStaticModule(const string& name);
+	void RefreshStaticModules(void);
+	void WaitReload(void);
 	int RunLines(void);
-	inline int MainlineFSM(Runtime_t* pRuntime);
-	inline int TriggerFSM(Runtime_t* pRuntime);
-	inline int ModuleFSM(Runtime_t* pRuntime);
-	inline int FSMTriggerInit(Runtime_t* pRuntime);
-	inline int FSMTriggerFinish(Runtime_t* pRuntime);
-	inline int FSMEndModuleFinish(Runtime_t* pRuntime, ModContext_t* pEndCtx);
-	inline int FSMModuleWait(Runtime_t* pRuntime, LineModule_t* pLineMod, ModContext_t* pCtx);
-	inline int FSMLineDestroy(Runtime_t* pRuntime);
-	inline LineModule_t* FindLineMod(const vector< LineModule_t* >& vLineMods, const Module_t* pMod);
-	inline const RetValue_t& FindRequireRetVal(const LineModule_t* pLineMod, const Module_t* pMod);
-	inline bool FindProcedMod(const set< Module_t* >& sProcedMods, const Module_t* pMod);
+	void PrewarmLines(const FlowGenerationPtr& pGeneration);
+	inline void SetStaticModules(void);
+	inline void StartRefresh(void);
+	inline void StopRefresh(void);
     inline void Clear(void);
     inline void ClearStaticModules(void);
     inline void ClearLines(void);
@@ -51,27 +63,17 @@ private:
 private:
 	RuntimeSet< Runtime_t, Line_t >*						m_pLineSet;
 	RuntimeSet< StaticRuntime_t, LineStaticModule_t >*		m_pStaticSet;
-    list< Runtime_t* >        		m_lRunList;				// 正在运行的主线集合
-    unsigned int 					m_nRunListMaxSize;
-    vector< string >				m_vLineNames;			// 主线名称
-    list< StaticRuntime_t* >		m_lStaticList;			// 静态模块运行结果集合
+	vector< RuntimeShard* >			m_vShards;				// 调度分片，每个分片一个调度线程
+	FlowGenerationPtr				m_pGeneration;			// 当前的流程配置代
     vector< string >				m_vStaticNames;			// 静态模块名称
+    vector< unsigned int >			m_vStaticRefresh;		// 静态模块刷新间隔(秒)，下标与m_vStaticNames一致
+    boost::thread*					m_pRefreshThread;		// 静态模块刷新线程
+    boost::thread*					m_pReloadThread;		// 等待重新加载信号的线程
     bool 							m_bInited;
     jfr::LoggerSingleton*			m_pLogger;
 };
 
 
-/// 运行结束
-// 开始运行前现找到结束条件(只能有一个)
-// 将等效条件作为一个集合，非等效的条件单独作为一个集合
-// 当一个模块所依赖的模块集合状态均满足要求时，此模块开始运行
-// 当一个模块所依赖的模块集合状态为error时，此模块的状态置为error
-// 以此类推，直至几个结束条件的状态均为error或finish
-// 等效条件集合中，处于equal状态的模块不处理，视为第三种状态
-// 等效条件集合中，条件有一个满足要求时，整个集合就满足要求
-// 等效条件集合中，条件均不满足要求时，整个集合的状态为error
-
-
 CLOSE_NAMESPACE_JFR
 
 
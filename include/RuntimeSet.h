@@ -4,14 +4,19 @@
 
 #include <string>
 #include <map>
+#include <set>
 #include <vector>
 #include <list>
 #include <boost/thread.hpp>
 #include <boost/thread/mutex.hpp>
 #include <boost/thread/condition.hpp>
 #include <boost/serialization/singleton.hpp>
+#include <boost/shared_ptr.hpp>
+#include <boost/atomic.hpp>
+#include <boost/unordered_set.hpp>
 #include <RecyclineFactory/RecyclineFactory.hpp>
 #include "Common.h"
+#include "Arena.h"
 #include "MainlineManager.h"
 #include "Logger.h"
 
@@ -23,30 +28,78 @@ using namespace std;
 USING_NAMESPACE_SWITCHTOOL
 
 
+#define JFR_PID_BUSY				-1			// 取消方正在kill子进程组
+
+
 /// 运行状态
 enum RuntimeStatus
 {
     RTS_INIT,           // 初始化
     RTS_WAIT,           // 等待
     RTS_RUN,            // 正在运行
+    RTS_READY,          // 就绪，等待线程池空位
     RTS_FINISH,         // 运行结束
     RTS_EQUAL,          // 等效状态
     RTS_STATIC,         // 静态模块状态
     RTS_ERROR,          // 运行出错
     RTS_SYSERROR,		// 系统错误
+    RTS_TIMEOUT,        // 运行超时，按出错处理
+    RTS_CANCEL,         // 已取消，按出错处理
     RTS_DESTROY,        // 销毁
     RTS_INVALID = 100	// 非法状态
 };
 
 /// 模块运行上下文结构
+// m_nStat为RTS_RUN期间由运行模块的工作线程独占写入，其余状态只由调度线程写入
+// 工作线程先写返回值和出参，再以release方式写入结束状态；调度线程以acquire方式读到结束状态后即可读取返回值和出参
+// m_nPid由工作线程登记和清除，取消方kill期间置为JFR_PID_BUSY，工作线程等待其恢复后才回收子进程
 struct ModContext_st
 {
-    unsigned int 					m_nStat;	    // 状态 : init, wait, run, finish, equal, static, error, destroy
-    int								m_nRetValue;    // 运行返回值
-    boost::mutex					m_oMutex;
+    boost::atomic< unsigned int >	m_nStat;	    // 状态 : init, wait, run, finish, equal, static, error, destroy
+    int								m_nRetValue;    // 运行返回值，由m_nStat的写入发布
+    Runtime_t*						m_pRuntime;		// 所属主线运行时，静态模块为NULL
+    LineModule_t*					m_pLineMod;		// 对应主线模块，触发器、静态模块为NULL
+    boost::atomic< pid_t >			m_nPid;			// 进程模块运行中的子进程号，0表示无
+    ModEnv_t						m_oEnv;			// 运行环境，取消时置取消标志为取消后的状态
+    boost::system_time				m_oDeadline;	// 超时时间点，由Watchdog使用
+    Arena*							m_pArena;		// 所属运行时的内存区
+    bool							m_bStreamed;	// 以流方式运行的后继模块，返回值和出参已由前驱模块写入，由前驱模块结束状态的写入发布
+    uint64_t						m_nSubmit;		// 提交到线程池的时间点(微秒)，0表示同步调用
+    uint64_t						m_nBegin;		// 开始运行的时间点(微秒)
+    ModUsage_t						m_oUsage;		// 本次调用的资源占用，结束时计入模块和主线的统计
+
+    ModContext_st(void)
+    {
+        m_nStat.store(RTS_INIT, boost::memory_order_relaxed);
+        m_nRetValue = 0;
+        m_pRuntime = NULL;
+        m_pLineMod = NULL;
+        m_nPid.store(0, boost::memory_order_relaxed);
+        m_pArena = NULL;
+        m_bStreamed = false;
+        m_nSubmit = 0;
+        m_nBegin = 0;
+        m_oUsage.Clear();
+    }
+    void SetArena(Arena* pArena)
+    {
+        m_pArena = pArena;
+        m_oEnv.m_pAlloc = Arena::EnvAlloc;
+        m_oEnv.m_pAllocArg = pArena;
+    }
 };
 
+/// 静态模块参数版本，刷新静态模块时生成新版本整体替换，旧版本在不再被主线实例使用后释放
+struct StaticArgVersion_st
+{
+	size_t													m_nVersion;			// 版本号
+	map< ModArg_t*, ArgValue_t* >							m_mapArgs;			// 静态模块参数 -> 参数值
+	map< LineStaticModule_t*, boost::shared_ptr< StaticRuntime_t > >	m_mapRuntimes;		// 静态模块 -> 持有参数值的运行时
+};
+typedef boost::shared_ptr< const StaticArgVersion_t > StaticArgVersionPtr;
+
 /// 主线运行时结构
+// 运行时只由取得它的调度线程访问，不加锁；模块上下文的并发访问见ModContext_st
 struct Runtime_st : public Product
 {
 public:
@@ -54,14 +107,30 @@ public:
 	~Runtime_st(void);
 	void Recycling(void);
 	int Init(Line_t* line);
+	void ResetGraph(void);
+	void PinStaticArgs(void);
+	ArgValue_t** ArgTable(void) { return m_vArgs.empty() ? NULL : &m_vArgs[0]; }
 
 	unsigned int 				    m_nStat;			// 状态 : init, wait, run, finish, error, destroy
 	Line_t*						    m_pLine;            // 主线指针
-	map< ModArg_t*, ArgValue_t* >	m_mapArgs;          // 参数结果map
-	map< LineModule_t*, ModContext_t* >	m_mapModCtxs;	// 模块运行上下文
+	size_t							m_nGeneration;		// 主线所属的流程配置代编号
+	FlowGenerationPtr				m_pGeneration;		// 使用期间持有主线所属的流程配置代，空闲时为空
+	vector< ArgValue_t* >			m_vArgs;			// 参数表，下标为主线内参数下标，静态模块参数的值属于静态模块参数版本
+	ArgValue_t*						m_pArgValues;		// 主线参数值，连续分配
+	StaticArgVersionPtr				m_pStaticArgs;		// 本实例使用的静态模块参数版本
+	vector< ModContext_t* >			m_vModCtxs;			// 模块运行上下文，下标为模块编号
 	ModContext_t*					m_pTriggerCtx;		// 触发器运行上下文
+	ModContext_t*					m_pCtxs;			// 模块和触发器的运行上下文，连续分配，触发器在最后
+	vector< size_t >				m_vRemaining;		// 各模块尚无结果的必要条件集合个数
+	vector< size_t >				m_vFailed;			// 各模块失败的必要条件集合个数
+	vector< int >					m_vSlotFails;		// 各必要条件集合中失败的模块个数，-1表示集合已有结果
+	vector< bool >					m_vPropagated;		// 模块结果是否已传递给后继模块
+	vector< bool >					m_vHeld;			// 模块是否已就绪但被等效组策略暂缓运行
+	vector< size_t >				m_vGroupLaunched;	// 各等效组已运行的模块个数
+	vector< size_t >				m_vGroupAllowed;	// 各等效组当前允许运行的模块个数
+	vector< bool >					m_vGroupDone;		// 各等效组是否已有模块满足要求
+	Arena							m_oArena;			// 实例运行期间的参数值、模块出参等，回收时复位
 	bool							m_bInit;
-	boost::mutex					m_oMutex;
 };
 
 /// 静态模块运行时结构
@@ -72,15 +141,22 @@ public:
 	~StaticRuntime_st(void);
 	void Recycling(void);
 	int Init(LineStaticModule_t* module);
+	void PinStaticArgs(void) {}		// 静态模块不使用静态模块参数
+	ArgValue_t** ArgTable(void) { return m_vArgs.empty() ? NULL : &m_vArgs[0]; }
 
 	LineStaticModule_t*				m_pStaticModule;	// 静态模块指针
+	size_t							m_nGeneration;		// 静态模块所属的流程配置代编号
+	FlowGenerationPtr				m_pGeneration;		// 使用期间持有静态模块所属的流程配置代，空闲时为空
 	ModContext_t*					m_pCtx;				// 运行上下文
-	map< ModArg_t*, ArgValue_t* >	m_mapArgs;          // 参数结果map
+	vector< ArgValue_t* >			m_vArgs;			// 参数表，下标为静态模块内参数下标
+	ArgValue_t*						m_pArgValues;		// 参数值，连续分配
+	Arena							m_oArena;			// 参数值、模块出参，回收时复位
 	bool							m_bInit;
-	boost::mutex					m_oMutex;
 };
 
 /// 运行时环境集合
+// 运行时按名称复用，使用期间持有所属的流程配置代
+// 切换到新的一代后，取得的运行时属于新的一代，旧一代的运行时归还时销毁，不再复用
 template < typename RuntimeType, typename LineType >
 class RuntimeSet : public boost::serialization::singleton< RuntimeSet< RuntimeType,  LineType > >
 {
@@ -88,7 +164,7 @@ public:
 	typedef RecyclingFactorySingleton< RuntimeType, string > RuntimeFactory;
 	typedef typename RecyclingFactorySingleton< RuntimeType, string >::TheProduct RuntimeProduct;
 
-    int Init(const vector< LineType* >& vLines)
+    int Init(const vector< LineType* >& vLines, const FlowGenerationPtr& pGeneration)
     {
         boost::lock_guard< boost::mutex > guard(m_oMutex);
         if (m_bInited)
@@ -97,13 +173,20 @@ public:
         }
 
         m_pRuntimeFactory = &RuntimeFactory::get_mutable_instance();
-        for(size_t i = 0; i < vLines.size(); ++i)
-        {
-            assert(vLines[i]);
-            m_mapLines.insert(make_pair(vLines[i]->m_sName, vLines[i]));
-        }
+        SetLines(vLines, pGeneration);
         m_bInited = true;
 
+        return 0;
+	}
+	/// 切换到新的流程配置代
+	int Reload(const vector< LineType* >& vLines, const FlowGenerationPtr& pGeneration)
+	{
+        FlowGenerationPtr pPrevious;		// 在锁外释放
+
+        boost::lock_guard< boost::mutex > guard(m_oMutex);
+        pPrevious = m_pGeneration;
+        SetLines(vLines, pGeneration);
+
         return 0;
 	}
 	RuntimeType* Obtain(const string& name)
@@ -113,47 +196,97 @@ public:
         RuntimeType* product;
 
         boost::lock_guard< boost::mutex > guard(m_oMutex);
+        m_iter = m_mapLines.find(name);
+        if (m_iter == m_mapLines.end())
+        {
+            return NULL;
+        }
         container = m_pRuntimeFactory->Produce(name);
         product = container->GetProduct();
+        while (product->m_bInit && product->m_nGeneration != m_pGeneration->m_nGeneration)		// 切换前已空闲的旧一代运行时
+        {
+            m_pRuntimeFactory->Destroy(container);
+            container = m_pRuntimeFactory->Produce(name);
+            product = container->GetProduct();
+        }
         if (!product->m_bInit)		// init product
         {
-            m_iter = m_mapLines.find(name);
-            if (m_iter == m_mapLines.end())
-            {
-                m_pRuntimeFactory->Destroy(container);
-                return NULL;
-            }
             if (product->Init(m_iter->second))
             {
                 return NULL;
             }
+            product->m_nGeneration = m_pGeneration->m_nGeneration;
         }
-        m_lEffectProducts.push_back(container);
+        product->m_pGeneration = m_pGeneration;
+        product->PinStaticArgs();		// 持有集合锁，切换流程配置代时不会固定到已移除的静态模块参数
+        m_setEffectProducts.insert(container);
 
         return product;
     }
-	int Release(const RuntimeType* product)
+	/// 预先创建并初始化count个运行时，放回工厂的空闲列表，取得时无需再初始化
+	int Prewarm(const string& name, size_t count)
 	{
-        typename list< RuntimeProduct* >::iterator l_iter, l_end;
-        RuntimeProduct* container;
+        typename map< string, LineType*>::iterator m_iter;
+        vector< RuntimeProduct* > vContainers;
+        RuntimeType* product;
+        int ret = 0;
 
-        assert(product);
         boost::lock_guard< boost::mutex > guard(m_oMutex);
-        l_end = m_lEffectProducts.end();
-        for(l_iter = m_lEffectProducts.begin(); l_iter != l_end; ++l_iter)
+        m_iter = m_mapLines.find(name);
+        if (m_iter == m_mapLines.end())
         {
-            container = *l_iter;
-            if (container->GetProduct() == product)
+            return -1;
+        }
+        for (size_t i = 0; i < count; ++i)
+        {
+            vContainers.push_back(m_pRuntimeFactory->Produce(name));		// 全部取得后再放回，每次取得不同的运行时
+            product = vContainers.back()->GetProduct();
+            while (product->m_bInit && product->m_nGeneration != m_pGeneration->m_nGeneration)		// 旧一代的空闲运行时
+            {
+                m_pRuntimeFactory->Destroy(vContainers.back());
+                vContainers.back() = m_pRuntimeFactory->Produce(name);
+                product = vContainers.back()->GetProduct();
+            }
+            if (!product->m_bInit)
             {
-                break;
+                if (product->Init(m_iter->second))
+                {
+                    m_pRuntimeFactory->Destroy(vContainers.back());
+                    vContainers.pop_back();
+                    ret = -1;
+                    break;
+                }
+                product->m_nGeneration = m_pGeneration->m_nGeneration;
             }
         }
-        if (l_iter == l_end)
+        for (size_t i = 0; i < vContainers.size(); ++i)
+        {
+            m_pRuntimeFactory->Recycling(vContainers[i]);
+        }
+
+        return ret;
+	}
+	int Release(const RuntimeType* product)
+	{
+        RuntimeProduct* container;
+        FlowGenerationPtr pGeneration;		// 运行时销毁后、在锁外释放
+
+        assert(product);
+        container = (RuntimeProduct*)product->GetContainer();		// 运行时记录所属容器，无需查找
+        boost::lock_guard< boost::mutex > guard(m_oMutex);
+        if (!container || m_setEffectProducts.erase(container) == 0)
         {
             return -1;
         }
-        m_lEffectProducts.erase(l_iter);
-        m_pRuntimeFactory->Recycling(container);
+        pGeneration.swap(container->GetProduct()->m_pGeneration);
+        if (pGeneration->m_nGeneration != m_pGeneration->m_nGeneration)
+        {
+            m_pRuntimeFactory->Destroy(container);
+        }
+        else
+        {
+            m_pRuntimeFactory->Recycling(container);
+        }
 
         return 0;
 	}
@@ -173,18 +306,31 @@ protected:
 private:
 	inline void Clear(void)
 	{
-        typename list< RuntimeProduct* >::iterator l_iter, l_end;
+        typename boost::unordered_set< RuntimeProduct* >::iterator s_iter, s_end;
         boost::lock_guard< boost::mutex > guard(m_oMutex);
 
         m_mapLines.clear();
-        l_end = m_lEffectProducts.end();
-        for (l_iter = m_lEffectProducts.begin(); l_iter != l_end; ++l_iter)
+        s_end = m_setEffectProducts.end();
+        for (s_iter = m_setEffectProducts.begin(); s_iter != s_end; ++s_iter)
         {
-            m_pRuntimeFactory->Recycling(*l_iter);
+            m_pRuntimeFactory->Recycling(*s_iter);
+            (*s_iter)->GetProduct()->m_pGeneration.reset();
         }
-        m_lEffectProducts.clear();
+        m_setEffectProducts.clear();
+        m_pGeneration.reset();
         m_bInited = false;
 	}
+	inline void SetLines(const vector< LineType* >& vLines, const FlowGenerationPtr& pGeneration)
+	{
+        assert(pGeneration);
+        m_mapLines.clear();
+        for(size_t i = 0; i < vLines.size(); ++i)
+        {
+            assert(vLines[i]);
+            m_mapLines.insert(make_pair(vLines[i]->m_sName, vLines[i]));
+        }
+        m_pGeneration = pGeneration;
+	}
     inline bool TypeValid(void)
     {
         return (is_same< RuntimeType, StaticRuntime_t >::value && is_same< LineType, LineStaticModule_t >::value) || \
@@ -194,24 +340,41 @@ private:
 private:
 	RuntimeFactory*					m_pRuntimeFactory;
     map< string, LineType* >		m_mapLines;				// line name -- line
-    list< RuntimeProduct* >			m_lEffectProducts;		// 有效产品
+    FlowGenerationPtr				m_pGeneration;			// 当前的流程配置代
+    boost::unordered_set< RuntimeProduct* >	m_setEffectProducts;	// 有效产品
     boost::mutex					m_oMutex;
 	bool							m_bInited;
 };
 
+/// 静态模块运行时的释放函数，静态模块参数版本不再被使用时归还运行时
+struct StaticRuntimeRelease_st
+{
+	void operator()(StaticRuntime_t* pRuntime) const
+	{
+		RuntimeSet< StaticRuntime_t, LineStaticModule_t >::get_mutable_instance().Release(pRuntime);
+	}
+};
+typedef struct StaticRuntimeRelease_st StaticRuntimeRelease_t;
+
 /// 静态模块参数集合
+// 读者原子地取得当前版本的引用，不加锁；写者(启动、刷新静态模块)加锁生成新版本后原子替换
+// 主线实例开始时固定使用当前版本，运行期间静态模块刷新不影响已开始的实例
+// 重新加载配置时，新一代的静态模块先加入当前版本，主线切换到新的一代后再移除旧一代的静态模块
 class StaticModuleArgSet : public boost::serialization::singleton< StaticModuleArgSet >
 {
 public:
-	int InsertElement(ModArg_t* pModArg, ArgValue_t* pArgVal);
-	ArgValue_t* GetElement(ModArg_t* pModArg);
+	int Publish(StaticRuntime_t* pRuntime);
+	int Retain(const vector< LineStaticModule_t* >& vStaticModules);
+	StaticArgVersionPtr Current(void) const;
+	void Clear(void);
 
 protected:
 	StaticModuleArgSet(void);
 	~StaticModuleArgSet(void);
 
 private:
-    map< ModArg_t*, ArgValue_t* >	m_mapArgs;
+	StaticArgVersionPtr				m_pCurrent;			// 当前版本
+	boost::mutex					m_oMutex;			// 写者锁
 };
 
 
@@ -0,0 +1,153 @@
+#ifndef JFR_RUNTIME_SHARD_H
+#define JFR_RUNTIME_SHARD_H
+
+
+#include <string>
+#include <map>
+#include <set>
+#include <list>
+#include <vector>
+#include <boost/thread.hpp>
+#include <boost/thread/mutex.hpp>
+#include "Common.h"
+#include "RuntimeSet.h"
+#include "ModuleCaller.h"
+#include "Watchdog.h"
+#include "EventQueue.h"
+#include "FairQueue.h"
+#include "Logger.h"
+
+
+OPEN_NAMESPACE_JFR
+
+using namespace std;
+
+
+#define JFR_RUNTIME_SWEEP_INTERVAL			1000		// 无事件时全量检查主线的间隔(毫秒)
+#define JFR_RUNTIME_READY_RETRY_INTERVAL	5			// 就绪队列非空时重试提交的间隔(毫秒)
+
+
+/// 就绪任务，等待线程池空位
+struct ReadyJob_st
+{
+	Runtime_t*						m_pRuntime;		// 所属主线运行时
+	LineModule_t*					m_pLineMod;		// 待运行模块，为NULL时为触发器
+};
+typedef struct ReadyJob_st ReadyJob_t;
+
+/// 按主线运行时匹配就绪任务
+struct ReadyJobMatch_st
+{
+	ReadyJobMatch_st(Runtime_t* pRuntime) : m_pRuntime(pRuntime) {}
+	bool operator()(const ReadyJob_t& job) const { return job.m_pRuntime == m_pRuntime; }
+	Runtime_t*						m_pRuntime;
+};
+typedef struct ReadyJobMatch_st ReadyJobMatch_t;
+
+/// hedge策略的延迟定时器，到期时等效组仍未有结果则多运行一个模块
+struct HedgeTimer_st
+{
+	Runtime_t*						m_pRuntime;		// 所属主线运行时
+	size_t							m_nGroup;		// 等效组编号
+	size_t							m_nStamp;		// 设置时等效组已运行的模块个数，不一致时定时器作废
+};
+typedef struct HedgeTimer_st HedgeTimer_t;
+
+/// 等效组准入结果
+enum GroupAdmit
+{
+	GA_LAUNCH,			// 运行
+	GA_HOLD,			// 暂缓运行
+	GA_CANCEL			// 等效组已有结果，取消
+};
+
+
+/// 主线调度分片
+// 每个调度线程一个分片，主线按编号划分到各分片，同一主线的实例只在一个分片中运行
+// 分片的运行队列、待触发主线名称、事件队列均为本线程独占，分片间不共享锁
+// 任务以非阻塞方式提交到线程池，线程池已满时放入就绪队列，模块结束腾出空位后按先后顺序提交
+// 就绪队列达到上限时暂停触发新的主线实例，已运行的实例不受影响
+// 待触发实例和就绪任务均按主线的优先级、权重公平排队，高优先级主线不排在低优先级主线之后
+// 重新加载配置后，分片在本线程内切换到新一代主线，旧一代的待触发实例作废，已运行的实例运行至结束
+class RuntimeShard
+{
+public:
+	RuntimeShard(void);
+	~RuntimeShard(void);
+	int Init(size_t id, size_t max, size_t ready, const vector< Line_t* >& vLines, size_t nGeneration);
+	int Reload(const vector< Line_t* >& vLines, size_t nGeneration);
+	int Run(void);
+	void Clear(void);
+
+private:
+	inline void AddLines(const vector< Line_t* >& vLines);
+	inline int ApplyReload(void);
+	inline int AdmitLines(void);
+	inline int DriveRuntime(Runtime_t* pRuntime, ModContext_t* pCtx);
+	inline int SweepRuntime(Runtime_t* pRuntime);
+	inline int MainlineFSM(Runtime_t* pRuntime, ModContext_t* pCtx);
+	inline int TriggerFSM(Runtime_t* pRuntime);
+	inline int ModuleFSM(Runtime_t* pRuntime, ModContext_t* pCtx);
+	inline int FSMTriggerInit(Runtime_t* pRuntime);
+	inline int FSMTriggerFinish(Runtime_t* pRuntime);
+	inline int FSMTriggerTimeout(Runtime_t* pRuntime);
+	inline int FSMEndModuleFinish(Runtime_t* pRuntime, ModContext_t* pEndCtx);
+	inline int FSMModuleFinish(Runtime_t* pRuntime, LineModule_t* pLineMod);
+	inline int FSMResolve(Runtime_t* pRuntime, const vector< LineEdge_t >& vEdges, bool bFinish, int nRetValue);
+	inline int FSMResolveEdges(Runtime_t* pRuntime, const vector< LineEdge_t >& vEdges, bool bFinish, int nRetValue, list< LineModule_t* >& lErrorMods);
+	inline int FSMModuleReady(Runtime_t* pRuntime, LineModule_t* pLineMod, list< LineModule_t* >& lErrorMods);
+	inline int FSMLineDestroy(Runtime_t* pRuntime);
+	inline int ReapRuntime(Runtime_t* pRuntime);
+	inline int FSMGroupAdmit(Runtime_t* pRuntime, LineModule_t* pLineMod);
+	inline int FSMGroupLaunch(Runtime_t* pRuntime, size_t nGroup);
+	inline int FSMGroupFinish(Runtime_t* pRuntime, LineModule_t* pLineMod, bool bFinish, int nRetValue);
+	inline int FSMGroupCancel(Runtime_t* pRuntime, size_t nGroup);
+	inline int FireHedgeTimers(void);
+	inline unsigned int WaitTimeout(void);
+	inline int Submit(Runtime_t* pRuntime, LineModule_t* pLineMod);
+	inline int Dispatch(Runtime_t* pRuntime, LineModule_t* pLineMod);
+	inline int DrainReadyList(void);
+	inline ModContext_t* JobContext(Runtime_t* pRuntime, LineModule_t* pLineMod);
+
+private:
+	size_t							m_nId;					// 分片编号
+	RuntimeSet< Runtime_t, Line_t >*	m_pLineSet;
+	EventQueue*						m_pEventQueue;
+	Watchdog*						m_pWatchdog;
+    set< Runtime_t* >        		m_sRunList;				// 正在运行的主线集合
+    set< Runtime_t* >				m_sDrainList;			// 已结束、等待取消的模块返回的主线集合
+    unsigned int 					m_nRunListMaxSize;
+    FairQueue< Line_t* >			m_oAdmitQueue;			// 等待触发的主线实例
+    FairQueue< ReadyJob_t >			m_oReadyQueue;			// 等待线程池空位的任务
+    map< string, size_t >			m_mapFlows;				// 主线名称 -> 两个公平队列的流编号，重新加载后同名主线沿用
+    size_t							m_nReadyListMaxSize;	// 就绪队列上限，达到后暂停触发
+    bool							m_bPaused;				// 是否已暂停触发
+    multimap< boost::system_time, HedgeTimer_t >	m_mapHedgeTimers;	// hedge策略的延迟定时器
+    size_t							m_nGeneration;			// 当前触发的主线所属的流程配置代编号
+    vector< Line_t* >				m_vReloadLines;			// 待切换的新一代主线
+    size_t							m_nReloadGeneration;	// 待切换的流程配置代编号，0表示无
+    boost::mutex					m_oReloadMutex;			// 保护待切换的主线
+    jfr::LoggerSingleton*			m_pLogger;
+};
+
+
+/// 运行结束
+// 主线加载时编译为依赖图，每个模块的必要条件按等效条件合并为集合
+// 模块结束时只处理其后继模块的集合计数，集合计数归零时模块开始运行或置为error
+// 开始运行前现找到结束条件(只能有一个)
+// 将等效条件作为一个集合，非等效的条件单独作为一个集合
+// 当一个模块所依赖的模块集合状态均满足要求时，此模块开始运行
+// 当一个模块所依赖的模块集合状态为error时，此模块的状态置为error
+// 以此类推，直至几个结束条件的状态均为error或finish
+// 等效条件集合中，处于equal状态的模块不处理，视为第三种状态
+// 等效条件集合中，条件有一个满足要求时，整个集合就满足要求
+// 等效条件集合中，条件均不满足要求时，整个集合的状态为error
+// 配置了策略的等效条件集合：first_wins策略全部运行，hedge策略先运行一个，超过延迟未有结果或失败时再运行下一个
+// 集合中有一个满足要求后，取消其余模块，正在运行的由Watchdog取消，状态为cancel，按出错处理
+// 结束条件有结果后，取消仍在运行的模块，主线立即让出运行队列，运行时在被取消的模块全部返回后回收
+
+
+CLOSE_NAMESPACE_JFR
+
+
+#endif // JFR_RUNTIME_SHARD_H
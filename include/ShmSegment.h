@@ -0,0 +1,52 @@
+#ifndef JFR_SHM_SEGMENT_H
+#define JFR_SHM_SEGMENT_H
+
+
+#include <unistd.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <string.h>
+#include <assert.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/types.h>
+#include "Common.h"
+
+
+OPEN_NAMESPACE_JFR
+
+
+#define JFR_SHM_FD_BASE				3				// 共享内存入参在子进程中的起始描述符，第i个入参为JFR_SHM_FD_BASE + i
+
+
+/// 共享内存参数段
+// 进程模块(transport='shm')的入参和出参以memfd传递：入参写入memfd(来自共享内存出参时直接使用其memfd，不复制)，
+// 子进程中为描述符JFR_SHM_FD_BASE + i，命令行参数为对应的路径"/dev/fd/<n>"；标准输出重定向到memfd，不经过管道
+// 子进程结束后出参memfd加封印(不可再写入或改变大小)并只读映射，作为参数值，长度记录在ArgValue_t::m_nLength，
+// 映射后紧跟一个'\0'，可按字符串使用；映射前的一页保存映射大小、长度和memfd，释放回调函数为Free
+class ShmSegment
+{
+public:
+	static int Create(const char* sName);
+	static int FromBuffer(const char* pBuf, size_t nLength);
+	static char* Map(int fd, size_t& nLength);
+	static void Free(void* pValue);
+	static int Fd(const ArgValue_t* pArgValue);
+
+private:
+	struct Header_st
+	{
+		size_t						m_nMapSize;			// 映射总大小，包括头部页
+		size_t						m_nLength;			// 内容长度
+		int							m_nFd;				// 内容所在的memfd
+	};
+	typedef struct Header_st Header_t;
+
+	static inline size_t PageSize(void);
+};
+
+
+CLOSE_NAMESPACE_JFR
+
+
+#endif // JFR_SHM_SEGMENT_H
@@ -0,0 +1,57 @@
+#ifndef JFR_WATCHDOG_H
+#define JFR_WATCHDOG_H
+
+
+#include <signal.h>
+#include <sys/types.h>
+#include <map>
+#include <boost/thread.hpp>
+#include <boost/thread/mutex.hpp>
+#include <boost/thread/condition.hpp>
+#include <boost/serialization/singleton.hpp>
+#include "Common.h"
+#include "RuntimeSet.h"
+#include "Logger.h"
+
+
+OPEN_NAMESPACE_JFR
+
+using namespace std;
+
+
+/// 模块超时监控
+// 模块在线程池中开始运行时登记超时时间点，运行结束时注销
+// 超时后置运行环境的取消标志，进程模块杀掉子进程所在的进程组，动态库模块由扩展回调函数检查取消标志自行返回
+// 模块运行结束后由调用线程根据取消标志将状态置为RTS_TIMEOUT
+// 调度线程也可以通过Cancel取消正在运行的模块，如等效组中已有模块满足要求
+class Watchdog : public boost::serialization::singleton< Watchdog >
+{
+public:
+	int Start(void);
+	void Stop(void);
+	int Watch(ModContext_t* pCtx, unsigned int timeout);
+	int Unwatch(ModContext_t* pCtx);
+	int Cancel(ModContext_t* pCtx, unsigned int stat);
+
+protected:
+	Watchdog(void);
+	~Watchdog(void);
+
+private:
+	void Run(void);
+	inline void Expire(ModContext_t* pCtx);
+
+private:
+	multimap< boost::system_time, ModContext_t* >	m_mapDeadlines;		// 超时时间点 -> 模块运行上下文
+	boost::thread*					m_pThread;
+	bool							m_bStop;
+	boost::mutex					m_oMutex;
+	boost::condition				m_oCond;
+	jfr::LoggerSingleton*			m_pLogger;
+};
+
+
+CLOSE_NAMESPACE_JFR
+
+
+#endif // JFR_WATCHDOG_H
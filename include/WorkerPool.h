@@ -0,0 +1,85 @@
+#ifndef JFR_WORKER_POOL_H
+#define JFR_WORKER_POOL_H
+
+
+#include <unistd.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <signal.h>
+#include <sys/types.h>
+#include <sys/wait.h>
+#include <string>
+#include <vector>
+#include <boost/thread.hpp>
+#include <boost/thread/mutex.hpp>
+#include <boost/thread/condition.hpp>
+#include "Common.h"
+#include "Arena.h"
+#include "Logger.h"
+
+
+OPEN_NAMESPACE_JFR
+
+using namespace std;
+
+
+/// 常驻进程
+struct Worker_st
+{
+	pid_t						m_nPid;				// 进程号，单独的进程组
+	int							m_nIn;				// 写入进程的标准输入
+	int							m_nOut;				// 读取进程的标准输出
+	unsigned int				m_nRequests;		// 已处理的请求数
+
+	Worker_st(void)
+	{
+		m_nPid = 0;
+		m_nIn = -1;
+		m_nOut = -1;
+		m_nRequests = 0;
+	}
+};
+
+/// 常驻进程池
+// 常驻进程模块(type='worker')的进程启动后循环处理请求，省去每次调用的进程启动开销
+// 请求：入参个数，每个入参的长度和内容，格式为"<argc>\n"，之后每个入参为"<len>\n<bytes>"
+// 应答：返回值、输出长度和输出内容，格式为"<ret> <len>\n<bytes>"
+// 入参长度取ArgValue_t::m_nLength，为0时按'\0'结尾的字符串计算；应答声明的输出长度超过上限时按格式错误处理
+// 进程在首次使用时启动；读写失败、被取消或超时的进程结束并回收，下次使用时重新启动；处理请求数达到上限的进程结束后重新启动
+// 所有进程都在使用中时，调用线程等待空闲的进程
+class WorkerPool
+{
+public:
+	WorkerPool(const string& name, const string& filename, unsigned int workers, unsigned int maxRequests, unsigned int maxReplyBytes);
+	~WorkerPool(void);
+	Worker_t* Acquire(void);
+	void Release(Worker_t* pWorker, bool bReuse);
+	int Call(Worker_t* pWorker, const ArgValue_t* const* ppArgs, size_t nArgc, Arena* pArena, int& nRetValue, char*& pOutput, size_t& nLength);
+
+private:
+	Worker_t* Start(void);
+	void Stop(Worker_t* pWorker);
+	inline int WriteAll(int fd, const char* buf, size_t len);
+
+private:
+	string							m_sName;			// 模块名称
+	string							m_sFileName;		// 模块文件
+	unsigned int					m_nWorkers;			// 进程数上限
+	unsigned int					m_nMaxRequests;		// 每个进程处理请求数上限，0表示不限制
+	unsigned long					m_nMaxReplyBytes;	// 应答输出长度上限(字节)
+	unsigned int					m_nLive;			// 已启动和正在启动的进程数
+	vector< Worker_t* >				m_vIdle;			// 空闲进程
+	boost::mutex					m_oMutex;
+	boost::condition				m_oCond;
+	jfr::LoggerSingleton*			m_pLogger;
+
+private:
+	WorkerPool(const WorkerPool&);
+	WorkerPool& operator=(const WorkerPool&);
+};
+
+
+CLOSE_NAMESPACE_JFR
+
+
+#endif // JFR_WORKER_POOL_H
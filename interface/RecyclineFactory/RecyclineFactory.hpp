@@ -3,9 +3,10 @@
 
 
 /**
- * 可回收产品的工厂类 v0.11
+ * 可回收产品的工厂类 v0.12
  * 1. 重复利用产品
  * 2. 仅支持单一产品
+ * 3. 产品以侵入式链表管理，取得、回收、销毁均为O(1)，不随产品数量增长
  *
  * 欢迎补充！
  **/
@@ -36,24 +37,41 @@
 OPEN_NAMESPACE_SWITCHTOOL
 
 
+/// 产品基类，记录所属的容器，由产品直接找到容器，归还时无需查找
 class Product
 {
 public:
+	Product(void) : __pContainer(NULL) {}
 	virtual void Recycling(void) = 0;
 	virtual ~Product(void) {}
+	void* GetContainer(void) const { return __pContainer; }
+	void SetContainer(void* container) { __pContainer = container; }
+
+private:
+	void*			__pContainer;
 };
 
+template< typename ProductType, typename ProductName >
+class RecyclingFactory;
+
 template < typename ProductType, typename ProductName = std::string >
 class ProductContainer
 {
 public:
-	ProductContainer(const ProductName& name) : __sName(name) { __pType = new ProductType; }
+	ProductContainer(const ProductName& name) : __sName(name)
+	{
+		__pType = new ProductType;
+		__pType->SetContainer(this);
+		InitLink();
+	}
 	~ProductContainer(void) { delete __pType; }
 	ProductContainer(const ProductContainer< ProductType, ProductName >& product)
 	{
         this->__sName = product.__sName;
         this->__pType = new ProductType;
         *this->__pType = *product.__pType;
+        this->__pType->SetContainer(this);
+        InitLink();
 	}
 	ProductContainer< ProductType, ProductName >& operator=(const ProductContainer< ProductType, ProductName >& product)
 	{
@@ -64,9 +82,24 @@ public:
 	const ProductName& GetName(void) const { return __sName; }
 	ProductType* GetProduct(void) const { return __pType; }
 
+private:
+	friend class RecyclingFactory< ProductType, ProductName >;
+	inline void InitLink(void)
+	{
+		__pPrev = __pNext = NULL;
+		__ppIdle = NULL;
+		__pOwner = NULL;
+		__bBusy = false;
+	}
+
 private:
 	ProductName 	__sName;
 	ProductType*	__pType;
+	ProductContainer*	__pPrev;			// 所在链表(忙碌链表或同名空闲链表)的前后节点
+	ProductContainer*	__pNext;
+	ProductContainer**	__ppIdle;			// 同名空闲链表的表头
+	const void*		__pOwner;			// 所属工厂，用于校验
+	bool			__bBusy;
 };
 
 template< typename ProductType, typename ProductName = std::string >
@@ -78,85 +111,50 @@ public:
 	TheProduct* Produce(const ProductName& name)
 	{
 		boost::lock_guard< boost::mutex > guard(m_oWaitMutex);
-		typename std::map< ProductName, std::list < TheProduct* > >::iterator m_iter;
+		TheProduct** ppIdle;
 
-		m_iter = m_mapProducts.find(name);
-		if (m_iter == m_mapProducts.end() || m_iter->second.empty())
+		ppIdle = IdleList(name);
+		if (*ppIdle == NULL)
 		{
-            return ProduceNew(name);
+            return ProduceNew(name, ppIdle);
 		}
-		return ProduceIdle(m_iter->second);
+		return ProduceIdle(ppIdle);
 	}
 
 	void Duplicate(const TheProduct* product, const size_t count = 1)
 	{
-		typename std::map< ProductName, std::list< TheProduct* > >::iterator m_iter;
-
+		boost::lock_guard< boost::mutex > guard(m_oWaitMutex);
 		assert(IsValidProduct(product));
         for (size_t i = 0; i < count; ++i)
 		{
 			TheProduct* p = new TheProduct(*product);
 			p->GetProduct()->Recycling();
-			m_lIdleList.push_back(p);
-			m_setProducts.insert(p);
-			m_iter = m_mapProducts.find(p->GetName());
-			if (m_iter == m_mapProducts.end())
-			{
-				std::list< TheProduct* > lTmp;
-				lTmp.push_back(p);
-				m_mapProducts.insert(make_pair(p->GetName(), lTmp));
-			}
-			else
-			{
-				m_iter->second.push_back(p);
-			}
+			p->__pOwner = this;
+			p->__ppIdle = IdleList(p->GetName());
+			Link(p->__ppIdle, p);
 		}
 	}
 
 	void Recycling(const TheProduct* product)
 	{
-		typename std::list< TheProduct* >::iterator s_iter, s_end;
-		typename std::map< ProductName, std::list< TheProduct* > >::iterator m_iter;
+		TheProduct* p = (TheProduct*)product;
 
 		boost::lock_guard< boost::mutex > guard(m_oWaitMutex);
 		assert(product);
 
-		if (!IsValidProduct(product))
+		if (!IsValidProduct(product) || !p->__bBusy)
 		{
 			return;
 		}
-		s_end = m_lBusyList.end();
-		for(s_iter = m_lBusyList.begin(); s_iter != s_end; ++s_iter)
-		{
-			if (*s_iter == product)
-			{
-				break;
-			}
-		}
-		if (s_iter == s_end)
-		{
-			return;
-		}
-		m_lBusyList.erase(s_iter);
-		product->GetProduct()->Recycling();
-		m_lIdleList.push_back((TheProduct*)product);
-		m_iter = m_mapProducts.find(product->GetName());
-		if (m_iter == m_mapProducts.end())
-		{
-			std::list< TheProduct* > lTmp;
-			lTmp.push_back((TheProduct*)product);
-			m_mapProducts.insert(make_pair(product->GetName(), lTmp));
-		}
-		else
-		{
-			m_iter->second.push_back((TheProduct*)product);
-		}
+		Unlink(&m_pBusy, p);
+		p->__bBusy = false;
+		p->GetProduct()->Recycling();
+		Link(p->__ppIdle, p);			// 后进先出，优先复用最近归还的产品
 	}
 
 	void Destroy(const TheProduct* product)
 	{
-		typename std::list< TheProduct* >::iterator s_iter;
-		typename std::map< ProductName, std::list< TheProduct* > >::iterator m_iter;
+		TheProduct* p = (TheProduct*)product;
 
 		boost::lock_guard< boost::mutex > guard(m_oWaitMutex);
 		assert(product);
@@ -165,64 +163,95 @@ public:
 		{
 			return;
 		}
-		m_lBusyList.remove((TheProduct*)product);
-		m_lIdleList.remove((TheProduct*)product);
-		m_iter = m_mapProducts.find(product->GetName());
-		if (m_iter != m_mapProducts.end())
-		{
-			m_iter->second.remove((TheProduct*)product);
-		}
-		m_setProducts.erase((TheProduct*)product);
-		delete product;
+		Unlink(p->__bBusy ? &m_pBusy : p->__ppIdle, p);
+		delete p;
 	}
 
 public:
-    RecyclingFactory(void) {}
+    RecyclingFactory(void) : m_pBusy(NULL) {}
     ~RecyclingFactory(void)
     {
-		typename std::set< TheProduct* >::iterator iter, end;
+		typename std::map< ProductName, TheProduct* >::iterator iter, end;
 
-		m_lIdleList.clear();
-		m_lBusyList.clear();
-		m_mapProducts.clear();
-		end = m_setProducts.end();
-		for (iter = m_setProducts.begin(); iter != end; ++iter)
+		DeleteList(m_pBusy);
+		end = m_mapProducts.end();
+		for (iter = m_mapProducts.begin(); iter != end; ++iter)
 		{
-            delete *iter;
+			DeleteList(iter->second);
 		}
-		m_setProducts.clear();
+		m_mapProducts.clear();
     }
 
 private:
-	inline TheProduct* ProduceNew(const ProductName& name)
+	inline TheProduct* ProduceNew(const ProductName& name, TheProduct** ppIdle)
 	{
 		TheProduct* p = new TheProduct(name);
-		m_lBusyList.push_back(p);
-		m_setProducts.insert(p);
+		p->__pOwner = this;
+		p->__ppIdle = ppIdle;
+		p->__bBusy = true;
+		Link(&m_pBusy, p);
 		return p;
 	}
-	inline TheProduct* ProduceIdle(std::list< TheProduct* >& nameIdlelist)
+	inline TheProduct* ProduceIdle(TheProduct** ppIdle)
 	{
-		assert(!nameIdlelist.empty());
-		TheProduct* p = nameIdlelist.front();
+		TheProduct* p = *ppIdle;
 		assert(p && p->GetProduct());
-		nameIdlelist.pop_front();
-		m_lIdleList.remove(p);
-		m_lBusyList.push_back(p);
+		Unlink(ppIdle, p);
+		p->__bBusy = true;
+		Link(&m_pBusy, p);
 		return p;
 	}
+	/// 同名空闲链表的表头，std::map的元素地址不变，由产品记录
+	inline TheProduct** IdleList(const ProductName& name)
+	{
+		return &m_mapProducts.insert(std::make_pair(name, (TheProduct*)NULL)).first->second;
+	}
+	inline void Link(TheProduct** ppHead, TheProduct* p)
+	{
+		p->__pPrev = NULL;
+		p->__pNext = *ppHead;
+		if (*ppHead)
+		{
+			(*ppHead)->__pPrev = p;
+		}
+		*ppHead = p;
+	}
+	inline void Unlink(TheProduct** ppHead, TheProduct* p)
+	{
+		if (p->__pPrev)
+		{
+			p->__pPrev->__pNext = p->__pNext;
+		}
+		else
+		{
+			assert(*ppHead == p);
+			*ppHead = p->__pNext;
+		}
+		if (p->__pNext)
+		{
+			p->__pNext->__pPrev = p->__pPrev;
+		}
+		p->__pPrev = p->__pNext = NULL;
+	}
+	inline void DeleteList(TheProduct* p)
+	{
+		while (p)
+		{
+			TheProduct* next = p->__pNext;
+			delete p;
+			p = next;
+		}
+	}
 	inline bool IsValidProduct(const TheProduct* p)
 	{
 		assert(p);
-		return m_setProducts.find((TheProduct*)p) == m_setProducts.end() ? false : true;
+		return p->__pOwner == this;
 	}
 
 private:
 	boost::mutex										m_oWaitMutex;
-	std::list< TheProduct* >							m_lIdleList;			// 空闲列表
-	std::list< TheProduct* > 							m_lBusyList;			// 忙碌列表
-	std::map< ProductName, std::list< TheProduct* > >	m_mapProducts;			// 产品名称 -- 空闲产品列表
-	std::set< TheProduct* >								m_setProducts;			// 所有产品
+	TheProduct*											m_pBusy;				// 忙碌链表
+	std::map< ProductName, TheProduct* >				m_mapProducts;			// 产品名称 -- 空闲链表表头
 };
 
 
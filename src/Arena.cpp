@@ -0,0 +1,147 @@
+#include "Arena.h"
+
+OPEN_NAMESPACE_JFR
+
+Arena::Arena(void)
+{
+	m_nChunk = 0;
+	m_nOffset = 0;
+	m_nMarkChunk = 0;
+	m_nMarkOffset = 0;
+	m_pLast = NULL;
+}
+
+Arena::~Arena(void)
+{
+	for (size_t i = 0; i < m_vChunks.size(); ++i)
+	{
+		free(m_vChunks[i].m_pBuf);
+	}
+}
+
+void* Arena::Alloc(size_t size)
+{
+	boost::lock_guard< boost::mutex > guard(m_oMutex);
+	return AllocLocked(size);
+}
+
+/// 扩展ptr指向的size字节到newSize字节，ptr为最近一次分配且当前块有空间时原地扩展，否则重新分配并复制
+void* Arena::Grow(void* ptr, size_t size, size_t newSize)
+{
+	void* p;
+
+	assert(newSize >= size);
+	boost::lock_guard< boost::mutex > guard(m_oMutex);
+	if (ptr && ptr == m_pLast)
+	{
+		Chunk_t& chunk = m_vChunks[m_nChunk];
+		size_t offset = (char*)ptr - chunk.m_pBuf;
+		size_t aligned = (newSize + JFR_ARENA_ALIGN - 1) & ~(size_t)(JFR_ARENA_ALIGN - 1);
+		if (offset + aligned <= chunk.m_nSize)
+		{
+			m_nOffset = offset + aligned;
+			return ptr;
+		}
+	}
+	p = AllocLocked(newSize);
+	if (ptr && size)
+	{
+		memcpy(p, ptr, size);
+	}
+
+	return p;
+}
+
+char* Arena::Strdup(const char* str, size_t len)
+{
+	char* p;
+
+	p = (char*)Alloc(len + 1);
+	memcpy(p, str, len);
+	p[len] = '\0';
+
+	return p;
+}
+
+/// 以当前位置为基准点，复位时保留基准点之前的分配
+void Arena::Mark(void)
+{
+	boost::lock_guard< boost::mutex > guard(m_oMutex);
+	m_nMarkChunk = m_nChunk;
+	m_nMarkOffset = m_nOffset;
+	m_pLast = NULL;
+}
+
+/// 复位到基准点，块保留供下次使用；块总大小超过保留上限时释放基准点之后的块
+void Arena::Reset(void)
+{
+	size_t total;
+
+	boost::lock_guard< boost::mutex > guard(m_oMutex);
+	m_nChunk = m_nMarkChunk;
+	m_nOffset = m_nMarkOffset;
+	m_pLast = NULL;
+	total = 0;
+	for (size_t i = 0; i < m_vChunks.size(); ++i)
+	{
+		total += m_vChunks[i].m_nSize;
+	}
+	if (total > JFR_ARENA_RETAIN_SIZE)
+	{
+		for (size_t i = m_nMarkChunk + 1; i < m_vChunks.size(); ++i)
+		{
+			free(m_vChunks[i].m_pBuf);
+		}
+		if (m_vChunks.size() > m_nMarkChunk + 1)
+		{
+			m_vChunks.resize(m_nMarkChunk + 1);
+		}
+	}
+}
+
+/// 动态库扩展回调函数通过ModEnv_t::m_pAlloc分配内存
+void* Arena::EnvAlloc(ModEnv_t* pEnv, size_t size)
+{
+	if (!pEnv || !pEnv->m_pAllocArg)
+	{
+		return NULL;
+	}
+	return ((Arena*)pEnv->m_pAllocArg)->Alloc(size);
+}
+
+/// 持有m_oMutex时调用，当前块空间不足时使用之后第一个足够大的块，没有时新建块
+void* Arena::AllocLocked(size_t size)
+{
+	size_t i;
+	Chunk_t chunk;
+
+	size = (size + JFR_ARENA_ALIGN - 1) & ~(size_t)(JFR_ARENA_ALIGN - 1);
+	if (m_nChunk < m_vChunks.size() && m_nOffset + size <= m_vChunks[m_nChunk].m_nSize)
+	{
+		m_pLast = m_vChunks[m_nChunk].m_pBuf + m_nOffset;
+		m_nOffset += size;
+		return m_pLast;
+	}
+	for (i = m_vChunks.empty() ? 0 : m_nChunk + 1; i < m_vChunks.size(); ++i)
+	{
+		if (m_vChunks[i].m_nSize >= size)
+		{
+			break;
+		}
+	}
+	if (i == m_vChunks.size())
+	{
+		chunk.m_nSize = size > JFR_ARENA_CHUNK_SIZE ? size : JFR_ARENA_CHUNK_SIZE;
+		chunk.m_pBuf = (char*)malloc(chunk.m_nSize);
+		assert(chunk.m_pBuf);
+		m_vChunks.push_back(chunk);
+	}
+	m_nChunk = i;
+	m_pLast = m_vChunks[m_nChunk].m_pBuf;
+	m_nOffset = size;
+
+	return m_pLast;
+}
+
+
+CLOSE_NAMESPACE_JFR
@@ -19,6 +19,8 @@ Config::Config(void)
     m_nMaxRunLines = JFR_DEFAULT_CONFIG_MAXRUNLINES;
     m_nMaxThreadSize = JFR_DEFAULT_CONFIG_MAXTHREADSIZE;
     m_nMaxJobSize = JFR_DEFAULT_CONFIG_MAXJOBSIZE;
+    m_nSchedulerThreads = JFR_DEFAULT_CONFIG_SCHEDULERTHREADS;
+    m_nMaxReadyNum = JFR_DEFAULT_CONFIG_MAXREADYNUM;
     m_nDebugLevel = JFR_DEFAULT_CONFIG_DEBUGLEVEL;
     m_bDaemon = JFR_DEFAULT_CONFIG_DEAMON;
     m_bCfgCheck = JFR_DEFAULT_CONFIG_CFGCHECK;
@@ -39,6 +41,8 @@ const string& Config::GetLogPrefix(void) const { return m_sLogPrefix;}
 const int Config::GetMaxRunLines(void) const { return m_nMaxRunLines;}
 const int Config::GetMaxThreadSize(void) const { return m_nMaxThreadSize;}
 const int Config::GetMaxJobSize(void) const { return m_nMaxJobSize;}
+const int Config::GetSchedulerThreads(void) const { return m_nSchedulerThreads;}
+const int Config::GetMaxReadyNum(void) const { return m_nMaxReadyNum;}
 const int Config::GetDebugLevel(void) const { return m_nDebugLevel;}
 const bool Config::GetDaemonFlag(void) const { return m_bDaemon;}
 const bool Config::GetLog2TermFlag(void) const { return m_bLog2Term;}
@@ -104,6 +108,20 @@ int Config::SetMaxJobSize(const int max)
 	m_nMaxJobSize = max;
 	return 0;
 }
+int Config::SetSchedulerThreads(const int num)
+{
+	if (num <= 0)
+		return -1;
+	m_nSchedulerThreads = num;
+	return 0;
+}
+int Config::SetMaxReadyNum(const int max)
+{
+	if (max <= 0)
+		return -1;
+	m_nMaxReadyNum = max;
+	return 0;
+}
 int Config::SetDebugLevel(const int level)
 {
 	if (level < JFR_DEFAULT_CONFIG_DEBUGLEVEL_MIN || level > JFR_DEFAULT_CONFIG_DEBUGLEVEL_MAX)
@@ -204,6 +222,28 @@ int Config::ParseConfigFile(void)
 				}
 			}
 		}
+		/// 调度线程数，可选节点
+		pXMLNode = pXMLRoot->first_node("scheduler_threads");
+		if (pXMLNode && string(pXMLNode->value()) != "")
+		{
+			max = atoi(pXMLNode->value());
+			if (SetSchedulerThreads(max))
+			{
+				cerr << MODULE_JFR"[ERROR]: config file node <scheduler_threads> value error, file name: " << sFileName << endl;
+				ret = -1;
+			}
+		}
+		/// 等待线程池空位的任务上限，超过后暂停触发，可选节点
+		pXMLNode = pXMLRoot->first_node("max_ready_num");
+		if (pXMLNode && string(pXMLNode->value()) != "")
+		{
+			max = atoi(pXMLNode->value());
+			if (SetMaxReadyNum(max))
+			{
+				cerr << MODULE_JFR"[ERROR]: config file node <max_ready_num> value error, file name: " << sFileName << endl;
+				ret = -1;
+			}
+		}
 		pXMLNode = pXMLRoot->first_node("log_prefix");
 		if (!pXMLNode)
 		{
@@ -131,6 +131,8 @@ int ConfigParser::Parse(void)
 int ConfigParser::ParseModules(xml_node<>* pRoot)
 {
 	xml_node<>* pXMLNode;
+	unsigned int nTimeout;
+	ConfigModule_t cfgCache;
 
     assert(pRoot);
 	m_pLogger->LogWrite(DEBUG_3, MODULE_JFR, "Begin to parse modules.");
@@ -163,14 +165,26 @@ int ConfigParser::ParseModules(xml_node<>* pRoot)
 			m_pLogger->LogWrite(DEBUG_1, MODULE_JFR, LOG_FUNC_STRING, LOG_FUNC_VALUE);
 			continue;
 		}
+		else if (ParseTimeout(pMod, "module/module", nTimeout) || ParseCache(pMod, "module/module", cfgCache) || ParseWorker(pMod, "module/module", cfgCache) || ParseTransport(pMod, "module/module", cfgCache))
+		{
+			continue;
+		}
 		else
 		{
 			ConfigModule_t* pMod = new ConfigModule_t;
+			pMod->m_bCache = cfgCache.m_bCache;
+			pMod->m_nCacheTtl = cfgCache.m_nCacheTtl;
+			pMod->m_nCacheMaxBytes = cfgCache.m_nCacheMaxBytes;
+			pMod->m_nWorkers = cfgCache.m_nWorkers;
+			pMod->m_nMaxRequests = cfgCache.m_nMaxRequests;
+			pMod->m_nMaxReplyBytes = cfgCache.m_nMaxReplyBytes;
+			pMod->m_sTransport = cfgCache.m_sTransport;
 			pMod->m_sName = pName->value();
 			pMod->m_sType = pType->value();
 			pMod->m_sMain = pMain->value();
 			FileExpand(pFile->value(), pMod->m_sFileName);
 			pMod->m_sDesc = pDesc->value();
+			pMod->m_nTimeout = nTimeout;
 			m_vModules.push_back(pMod);
 		}
 	}
@@ -183,6 +197,7 @@ int ConfigParser::ParseModules(xml_node<>* pRoot)
 int ConfigParser::ParseTriggers(xml_node<>* pRoot)
 {
 	xml_node<>* pXMLNode;
+	unsigned int nTimeout;
 
     assert(pRoot);
 	m_pLogger->LogWrite(DEBUG_3, MODULE_JFR, "Begin to parse triggers.");
@@ -215,6 +230,10 @@ int ConfigParser::ParseTriggers(xml_node<>* pRoot)
 			m_pLogger->LogWrite(DEBUG_1, MODULE_JFR, LOG_FUNC_STRING, LOG_FUNC_VALUE);
 			continue;
 		}
+		else if (ParseTimeout(pMod, "trigger/trigger", nTimeout))
+		{
+			continue;
+		}
 		else
 		{
 			ConfigTrigger_t* pTrig = new ConfigTrigger_t;
@@ -223,6 +242,7 @@ int ConfigParser::ParseTriggers(xml_node<>* pRoot)
 			pTrig->m_sMain = pMain->value();
 			FileExpand(pFile->value(), pTrig->m_sFileName);
 			pTrig->m_sDesc = pDesc->value();
+			pTrig->m_nTimeout = nTimeout;
 			m_vTriggers.push_back(pTrig);
 		}
 	}
@@ -255,7 +275,7 @@ int ConfigParser::ParseStaticModules(xml_node<>* pRoot)
 			m_pLogger->LogWrite(DEBUG_1, MODULE_JFR, LOG_FUNC_STRING, LOG_FUNC_VALUE);
 			continue;
 		}
-		xml_attribute<> *pName, *pType, *pMain, *pFile, *pDesc, *pInput, *pOutput;
+		xml_attribute<> *pName, *pType, *pMain, *pFile, *pDesc, *pInput, *pOutput, *pRefresh;
 		if ((pName = pMod->first_attribute("name")) == NULL ||
 			(pType = pMod->first_attribute("type")) == NULL ||
 			(pMain = pMod->first_attribute("main")) == NULL ||
@@ -269,6 +289,13 @@ int ConfigParser::ParseStaticModules(xml_node<>* pRoot)
 			m_pLogger->LogWrite(DEBUG_1, MODULE_JFR, LOG_FUNC_STRING, LOG_FUNC_VALUE);
 			continue;
 		}
+		else if ((pRefresh = pMod->first_attribute("refresh_interval")) != NULL && !isdigit(pRefresh->value()[0]))		// 可选
+		{
+			m_pLogger->LogWrite(WARNING, MODULE_JFR, "config file format, node <static_module/static_module> attribute refresh_interval should be non-negative integer, static_module name: %s, refresh_interval: %s, file name: %s.", \
+															pName->value(), pRefresh->value(), m_sFilename.c_str());
+			m_pLogger->LogWrite(DEBUG_1, MODULE_JFR, LOG_FUNC_STRING, LOG_FUNC_VALUE);
+			continue;
+		}
 		else
 		{
 			ConfigStaticModule_t* pMod = new ConfigStaticModule_t;
@@ -279,6 +306,7 @@ int ConfigParser::ParseStaticModules(xml_node<>* pRoot)
 			pMod->m_sDesc = pDesc->value();
 			pMod->m_sInput = pInput->value();
 			pMod->m_sOutput = pOutput->value();
+			pMod->m_nRefreshInterval = pRefresh ? atoi(pRefresh->value()) : 0;
 			m_vStaticModules.push_back(pMod);
 		}
 	}
@@ -288,6 +316,146 @@ int ConfigParser::ParseStaticModules(xml_node<>* pRoot)
 	return 0;
 }
 
+/// 可选属性timeout_ms，未配置时不限制
+int ConfigParser::ParseTimeout(xml_node<>* pNode, const char* sLable, unsigned int& nTimeout)
+{
+	xml_attribute<> *pName, *pTimeout;
+
+	assert(pNode && sLable);
+	if ((pTimeout = pNode->first_attribute("timeout_ms")) == NULL)
+	{
+		nTimeout = JFR_DEFAULT_MODULE_TIMEOUT;
+		return 0;
+	}
+	if (!isdigit(pTimeout->value()[0]))
+	{
+		pName = pNode->first_attribute("name");
+		m_pLogger->LogWrite(WARNING, MODULE_JFR, "config file format, node <%s> attribute timeout_ms should be non-negative integer, name: %s, timeout_ms: %s, file name: %s.", \
+														sLable, pName ? pName->value() : "[NULL]", pTimeout->value(), m_sFilename.c_str());
+		m_pLogger->LogWrite(DEBUG_1, MODULE_JFR, LOG_FUNC_STRING, LOG_FUNC_VALUE);
+		return -1;
+	}
+	nTimeout = atoi(pTimeout->value());
+
+	return 0;
+}
+
+/// 可选属性cache、cache_ttl_ms、cache_max_bytes，未配置cache='true'时不缓存
+int ConfigParser::ParseCache(xml_node<>* pNode, const char* sLable, ConfigModule_t& cfgModule)
+{
+	xml_attribute<> *pName, *pAttr;
+
+	assert(pNode && sLable);
+	pName = pNode->first_attribute("name");
+	cfgModule.m_bCache = false;
+	cfgModule.m_nCacheTtl = JFR_DEFAULT_CACHE_TTL;
+	cfgModule.m_nCacheMaxBytes = JFR_DEFAULT_CACHE_MAX_BYTES;
+	if ((pAttr = pNode->first_attribute("cache")) != NULL)
+	{
+		if (strcmp(pAttr->value(), "true") != 0 && strcmp(pAttr->value(), "false") != 0)
+		{
+			m_pLogger->LogWrite(WARNING, MODULE_JFR, "config file format, node <%s> attribute cache should be 'true' or 'false', name: %s, cache: %s, file name: %s.", \
+															sLable, pName ? pName->value() : "[NULL]", pAttr->value(), m_sFilename.c_str());
+			m_pLogger->LogWrite(DEBUG_1, MODULE_JFR, LOG_FUNC_STRING, LOG_FUNC_VALUE);
+			return -1;
+		}
+		cfgModule.m_bCache = strcmp(pAttr->value(), "true") == 0;
+	}
+	if ((pAttr = pNode->first_attribute("cache_ttl_ms")) != NULL)
+	{
+		if (!isdigit(pAttr->value()[0]))
+		{
+			m_pLogger->LogWrite(WARNING, MODULE_JFR, "config file format, node <%s> attribute cache_ttl_ms should be non-negative integer, name: %s, cache_ttl_ms: %s, file name: %s.", \
+															sLable, pName ? pName->value() : "[NULL]", pAttr->value(), m_sFilename.c_str());
+			m_pLogger->LogWrite(DEBUG_1, MODULE_JFR, LOG_FUNC_STRING, LOG_FUNC_VALUE);
+			return -1;
+		}
+		cfgModule.m_nCacheTtl = atoi(pAttr->value());
+	}
+	if ((pAttr = pNode->first_attribute("cache_max_bytes")) != NULL)
+	{
+		if (!isdigit(pAttr->value()[0]) || atoi(pAttr->value()) <= 0)
+		{
+			m_pLogger->LogWrite(WARNING, MODULE_JFR, "config file format, node <%s> attribute cache_max_bytes should be positive integer, name: %s, cache_max_bytes: %s, file name: %s.", \
+															sLable, pName ? pName->value() : "[NULL]", pAttr->value(), m_sFilename.c_str());
+			m_pLogger->LogWrite(DEBUG_1, MODULE_JFR, LOG_FUNC_STRING, LOG_FUNC_VALUE);
+			return -1;
+		}
+		cfgModule.m_nCacheMaxBytes = atoi(pAttr->value());
+	}
+
+	return 0;
+}
+
+/// 常驻进程模块(type='worker')的进程数、请求数上限、应答输出长度上限，均为可选
+int ConfigParser::ParseWorker(xml_node<>* pNode, const char* sLable, ConfigModule_t& cfgModule)
+{
+	xml_attribute<> *pName, *pAttr;
+
+	assert(pNode && sLable);
+	pName = pNode->first_attribute("name");
+	cfgModule.m_nWorkers = JFR_DEFAULT_WORKERS;
+	cfgModule.m_nMaxRequests = JFR_DEFAULT_WORKER_MAX_REQUESTS;
+	cfgModule.m_nMaxReplyBytes = JFR_DEFAULT_WORKER_MAX_REPLY_BYTES;
+	if ((pAttr = pNode->first_attribute("workers")) != NULL)
+	{
+		if (!isdigit(pAttr->value()[0]) || atoi(pAttr->value()) <= 0)
+		{
+			m_pLogger->LogWrite(WARNING, MODULE_JFR, "config file format, node <%s> attribute workers should be positive integer, name: %s, workers: %s, file name: %s.", \
+															sLable, pName ? pName->value() : "[NULL]", pAttr->value(), m_sFilename.c_str());
+			m_pLogger->LogWrite(DEBUG_1, MODULE_JFR, LOG_FUNC_STRING, LOG_FUNC_VALUE);
+			return -1;
+		}
+		cfgModule.m_nWorkers = atoi(pAttr->value());
+	}
+	if ((pAttr = pNode->first_attribute("max_requests")) != NULL)
+	{
+		if (!isdigit(pAttr->value()[0]))
+		{
+			m_pLogger->LogWrite(WARNING, MODULE_JFR, "config file format, node <%s> attribute max_requests should be non-negative integer, name: %s, max_requests: %s, file name: %s.", \
+															sLable, pName ? pName->value() : "[NULL]", pAttr->value(), m_sFilename.c_str());
+			m_pLogger->LogWrite(DEBUG_1, MODULE_JFR, LOG_FUNC_STRING, LOG_FUNC_VALUE);
+			return -1;
+		}
+		cfgModule.m_nMaxRequests = atoi(pAttr->value());
+	}
+	if ((pAttr = pNode->first_attribute("max_reply_bytes")) != NULL)
+	{
+		if (!isdigit(pAttr->value()[0]) || atoi(pAttr->value()) <= 0)
+		{
+			m_pLogger->LogWrite(WARNING, MODULE_JFR, "config file format, node <%s> attribute max_reply_bytes should be positive integer, name: %s, max_reply_bytes: %s, file name: %s.", \
+															sLable, pName ? pName->value() : "[NULL]", pAttr->value(), m_sFilename.c_str());
+			m_pLogger->LogWrite(DEBUG_1, MODULE_JFR, LOG_FUNC_STRING, LOG_FUNC_VALUE);
+			return -1;
+		}
+		cfgModule.m_nMaxReplyBytes = atoi(pAttr->value());
+	}
+
+	return 0;
+}
+
+int ConfigParser::ParseTransport(xml_node<>* pNode, const char* sLable, ConfigModule_t& cfgModule)
+{
+	xml_attribute<> *pName, *pAttr;
+
+	assert(pNode && sLable);
+	pName = pNode->first_attribute("name");
+	cfgModule.m_sTransport = JFR_DEFAULT_TRANSPORT;
+	if ((pAttr = pNode->first_attribute("transport")) != NULL)
+	{
+		if (strcmp(pAttr->value(), "pipe") != 0 && strcmp(pAttr->value(), "shm") != 0)
+		{
+			m_pLogger->LogWrite(WARNING, MODULE_JFR, "config file format, node <%s> attribute transport should be 'pipe' or 'shm', name: %s, transport: %s, file name: %s.", \
+															sLable, pName ? pName->value() : "[NULL]", pAttr->value(), m_sFilename.c_str());
+			m_pLogger->LogWrite(DEBUG_1, MODULE_JFR, LOG_FUNC_STRING, LOG_FUNC_VALUE);
+			return -1;
+		}
+		cfgModule.m_sTransport = pAttr->value();
+	}
+
+	return 0;
+}
+
 int ConfigParser::ParseMainlines(xml_node<>* pRoot)
 {
 	xml_node<>* pXMLNode;
@@ -319,7 +487,7 @@ int ConfigParser::ParseMainlines(xml_node<>* pRoot)
 			pLine = new ConfigMainLine_t;
 			flag = true;
 		}
-		xml_attribute<> *pName, *pDesc, *pInput, *pOutput;
+		xml_attribute<> *pName, *pDesc, *pInput, *pOutput, *pInflight, *pPriority, *pWeight, *pPrewarm;
 		if ((pName = pMod->first_attribute("name")) == NULL ||
 			(pDesc = pMod->first_attribute("desc")) == NULL)
 		{
@@ -333,6 +501,73 @@ int ConfigParser::ParseMainlines(xml_node<>* pRoot)
 			pLine->m_sName = pName->value();
 			pLine->m_sDesc = pDesc->value();
 		}
+		if ((pInflight = pMod->first_attribute("max_inflight")) == NULL)		// 可选，默认值
+		{
+			pLine->m_nMaxInflight = JFR_DEFAULT_LINE_MAX_INFLIGHT;
+		}
+		else if (!isdigit(pInflight->value()[0]) || atoi(pInflight->value()) <= 0)
+		{
+			m_pLogger->LogWrite(WARNING, MODULE_JFR, "config file format, node <main_line/line> attribute max_inflight should be positive integer, line name: %s, max_inflight: %s, file name: %s.", \
+															pLine->m_sName.c_str(), pInflight->value(), m_sFilename.c_str());
+			m_pLogger->LogWrite(DEBUG_1, MODULE_JFR, LOG_FUNC_STRING, LOG_FUNC_VALUE);
+			continue;
+		}
+		else
+		{
+			pLine->m_nMaxInflight = atoi(pInflight->value());
+		}
+		if ((pPriority = pMod->first_attribute("priority")) == NULL)		// 可选，默认值
+		{
+			pLine->m_nPriority = JFR_DEFAULT_LINE_PRIORITY;
+		}
+		else if (!isdigit(pPriority->value()[0]))
+		{
+			m_pLogger->LogWrite(WARNING, MODULE_JFR, "config file format, node <main_line/line> attribute priority should be non-negative integer, line name: %s, priority: %s, file name: %s.", \
+															pLine->m_sName.c_str(), pPriority->value(), m_sFilename.c_str());
+			m_pLogger->LogWrite(DEBUG_1, MODULE_JFR, LOG_FUNC_STRING, LOG_FUNC_VALUE);
+			continue;
+		}
+		else
+		{
+			pLine->m_nPriority = atoi(pPriority->value());
+		}
+		if ((pWeight = pMod->first_attribute("weight")) == NULL)		// 可选，默认值
+		{
+			pLine->m_nWeight = JFR_DEFAULT_LINE_WEIGHT;
+		}
+		else if (!isdigit(pWeight->value()[0]) || atoi(pWeight->value()) <= 0)
+		{
+			m_pLogger->LogWrite(WARNING, MODULE_JFR, "config file format, node <main_line/line> attribute weight should be positive integer, line name: %s, weight: %s, file name: %s.", \
+															pLine->m_sName.c_str(), pWeight->value(), m_sFilename.c_str());
+			m_pLogger->LogWrite(DEBUG_1, MODULE_JFR, LOG_FUNC_STRING, LOG_FUNC_VALUE);
+			continue;
+		}
+		else
+		{
+			pLine->m_nWeight = atoi(pWeight->value());
+		}
+		if ((pPrewarm = pMod->first_attribute("prewarm")) == NULL)		// 可选，默认值
+		{
+			pLine->m_nPrewarm = JFR_DEFAULT_LINE_PREWARM;
+		}
+		else if (!isdigit(pPrewarm->value()[0]))
+		{
+			m_pLogger->LogWrite(WARNING, MODULE_JFR, "config file format, node <main_line/line> attribute prewarm should be non-negative integer, line name: %s, prewarm: %s, file name: %s.", \
+															pLine->m_sName.c_str(), pPrewarm->value(), m_sFilename.c_str());
+			m_pLogger->LogWrite(DEBUG_1, MODULE_JFR, LOG_FUNC_STRING, LOG_FUNC_VALUE);
+			continue;
+		}
+		else
+		{
+			pLine->m_nPrewarm = atoi(pPrewarm->value());
+		}
+		if (pLine->m_nPrewarm > pLine->m_nMaxInflight)		// 同时运行的实例数不超过max_inflight，多余的运行时不会被使用
+		{
+			m_pLogger->LogWrite(WARNING, MODULE_JFR, "config file format, node <main_line/line> attribute prewarm larger than max_inflight, use max_inflight, line name: %s, prewarm: %u, max_inflight: %u, file name: %s.", \
+															pLine->m_sName.c_str(), pLine->m_nPrewarm, pLine->m_nMaxInflight, m_sFilename.c_str());
+			m_pLogger->LogWrite(DEBUG_1, MODULE_JFR, LOG_FUNC_STRING, LOG_FUNC_VALUE);
+			pLine->m_nPrewarm = pLine->m_nMaxInflight;
+		}
 		xml_node<>* pTrig = pMod->first_node("trigger");		// lable <trigger>
 		if (!pTrig)
 		{
@@ -383,6 +618,18 @@ int ConfigParser::ParseMainlines(xml_node<>* pRoot)
 				mod.m_sName = pName->value();
 				mod.m_sInput = pInput->value();
 				mod.m_sOutput = pOutput->value();
+				xml_attribute<>* pStream = pModSub->first_attribute("stream");		// 可选
+				if (pStream)
+				{
+					if (strcmp(pStream->value(), "true") != 0 && strcmp(pStream->value(), "false") != 0)
+					{
+						m_pLogger->LogWrite(WARNING, MODULE_JFR, "config file format, node <main_line/line/module> attribute stream should be 'true' or 'false', line name: %s, module name: %s, stream: %s, file name: %s.", \
+																		pLine->m_sName.c_str(), mod.m_sName.c_str(), pStream->value(), m_sFilename.c_str());
+						m_pLogger->LogWrite(DEBUG_1, MODULE_JFR, LOG_FUNC_STRING, LOG_FUNC_VALUE);
+						continue;
+					}
+					mod.m_bStream = strcmp(pStream->value(), "true") == 0;
+				}
 				xml_node<>* pReq = pModSub->first_node("requirement");		// lable <requirement>
 				if (!pReq)
 				{
@@ -428,6 +675,29 @@ int ConfigParser::ParseMainlines(xml_node<>* pRoot)
 				xml_node<>* pEqu = pModSub->first_node("equivalent");		// lable <equivalent>
 				if (pEqu)
 				{
+					xml_attribute<> *pPolicy, *pDelay;
+					if ((pPolicy = pEqu->first_attribute("policy")) != NULL)		// 可选
+					{
+						mod.m_sEquPolicy = pPolicy->value();
+						if (mod.m_sEquPolicy != JFR_EQUIVALENT_POLICY_HEDGE && mod.m_sEquPolicy != JFR_EQUIVALENT_POLICY_FIRST_WINS)
+						{
+							m_pLogger->LogWrite(WARNING, MODULE_JFR, "config file format, node <main_line/line/module/equivalent> attribute policy should be '%s' or '%s', line name: %s, module name: %s, policy: %s, file name: %s.", \
+																			JFR_EQUIVALENT_POLICY_HEDGE, JFR_EQUIVALENT_POLICY_FIRST_WINS, pLine->m_sName.c_str(), mod.m_sName.c_str(), pPolicy->value(), m_sFilename.c_str());
+							m_pLogger->LogWrite(DEBUG_1, MODULE_JFR, LOG_FUNC_STRING, LOG_FUNC_VALUE);
+							continue;
+						}
+					}
+					if ((pDelay = pEqu->first_attribute("delay_ms")) != NULL)		// 可选，hedge策略使用
+					{
+						if (!isdigit(pDelay->value()[0]))
+						{
+							m_pLogger->LogWrite(WARNING, MODULE_JFR, "config file format, node <main_line/line/module/equivalent> attribute delay_ms should be non-negative integer, line name: %s, module name: %s, delay_ms: %s, file name: %s.", \
+																			pLine->m_sName.c_str(), mod.m_sName.c_str(), pDelay->value(), m_sFilename.c_str());
+							m_pLogger->LogWrite(DEBUG_1, MODULE_JFR, LOG_FUNC_STRING, LOG_FUNC_VALUE);
+							continue;
+						}
+						mod.m_nEquDelay = atoi(pDelay->value());
+					}
 					for (xml_node<>* pModSub2 = pEqu->first_node(); pModSub2; pModSub2 = pModSub2->next_sibling())		// lable <mod>
 					{
 						if (strncmp(pModSub2->name(), "mod", 7) != 0)
@@ -0,0 +1,109 @@
+#include "EventQueue.h"
+
+OPEN_NAMESPACE_JFR
+
+EventQueue::EventQueue(void)
+{
+}
+
+EventQueue::~EventQueue(void)
+{
+	Clear();
+}
+
+void EventQueue::Clear(void)
+{
+	for (size_t i = 0; i < m_vShards.size(); ++i)
+	{
+		delete m_vShards[i];
+	}
+	m_vShards.clear();
+}
+
+/// 调度线程启动前调用
+int EventQueue::Init(size_t shards)
+{
+	assert(shards > 0);
+	Clear();
+	for (size_t i = 0; i < shards; ++i)
+	{
+		m_vShards.push_back(new EventShard_t);
+	}
+
+	return 0;
+}
+
+int EventQueue::Post(size_t shard, Runtime_t* pRuntime, ModContext_t* pCtx, unsigned int type)
+{
+	RuntimeEvent_t event;
+
+	assert(shard < m_vShards.size());
+	event.m_pRuntime = pRuntime;
+	event.m_pCtx = pCtx;
+	event.m_nType = type;
+	EventShard_t* pShard = m_vShards[shard];
+	boost::lock_guard< boost::mutex > guard(pShard->m_oMutex);
+	pShard->m_lEvents.push_back(event);
+	pShard->m_oCond.notify_one();
+
+	return 0;
+}
+
+/// 等待事件，超时时间单位为毫秒；返回取到的事件个数，超时返回0
+size_t EventQueue::Wait(size_t shard, list< RuntimeEvent_t >& lEvents, unsigned int timeout)
+{
+	size_t count;
+	boost::system_time deadline = boost::get_system_time() + boost::posix_time::milliseconds(timeout);
+
+	assert(shard < m_vShards.size());
+	EventShard_t* pShard = m_vShards[shard];
+	boost::mutex::scoped_lock lock(pShard->m_oMutex);
+	while (pShard->m_lEvents.empty())
+	{
+		if (!pShard->m_oCond.timed_wait(lock, deadline))
+		{
+			break;
+		}
+	}
+	count = pShard->m_lEvents.size();
+	lEvents.splice(lEvents.end(), pShard->m_lEvents);
+
+	return count;
+}
+
+/// 标记分片有任务等待线程池空位，其它分片的模块结束时唤醒
+void EventQueue::Starve(size_t shard)
+{
+	assert(shard < m_vShards.size());
+	EventShard_t* pShard = m_vShards[shard];
+	boost::lock_guard< boost::mutex > guard(pShard->m_oMutex);
+	pShard->m_bStarved = true;
+}
+
+/// 向等待线程池空位的分片投递RTE_SLOT_FREE事件，except为产生空位的分片，不重复唤醒
+void EventQueue::WakeStarved(size_t except)
+{
+	RuntimeEvent_t event;
+
+	event.m_pRuntime = NULL;
+	event.m_pCtx = NULL;
+	event.m_nType = RTE_SLOT_FREE;
+	for (size_t i = 0; i < m_vShards.size(); ++i)
+	{
+		if (i == except)
+		{
+			continue;
+		}
+		EventShard_t* pShard = m_vShards[i];
+		boost::lock_guard< boost::mutex > guard(pShard->m_oMutex);
+		if (pShard->m_bStarved)
+		{
+			pShard->m_bStarved = false;
+			pShard->m_lEvents.push_back(event);
+			pShard->m_oCond.notify_one();
+		}
+	}
+}
+
+
+CLOSE_NAMESPACE_JFR
@@ -17,15 +17,15 @@ int LoggerSingleton::Init(int nBaseLevel, const string& sFilePath, const string&
     Switch::Tool::ErrorInfo err;
 
     logcfg.m_vLevels.clear();
-    if (nBaseLevel < 0 || (size_t)nBaseLevel >= sizeof(LoggerSingleton::LogLevels) / sizeof(string*))
+    if (nBaseLevel < 0 || (size_t)nBaseLevel >= sizeof(LoggerSingleton::LogLevels) / sizeof(string))
 	{
 		stringstream ss1, ss2;
-		ss1 << sizeof(LoggerSingleton::LogLevels) / sizeof(string*) << endl;
+		ss1 << sizeof(LoggerSingleton::LogLevels) / sizeof(string) << endl;
 		ss2 << nBaseLevel << endl;
 		cerr << MODULE_JFR"[ERROR]: log base level error, valid base level is [0 ~ " << ss1.str() << "]set base level is " << ss2.str() << endl;
 		return -1;
 	}
-    for (size_t i = 0; i < sizeof(LoggerSingleton::LogLevels) / sizeof(string*); ++i)
+    for (size_t i = 0; i < sizeof(LoggerSingleton::LogLevels) / sizeof(string); ++i)
 	{
 		logcfg.m_vLevels.push_back(LoggerSingleton::LogLevels[i]);
 	}
@@ -2,8 +2,29 @@
 
 OPEN_NAMESPACE_JFR
 
+FlowGeneration_st::~FlowGeneration_st(void)
+{
+	for (size_t i = 0; i < m_vLines.size(); ++i)
+	{
+		delete m_vLines[i];
+	}
+	for (size_t i = 0; i < m_vStaticModules.size(); ++i)
+	{
+		delete m_vStaticModules[i];
+	}
+	if (ModuleManager::is_destroyed())
+	{
+		return;
+	}
+	for (size_t i = 0; i < m_vModules.size(); ++i)
+	{
+		ModuleManager::get_mutable_instance().Release(m_vModules[i]);
+	}
+}
+
 MainlineManager::MainlineManager(void)
 {
+	m_nGeneration = 0;
 	m_bInited = false;
 	m_pModule = NULL;
 	m_pLogger = NULL;
@@ -85,6 +106,12 @@ int MainlineManager::LoadMainlines(const vector< ConfigMainLine_t* >& vCfgMainLi
 		m_pLogger->LogWrite(DEBUG_1, MODULE_JFR, LOG_FUNC_STRING, LOG_FUNC_VALUE);
 		return -1;
 	}
+	if (CompileLines())
+	{
+		m_pLogger->LogWrite(ERROR, MODULE_JFR, "compile mainline failed.");
+		m_pLogger->LogWrite(DEBUG_1, MODULE_JFR, LOG_FUNC_STRING, LOG_FUNC_VALUE);
+		return -1;
+	}
 	m_pLogger->LogWrite(DEBUG_3, MODULE_JFR, "End to load main lines.");
 	m_pLogger->LogWrite(DEBUG_1, MODULE_JFR, LOG_FUNC_STRING, LOG_FUNC_VALUE);
 
@@ -114,6 +141,12 @@ int MainlineManager::LoadStaticModules(const vector< ConfigStaticModule_t* >& vC
 		m_pLogger->LogWrite(DEBUG_1, MODULE_JFR, LOG_FUNC_STRING, LOG_FUNC_VALUE);
 		return -1;
 	}
+	if (CompileStaticArgs())
+	{
+		m_pLogger->LogWrite(ERROR, MODULE_JFR, "compile static module args failed.");
+		m_pLogger->LogWrite(DEBUG_1, MODULE_JFR, LOG_FUNC_STRING, LOG_FUNC_VALUE);
+		return -1;
+	}
 	m_pLogger->LogWrite(DEBUG_3, MODULE_JFR, "End to load static modules.");
 	m_pLogger->LogWrite(DEBUG_1, MODULE_JFR, LOG_FUNC_STRING, LOG_FUNC_VALUE);
 
@@ -313,6 +346,16 @@ int MainlineManager::LoadLineModule(const ConfigModule_t& cfgModule, Line_t* pLi
         }
         pMod->m_vEquivalent.push_back(pTmp);
     }
+    if (cfgModule.m_sEquPolicy == JFR_EQUIVALENT_POLICY_HEDGE)
+	{
+		pMod->m_nEquPolicy = EP_HEDGE;
+	}
+	else if (cfgModule.m_sEquPolicy == JFR_EQUIVALENT_POLICY_FIRST_WINS)
+	{
+		pMod->m_nEquPolicy = EP_FIRST_WINS;
+	}
+	pMod->m_nEquDelay = cfgModule.m_nEquDelay;
+	pMod->m_bStream = cfgModule.m_bStream;
 	m_pLogger->LogWrite(DEBUG_3, MODULE_JFR, "End to load line modules.");
 	m_pLogger->LogWrite(DEBUG_1, MODULE_JFR, LOG_FUNC_STRING, LOG_FUNC_VALUE);
 
@@ -396,6 +439,10 @@ int MainlineManager::LoadLines(const vector< ConfigMainLine_t* >& vCfgMainLines)
 		nMaxModId = 0;
 		pLine->m_sName = vCfgMainLines[i]->m_sName;
 		pLine->m_sDesc = vCfgMainLines[i]->m_sDesc;
+		pLine->m_nMaxInflight = vCfgMainLines[i]->m_nMaxInflight;
+		pLine->m_nPriority = vCfgMainLines[i]->m_nPriority;
+		pLine->m_nWeight = vCfgMainLines[i]->m_nWeight;
+		pLine->m_nPrewarm = vCfgMainLines[i]->m_nPrewarm;
 		if (LoadLineTrigger(vCfgMainLines[i]->m_oTrigger, pLine))
 		{
 			m_pLogger->LogWrite(ERROR, MODULE_JFR, "load line trigger failed, line name: %s.", pLine->m_sName.c_str());
@@ -426,6 +473,7 @@ int MainlineManager::LoadLines(const vector< ConfigMainLine_t* >& vCfgMainLines)
 			}
 		}
 
+		pLine->m_pStats = new ModuleStats("line", pLine->m_sName);
 		m_vLines.push_back(pLine);
 		flag = false;
 	}
@@ -440,6 +488,255 @@ int MainlineManager::LoadLines(const vector< ConfigMainLine_t* >& vCfgMainLines)
 	return 0;
 }
 
+/// 将主线编译为以编号索引的依赖图，逻辑检查通过后调用
+int MainlineManager::CompileLines(void)
+{
+	m_pLogger->LogWrite(DEBUG_3, MODULE_JFR, "Begin to compile lines.");
+	m_pLogger->LogWrite(DEBUG_1, MODULE_JFR, LOG_FUNC_STRING, LOG_FUNC_VALUE);
+	for (size_t i = 0; i < m_vLines.size(); ++i)
+	{
+		if (CompileLine(m_vLines[i]))
+		{
+			m_pLogger->LogWrite(ERROR, MODULE_JFR, "compile line failed, line name: %s.", m_vLines[i]->m_sName.c_str());
+			m_pLogger->LogWrite(DEBUG_1, MODULE_JFR, LOG_FUNC_STRING, LOG_FUNC_VALUE);
+			return -1;
+		}
+	}
+	m_pLogger->LogWrite(DEBUG_3, MODULE_JFR, "End to compile lines.");
+	m_pLogger->LogWrite(DEBUG_1, MODULE_JFR, LOG_FUNC_STRING, LOG_FUNC_VALUE);
+
+	return 0;
+}
+
+int MainlineManager::CompileLine(Line_t* pLine)
+{
+	// 每个模块的必要条件按等效条件编号合并为集合，每个集合在主线内有唯一编号；
+	// 前置模块(或触发器)记录指向后继模块集合的边，运行时只需处理结束模块的后继
+	map< Module_t*, LineModule_t* > mapModules;
+	map< Module_t*, LineModule_t* >::iterator iter;
+	map< LineModule_t*, int >::iterator iter_ptr;
+	map< int, vector< LineModule_t* > >::iterator iter_ids;
+
+	assert(pLine);
+	pLine->m_vTriggerSuccessors.clear();
+	pLine->m_vSlotSizes.clear();
+	pLine->m_vEquGroups.clear();
+	for (size_t i = 0; i < pLine->m_vModules.size(); ++i)
+	{
+		pLine->m_vModules[i]->m_nIndex = i;
+		pLine->m_vModules[i]->m_nSlotNum = 0;
+		pLine->m_vModules[i]->m_nGroup = JFR_LINE_NO_GROUP;
+		pLine->m_vModules[i]->m_vSuccessors.clear();
+		mapModules.insert(make_pair(pLine->m_vModules[i]->m_pModule, pLine->m_vModules[i]));
+	}
+	for (size_t i = 0; i < pLine->m_vModules.size(); ++i)
+	{
+		LineModule_t* pMod = pLine->m_vModules[i];
+		map< int, size_t > mapSlots;		// mod id -> slot
+		set< Module_t* > sReqMods;
+		for (size_t j = 0; j < pMod->m_vRequirement.size(); ++j)
+		{
+			Module_t* pReqMod = pMod->m_vRequirement[j].first;
+			LineEdge_t edge;
+
+			if (sReqMods.find(pReqMod) != sReqMods.end())
+			{
+				continue;
+			}
+			sReqMods.insert(pReqMod);
+			edge.m_nModule = i;
+			edge.m_oRetValue = pMod->m_vRequirement[j].second;
+			if (pReqMod == pLine->m_oTrigger.m_pTrigger)
+			{
+				edge.m_nSlot = pLine->m_vSlotSizes.size();
+				pLine->m_vSlotSizes.push_back(1);
+				++pMod->m_nSlotNum;
+				pLine->m_vTriggerSuccessors.push_back(edge);
+				continue;
+			}
+			iter = mapModules.find(pReqMod);
+			if (iter == mapModules.end())
+			{
+				m_pLogger->LogWrite(ERROR, MODULE_JFR, "requirement module not defined in line modules, line name: %s, module name: %s, req module name: %s.", \
+															pLine->m_sName.c_str(), pMod->m_pModule->m_sName.c_str(), pReqMod->m_sName.c_str());
+				m_pLogger->LogWrite(DEBUG_1, MODULE_JFR, LOG_FUNC_STRING, LOG_FUNC_VALUE);
+				return -1;
+			}
+			iter_ptr = pLine->m_mapModPtr.find(iter->second);
+			assert(iter_ptr != pLine->m_mapModPtr.end());
+			map< int, size_t >::iterator iter_slot = mapSlots.find(iter_ptr->second);
+			if (iter_slot == mapSlots.end())
+			{
+				iter_ids = pLine->m_mapModIds.find(iter_ptr->second);
+				assert(iter_ids != pLine->m_mapModIds.end());
+				edge.m_nSlot = pLine->m_vSlotSizes.size();
+				pLine->m_vSlotSizes.push_back(iter_ids->second.size());
+				++pMod->m_nSlotNum;
+				mapSlots.insert(make_pair(iter_ptr->second, edge.m_nSlot));
+			}
+			else
+			{
+				edge.m_nSlot = iter_slot->second;
+			}
+			iter->second->m_vSuccessors.push_back(edge);
+		}
+	}
+	CompileArgs(pLine);
+	if (CompileEquGroups(pLine))
+	{
+		return -1;
+	}
+
+	return CompileStreams(pLine);
+}
+
+/// 等效组的策略由组内模块配置，未配置的模块沿用其他模块的配置，配置不一致时出错
+int MainlineManager::CompileEquGroups(Line_t* pLine)
+{
+	map< int, vector< LineModule_t* > >::iterator iter_ids, end_ids;
+
+	assert(pLine);
+	end_ids = pLine->m_mapModIds.end();
+	for (iter_ids = pLine->m_mapModIds.begin(); iter_ids != end_ids; ++iter_ids)
+	{
+		const vector< LineModule_t* >& vMods = iter_ids->second;
+		LineEquGroup_t group;
+
+		group.m_nPolicy = EP_NONE;
+		group.m_nDelay = 0;
+		for (size_t i = 0; i < vMods.size(); ++i)
+		{
+			if (vMods[i]->m_nEquPolicy == EP_NONE)
+			{
+				continue;
+			}
+			if (group.m_nPolicy != EP_NONE && (group.m_nPolicy != vMods[i]->m_nEquPolicy || group.m_nDelay != vMods[i]->m_nEquDelay))
+			{
+				m_pLogger->LogWrite(ERROR, MODULE_JFR, "equivalent policy of equivalent modules must be the same, line name: %s, module name: %s.", \
+															pLine->m_sName.c_str(), vMods[i]->m_pModule->m_sName.c_str());
+				m_pLogger->LogWrite(DEBUG_1, MODULE_JFR, LOG_FUNC_STRING, LOG_FUNC_VALUE);
+				return -1;
+			}
+			group.m_nPolicy = vMods[i]->m_nEquPolicy;
+			group.m_nDelay = vMods[i]->m_nEquDelay;
+		}
+		if (group.m_nPolicy == EP_NONE || vMods.size() < 2)
+		{
+			continue;
+		}
+		for (size_t i = 0; i < vMods.size(); ++i)
+		{
+			group.m_vMembers.push_back(vMods[i]->m_nIndex);
+		}
+		sort(group.m_vMembers.begin(), group.m_vMembers.end());
+		for (size_t i = 0; i < vMods.size(); ++i)
+		{
+			vMods[i]->m_nGroup = pLine->m_vEquGroups.size();
+		}
+		pLine->m_vEquGroups.push_back(group);
+	}
+
+	return 0;
+}
+
+/// 连接以流方式运行的模块对，前驱模块运行时同时启动后继模块，前驱的标准输出直接作为后继的标准输入
+// 后继模块(stream='true')必须是进程模块，只有一个入参，为前驱进程模块的出参且不被其他模块使用；必要条件只能是前驱模块；
+// 两者都不能有等效模块、结果缓存或共享内存传递方式；前驱模块不能再以流方式接收入参，即每条流只连接两个模块
+int MainlineManager::CompileStreams(Line_t* pLine)
+{
+	assert(pLine);
+	for (size_t i = 0; i < pLine->m_vModules.size(); ++i)
+	{
+		pLine->m_vModules[i]->m_pStreamTo = NULL;
+	}
+	for (size_t i = 0; i < pLine->m_vModules.size(); ++i)
+	{
+		LineModule_t* pMod = pLine->m_vModules[i];
+		LineModule_t* pPrev = NULL;
+		const char* sReason = NULL;
+
+		if (!pMod->m_bStream)
+		{
+			continue;
+		}
+		if (pMod->m_vInputArgs.size() == 1)
+		{
+			for (size_t j = 0; j < pLine->m_vModules.size() && !pPrev; ++j)
+			{
+				const vector< ModArg_t* >& vOutputArgs = pLine->m_vModules[j]->m_vOutputArgs;
+				if (find(vOutputArgs.begin(), vOutputArgs.end(), pMod->m_vInputArgs[0]) != vOutputArgs.end())
+				{
+					pPrev = pLine->m_vModules[j];
+				}
+			}
+		}
+		if (pPrev == NULL)
+		{
+			sReason = "stream module must have exactly one input arg, which is the output of a line module";
+		}
+		else if (!IS_PRO(pMod->m_pModule->m_nType) || !IS_PRO(pPrev->m_pModule->m_nType) || pMod->m_pModule->m_bShm || pPrev->m_pModule->m_bShm)
+		{
+			sReason = "stream modules must be pro modules with pipe transport";
+		}
+		else if (pMod->m_pModule->m_pCache || pPrev->m_pModule->m_pCache)
+		{
+			sReason = "stream modules can not use result cache";
+		}
+		else if (pPrev->m_bStream || pPrev->m_pStreamTo)
+		{
+			sReason = "stream can only connect two modules";
+		}
+		else if (pLine->m_mapModIds[pLine->m_mapModPtr[pMod]].size() != 1 || pLine->m_mapModIds[pLine->m_mapModPtr[pPrev]].size() != 1)
+		{
+			sReason = "stream modules can not have equivalent modules";
+		}
+		for (size_t j = 0; !sReason && j < pMod->m_vRequirement.size(); ++j)
+		{
+			if (pMod->m_vRequirement[j].first != pPrev->m_pModule)
+			{
+				sReason = "stream module can only require the module it reads from";
+			}
+		}
+		for (size_t j = 0; !sReason && j < pLine->m_vModules.size(); ++j)
+		{
+			const vector< ModArg_t* >& vInputArgs = pLine->m_vModules[j]->m_vInputArgs;
+			if (pLine->m_vModules[j] != pMod && find(vInputArgs.begin(), vInputArgs.end(), pMod->m_vInputArgs[0]) != vInputArgs.end())
+			{
+				sReason = "stream arg can not be used by other modules";
+			}
+		}
+		if (sReason)
+		{
+			m_pLogger->LogWrite(ERROR, MODULE_JFR, "%s, line name: %s, module name: %s.", sReason, pLine->m_sName.c_str(), pMod->m_pModule->m_sName.c_str());
+			m_pLogger->LogWrite(DEBUG_1, MODULE_JFR, LOG_FUNC_STRING, LOG_FUNC_VALUE);
+			return -1;
+		}
+		pPrev->m_pStreamTo = pMod;
+	}
+
+	return 0;
+}
+
+/// 为模块的出入参编号，运行时按下标访问参数表；主线参数在前，引用的静态模块参数接在其后
+void MainlineManager::CompileArgs(Line_t* pLine)
+{
+	map< ModArg_t*, size_t > mapIndexes;
+
+	assert(pLine);
+	pLine->m_vStaticArgs.clear();
+	for (size_t i = 0; i < pLine->m_vArgs.size(); ++i)
+	{
+		mapIndexes.insert(make_pair(pLine->m_vArgs[i], i));
+	}
+	IndexArgs(pLine->m_oTrigger.m_vInputArgs, mapIndexes, pLine->m_vStaticArgs, pLine->m_oTrigger.m_vInputIndexes);
+	IndexArgs(pLine->m_oTrigger.m_vOutputArgs, mapIndexes, pLine->m_vStaticArgs, pLine->m_oTrigger.m_vOutputIndexes);
+	for (size_t i = 0; i < pLine->m_vModules.size(); ++i)
+	{
+		IndexArgs(pLine->m_vModules[i]->m_vInputArgs, mapIndexes, pLine->m_vStaticArgs, pLine->m_vModules[i]->m_vInputIndexes);
+		IndexArgs(pLine->m_vModules[i]->m_vOutputArgs, mapIndexes, pLine->m_vStaticArgs, pLine->m_vModules[i]->m_vOutputIndexes);
+	}
+}
+
 /// 主线流程逻辑合法性检查
 int MainlineManager::LineLogicCheck(void)
 {
@@ -622,9 +919,10 @@ int MainlineManager::LineLogicCheck_Rule4(void)
 					return -1;
 				}
 			}
-			if (IS_PRO(m_vLines[i]->m_vModules[j]->m_pModule->m_nType) && m_vLines[i]->m_vModules[j]->m_vOutputArgs.size() > 1)
+			if ((IS_PRO(m_vLines[i]->m_vModules[j]->m_pModule->m_nType) || IS_WORKER(m_vLines[i]->m_vModules[j]->m_pModule->m_nType)) && \
+				m_vLines[i]->m_vModules[j]->m_vOutputArgs.size() > 1)
 			{
-				m_pLogger->LogWrite(ERROR, MODULE_JFR, "module(type pro) can not have more than one output arg, line name: %s, module name: %s, output args size: %d.", \
+				m_pLogger->LogWrite(ERROR, MODULE_JFR, "module(type pro or worker) can not have more than one output arg, line name: %s, module name: %s, output args size: %d.", \
 															m_vLines[i]->m_sName.c_str(), m_vLines[i]->m_vModules[j]->m_pModule->m_sName.c_str(), m_vLines[i]->m_vModules[j]->m_vOutputArgs.size());
 				m_pLogger->LogWrite(DEBUG_1, MODULE_JFR, LOG_FUNC_STRING, LOG_FUNC_VALUE);
                 return -1;
@@ -809,6 +1107,7 @@ int MainlineManager::LoadModules(const vector< ConfigStaticModule_t* >& vCfgStat
         }
 
         pMod->m_sName = vCfgStaticModules[i]->m_sName;
+        pMod->m_nRefreshInterval = vCfgStaticModules[i]->m_nRefreshInterval;
         pMod->m_oModule.m_pModule = (StaticModule_t*)m_pModule->GetStaticModule(vCfgStaticModules[i]->m_sName);
         if (pMod->m_oModule.m_pModule == NULL)
         {
@@ -901,6 +1200,32 @@ int MainlineManager::ModuleLogicCheck(void)
 	return 0;
 }
 
+/// 为静态模块的出入参编号，静态模块只使用自身的参数
+int MainlineManager::CompileStaticArgs(void)
+{
+	for (size_t i = 0; i < m_vStaticModules.size(); ++i)
+	{
+		LineStaticModule_t* pMod = m_vStaticModules[i];
+		map< ModArg_t*, size_t > mapIndexes;
+		vector< ModArg_t* > vExternArgs;
+
+		for (size_t j = 0; j < pMod->m_vArgs.size(); ++j)
+		{
+			mapIndexes.insert(make_pair(pMod->m_vArgs[j], j));
+		}
+		IndexArgs(pMod->m_oModule.m_vInputArgs, mapIndexes, vExternArgs, pMod->m_oModule.m_vInputIndexes);
+		IndexArgs(pMod->m_oModule.m_vOutputArgs, mapIndexes, vExternArgs, pMod->m_oModule.m_vOutputIndexes);
+		if (!vExternArgs.empty())
+		{
+			m_pLogger->LogWrite(ERROR, MODULE_JFR, "static module uses args of other static modules, static module name: %s, arg: %s.", 														pMod->m_sName.c_str(), vExternArgs[0]->m_sName.c_str());
+			m_pLogger->LogWrite(DEBUG_1, MODULE_JFR, LOG_FUNC_STRING, LOG_FUNC_VALUE);
+			return -1;
+		}
+	}
+
+	return 0;
+}
+
 int MainlineManager::ParseArgs(const string& args, vector< ModArg_t* >& vAllArgs, vector< ModArg_t* >& vModArgs)
 {
 	const char *pBegin, *pEnd, *pArgHead, *pArgTail, *p;
@@ -1000,6 +1325,24 @@ int MainlineManager::TrimQuote(string& str)
 	return flag ? 1 : 0;
 }
 
+/// 取参数在参数表中的下标，不在mapIndexes中的参数追加到vExternArgs并编号
+void MainlineManager::IndexArgs(const vector< ModArg_t* >& vModArgs, map< ModArg_t*, size_t >& mapIndexes, vector< ModArg_t* >& vExternArgs, vector< size_t >& vIndexes)
+{
+	map< ModArg_t*, size_t >::iterator iter;
+
+	vIndexes.clear();
+	for (size_t i = 0; i < vModArgs.size(); ++i)
+	{
+		iter = mapIndexes.find(vModArgs[i]);
+		if (iter == mapIndexes.end())
+		{
+			iter = mapIndexes.insert(make_pair(vModArgs[i], mapIndexes.size())).first;
+			vExternArgs.push_back(vModArgs[i]);
+		}
+		vIndexes.push_back(iter->second);
+	}
+}
+
 ModArg_t* MainlineManager::FindArg(const string& strArg, const vector< ModArg_t* >& vAllArgs)
 {
 	for(size_t i = 0; i < vAllArgs.size(); ++i)
@@ -1019,14 +1362,20 @@ int MainlineManager::PushArg(const string& strArg, vector< ModArg_t* >& vAllArgs
 	ModArg_t *pArg = NULL;
 	assert(type == AT_INVALID || type == AT_STRING || type == AT_VARIABLE);
 
-    for (size_t i = 0; i < m_vStaticModules.size(); ++i)
+	if (type == AT_INVALID)
+	{
+		type = strArg[0] == '$' ? AT_VARIABLE : AT_STRING;
+	}
+	/// 只有变量引用静态模块的参数，字符串参数各自持有
+    for (size_t i = 0; type == AT_VARIABLE && i < m_vStaticModules.size(); ++i)
     {
         assert(m_vStaticModules[i]);
         pArg = FindArg(strArg, m_vStaticModules[i]->m_vArgs);
-        if (pArg)
+        if (pArg && pArg->m_nType == AT_VARIABLE)
 		{
 			break;
 		}
+		pArg = NULL;
     }
     if (!pArg)
 	{
@@ -1036,18 +1385,7 @@ int MainlineManager::PushArg(const string& strArg, vector< ModArg_t* >& vAllArgs
 	{
         pArg = new ModArg_t;
         pArg->m_sName = strArg;
-        if (type != AT_INVALID)
-        {
-            pArg->m_nType = type;
-        }
-        else if (strArg[0] == '$')
-        {
-            pArg->m_nType = AT_VARIABLE;
-        }
-        else
-        {
-            pArg->m_nType = AT_STRING;
-        }
+        pArg->m_nType = type;
         vAllArgs.push_back(pArg);
 	}
 	vModArgs.push_back(pArg);
@@ -1055,6 +1393,22 @@ int MainlineManager::PushArg(const string& strArg, vector< ModArg_t* >& vAllArgs
     return 0;
 }
 
+/// 将已加载的主线、静态模块移交给新的一代，并引用当前加载的模块
+FlowGenerationPtr MainlineManager::TakeGeneration(void)
+{
+	FlowGenerationPtr pGeneration(new FlowGeneration_t);
+
+	pGeneration->m_nGeneration = ++m_nGeneration;
+	pGeneration->m_vLines.swap(m_vLines);
+	pGeneration->m_vStaticModules.swap(m_vStaticModules);
+	m_pModule->RetainAll(pGeneration->m_vModules);
+	m_pLogger->LogWrite(DEBUG_3, MODULE_JFR, "New flow generation: %lu, lines: %lu, static modules: %lu, modules: %lu.", (unsigned long)pGeneration->m_nGeneration, \
+											(unsigned long)pGeneration->m_vLines.size(), (unsigned long)pGeneration->m_vStaticModules.size(), (unsigned long)pGeneration->m_vModules.size());
+	m_pLogger->LogWrite(DEBUG_1, MODULE_JFR, LOG_FUNC_STRING, LOG_FUNC_VALUE);
+
+	return pGeneration;
+}
+
 const vector< Line_t* >& MainlineManager::GetMainLines(void) const
 {
     return m_vLines;
@@ -3,7 +3,11 @@
 OPEN_NAMESPACE_JFR
 
 ThreadPool* ModuleCaller::pool = &ThreadPool::get_mutable_instance();
+EventQueue* ModuleCaller::events = &EventQueue::get_mutable_instance();
+Watchdog* ModuleCaller::watchdog = &Watchdog::get_mutable_instance();
+ProcessReactor* ModuleCaller::reactor = &ProcessReactor::get_mutable_instance();
 jfr::LoggerSingleton* ModuleCaller::logger = &jfr::LoggerSingleton::get_mutable_instance();
+boost::thread_specific_ptr< map< unsigned long, void* > >* ModuleCaller::threadStates = new boost::thread_specific_ptr< map< unsigned long, void* > >;		// 不释放，线程退出时释放各自的map
 
 int ModuleCaller::Call(StaticRuntime_t* pRuntime)
 {
@@ -29,18 +33,18 @@ int ModuleCaller::CallStaticModule(StaticRuntime_t* pRuntime)
 	{
 		ret = CallPro(pRuntime->m_pStaticModule->m_oModule.m_pModule, \
 						pRuntime->m_pCtx, \
-						pRuntime->m_pStaticModule->m_oModule.m_vInputArgs, \
-						pRuntime->m_pStaticModule->m_oModule.m_vOutputArgs, \
-						pRuntime->m_mapArgs);
+						&pRuntime->m_pStaticModule->m_oModule.m_vInputIndexes, \
+						&pRuntime->m_pStaticModule->m_oModule.m_vOutputIndexes, \
+						pRuntime->ArgTable());
 		return ret;
 	}
 	else if (IS_SO(pRuntime->m_pStaticModule->m_oModule.m_pModule->m_nType))
 	{
 		ret = CallSo(pRuntime->m_pStaticModule->m_oModule.m_pModule, \
 					pRuntime->m_pCtx, \
-					pRuntime->m_pStaticModule->m_oModule.m_vInputArgs, \
-					pRuntime->m_pStaticModule->m_oModule.m_vOutputArgs, \
-					pRuntime->m_mapArgs);
+					&pRuntime->m_pStaticModule->m_oModule.m_vInputIndexes, \
+					&pRuntime->m_pStaticModule->m_oModule.m_vOutputIndexes, \
+					pRuntime->ArgTable());
 		return ret;
 	}
 	else
@@ -55,47 +59,66 @@ int ModuleCaller::CallStaticModule(StaticRuntime_t* pRuntime)
 int ModuleCaller::CallModule(Runtime_t* pRuntime, LineModule_t* pModule)
 {
 	bool ret;
-	map< LineModule_t*, ModContext_t* >::iterator iter;
 	ModContext_t* pCtx;
 
 	assert(pRuntime->m_pLine && pModule->m_pModule);
-    iter = pRuntime->m_mapModCtxs.find(pModule);
-    if (iter == pRuntime->m_mapModCtxs.end())
+    if (pModule->m_nIndex >= pRuntime->m_vModCtxs.size())
     {
     	logger->LogWrite(FATAL, MODULE_JFR, LOG_FUNC_STRING, LOG_FUNC_VALUE);
         assert(0);
     }
-    pCtx = iter->second;
+    pCtx = pRuntime->m_vModCtxs[pModule->m_nIndex];
     assert(pCtx);
-	if (IS_PRO(pModule->m_pModule->m_nType))
+	if (IS_PRO(pModule->m_pModule->m_nType) && pModule->m_bStream)		// 已由前驱模块同时运行，见CallStream
 	{
-		SJob job(&ModuleCaller::CallPro, pModule->m_pModule, pCtx, pModule->m_vInputArgs, pModule->m_vOutputArgs, pRuntime->m_mapArgs);
-		ret = pool->add_job_block(job);
-		if (!ret)
+		if (!pCtx->m_bStreamed)		// 前驱模块未能运行，按模块出错传递
 		{
-			pCtx->m_oMutex.lock();
-			pCtx->m_nStat = RTS_SYSERROR;
-			pCtx->m_oMutex.unlock();
-			logger->LogWrite(ERROR, MODULE_JFR, "add job failed, module name: %s, line name: %s.", pModule->m_pModule->m_sName.c_str(), pRuntime->m_pLine->m_sName.c_str());
+			pCtx->m_nStat.store(RTS_ERROR, boost::memory_order_release);
+			Notify(pModule->m_pModule, pCtx);
+			logger->LogWrite(ERROR, MODULE_JFR, "stream module has no result, module name: %s.", pModule->m_pModule->m_sName.c_str());
 			logger->LogWrite(DEBUG_1, MODULE_JFR, LOG_FUNC_STRING, LOG_FUNC_VALUE);
-			return -1;
+			return 0;
 		}
+		pCtx->m_nStat.store(RTS_FINISH, boost::memory_order_release);
+		Notify(pModule->m_pModule, pCtx);
 		return 0;
 	}
-	else if (IS_SO(pModule->m_pModule->m_nType))
+	else if (IS_PRO(pModule->m_pModule->m_nType) && pModule->m_pStreamTo)
+	{
+		SJob job(&ModuleCaller::CallStream, pRuntime, pModule);
+		pCtx->m_nSubmit = ModuleStats::Now();
+		ret = pool->add_job_nonblock(job);
+		return ret ? 0 : 1;
+	}
+	else if (IS_PRO(pModule->m_pModule->m_nType))
 	{
-		SJob job(&ModuleCaller::CallSo, pModule->m_pModule, pCtx, pModule->m_vInputArgs, pModule->m_vOutputArgs, pRuntime->m_mapArgs);
-		ret = pool->add_job_block(job);
-		if (!ret)
+		if (pModule->m_pModule->m_pCache && CallCached(pModule->m_pModule, pCtx, &pModule->m_vInputIndexes, &pModule->m_vOutputIndexes, pRuntime->ArgTable()) == 0)
 		{
-			pCtx->m_oMutex.lock();
-			pCtx->m_nStat = RTS_SYSERROR;
-			pCtx->m_oMutex.unlock();
-			logger->LogWrite(ERROR, MODULE_JFR, "add job failed, module name: %s, line name: %s.", pModule->m_pModule->m_sName.c_str(), pRuntime->m_pLine->m_sName.c_str());
-			logger->LogWrite(DEBUG_1, MODULE_JFR, LOG_FUNC_STRING, LOG_FUNC_VALUE);
-			return -1;
+			return 0;
 		}
-		return 0;
+		SJob job(pModule->m_pModule->m_bShm ? &ModuleCaller::CallProShm : &ModuleCaller::CallPro, \
+				pModule->m_pModule, pCtx, &pModule->m_vInputIndexes, &pModule->m_vOutputIndexes, pRuntime->ArgTable());
+		pCtx->m_nSubmit = ModuleStats::Now();
+		ret = pool->add_job_nonblock(job);
+		return ret ? 0 : 1;
+	}
+	else if (IS_WORKER(pModule->m_pModule->m_nType))
+	{
+		if (pModule->m_pModule->m_pCache && CallCached(pModule->m_pModule, pCtx, &pModule->m_vInputIndexes, &pModule->m_vOutputIndexes, pRuntime->ArgTable()) == 0)
+		{
+			return 0;
+		}
+		SJob job(&ModuleCaller::CallWorker, pModule->m_pModule, pCtx, &pModule->m_vInputIndexes, &pModule->m_vOutputIndexes, pRuntime->ArgTable());
+		pCtx->m_nSubmit = ModuleStats::Now();
+		ret = pool->add_job_nonblock(job);
+		return ret ? 0 : 1;
+	}
+	else if (IS_SO(pModule->m_pModule->m_nType))
+	{
+		SJob job(&ModuleCaller::CallSo, pModule->m_pModule, pCtx, &pModule->m_vInputIndexes, &pModule->m_vOutputIndexes, pRuntime->ArgTable());
+		pCtx->m_nSubmit = ModuleStats::Now();
+		ret = pool->add_job_nonblock(job);
+		return ret ? 0 : 1;
 	}
 	else
 	{
@@ -116,40 +139,24 @@ int ModuleCaller::CallTrigger(Runtime_t* pRuntime)
 		SJob job(&ModuleCaller::CallPro, \
 				pRuntime->m_pLine->m_oTrigger.m_pTrigger, \
 				pRuntime->m_pTriggerCtx, \
-				pRuntime->m_pLine->m_oTrigger.m_vInputArgs, \
-				pRuntime->m_pLine->m_oTrigger.m_vOutputArgs, \
-				pRuntime->m_mapArgs);
-		ret = pool->add_job_block(job);
-		if (!ret)
-		{
-			pRuntime->m_pTriggerCtx->m_oMutex.lock();
-			pRuntime->m_pTriggerCtx->m_nStat = RTS_SYSERROR;
-			pRuntime->m_pTriggerCtx->m_oMutex.unlock();
-			logger->LogWrite(ERROR, MODULE_JFR, "add job failed, module name: %s, line name: %s.", pRuntime->m_pLine->m_oTrigger.m_pTrigger->m_sName.c_str(), pRuntime->m_pLine->m_sName.c_str());
-			logger->LogWrite(DEBUG_1, MODULE_JFR, LOG_FUNC_STRING, LOG_FUNC_VALUE);
-			return -1;
-		}
-		return 0;
+				&pRuntime->m_pLine->m_oTrigger.m_vInputIndexes, \
+				&pRuntime->m_pLine->m_oTrigger.m_vOutputIndexes, \
+				pRuntime->ArgTable());
+		pRuntime->m_pTriggerCtx->m_nSubmit = ModuleStats::Now();
+		ret = pool->add_job_nonblock(job);
+		return ret ? 0 : 1;
 	}
 	else if (IS_SO(pRuntime->m_pLine->m_oTrigger.m_pTrigger->m_nType))
 	{
 		SJob job(&ModuleCaller::CallSo, \
 				pRuntime->m_pLine->m_oTrigger.m_pTrigger, \
 				pRuntime->m_pTriggerCtx, \
-				pRuntime->m_pLine->m_oTrigger.m_vInputArgs, \
-				pRuntime->m_pLine->m_oTrigger.m_vOutputArgs, \
-				pRuntime->m_mapArgs);
-		ret = pool->add_job_block(job);
-		if (!ret)
-		{
-			pRuntime->m_pTriggerCtx->m_oMutex.lock();
-			pRuntime->m_pTriggerCtx->m_nStat = RTS_SYSERROR;
-			pRuntime->m_pTriggerCtx->m_oMutex.unlock();
-			logger->LogWrite(ERROR, MODULE_JFR, "add job failed, module name: %s, line name: %s.", pRuntime->m_pLine->m_oTrigger.m_pTrigger->m_sName.c_str(), pRuntime->m_pLine->m_sName.c_str());
-			logger->LogWrite(DEBUG_1, MODULE_JFR, LOG_FUNC_STRING, LOG_FUNC_VALUE);
-			return -1;
-		}
-		return 0;
+				&pRuntime->m_pLine->m_oTrigger.m_vInputIndexes, \
+				&pRuntime->m_pLine->m_oTrigger.m_vOutputIndexes, \
+				pRuntime->ArgTable());
+		pRuntime->m_pTriggerCtx->m_nSubmit = ModuleStats::Now();
+		ret = pool->add_job_nonblock(job);
+		return ret ? 0 : 1;
 	}
 	else
 	{
@@ -160,33 +167,22 @@ int ModuleCaller::CallTrigger(Runtime_t* pRuntime)
 	return 0;
 }
 
-int ModuleCaller::CallPro(Module_t* pMod, ModContext_t* pCtx, const vector< ModArg_t* >& vInput, const vector< ModArg_t* >& vOutput, map< ModArg_t*, ArgValue_t* >& mapArg)
+int ModuleCaller::CallPro(Module_t* pMod, ModContext_t* pCtx, const vector< size_t >* pInput, const vector< size_t >* pOutput, ArgValue_t** ppArgs)
 {
 	pid_t pid;
 	int fd[2];
 	int ret;
-	map< ModArg_t*, ArgValue_t* >::iterator iter, end;
 	char** ppArgValIn;
 	ArgValue_t* pArgValOut;
+	const vector< size_t >& vInput = *pInput;
+	const vector< size_t >& vOutput = *pOutput;
 
-	StaticModuleArgSet* pSMASet = &StaticModuleArgSet::get_mutable_instance();
-	end = mapArg.end();
-	ppArgValIn = (char**)malloc((vInput.size() + 2) * sizeof(char*));
+	assert(pCtx->m_pArena);
+	ppArgValIn = (char**)pCtx->m_pArena->Alloc((vInput.size() + 2) * sizeof(char*));
 	ppArgValIn[0] = (char*)pMod->m_sFileName.c_str();
 	for(size_t i = 0; i < vInput.size(); ++i)
 	{
-		ArgValue_t* p;
-		iter = mapArg.find(vInput[i]);
-		if (iter != end)
-		{
-			p = iter->second;
-		}
-		else if ((p = pSMASet->GetElement(vInput[i])) == NULL)
-		{
-			logger->LogWrite(FATAL, MODULE_JFR, LOG_FUNC_STRING, LOG_FUNC_VALUE);
-            assert(0);
-		}
-		ppArgValIn[i + 1] = (char*)p->m_pValue;
+		ppArgValIn[i + 1] = (char*)ppArgs[vInput[i]]->m_pValue;
 	}
 	ppArgValIn[vInput.size() + 1] = NULL;
 	if (vOutput.size() > 1)
@@ -194,178 +190,840 @@ int ModuleCaller::CallPro(Module_t* pMod, ModContext_t* pCtx, const vector< ModA
 		logger->LogWrite(FATAL, MODULE_JFR, LOG_FUNC_STRING, LOG_FUNC_VALUE);
 		assert(0);
 	}
-	if (vOutput.size() == 1)
+	pArgValOut = vOutput.size() == 1 ? ppArgs[vOutput[0]] : NULL;
+
+	Begin(pMod, pCtx);
+	if (pipe2(fd, O_CLOEXEC))		// 并发启动的子进程不持有彼此的管道写端
+	{
+		pCtx->m_nStat.store(RTS_SYSERROR, boost::memory_order_release);
+		Notify(pMod, pCtx);
+		logger->LogWrite(ERROR, MODULE_JFR, "make pipe failed, %s, errno: %d.", strerror(errno), errno);
+		logger->LogWrite(DEBUG_1, MODULE_JFR, LOG_FUNC_STRING, LOG_FUNC_VALUE);
+		return -1;
+	}
+	pid = Spawn(pMod->m_sFileName, ppArgValIn, -1, fd[1]);
+	close(fd[1]);
+	if (pid == -1)
 	{
-		iter = mapArg.find(vOutput[0]);
-		if (iter == end)
+		int err = errno;
+		close(fd[0]);
+		pCtx->m_nStat.store(RTS_SYSERROR, boost::memory_order_release);
+		Notify(pMod, pCtx);
+		logger->LogWrite(ERROR, MODULE_JFR, "spawn process failed, file name: %s, %s, errno: %d.", pMod->m_sFileName.c_str(), strerror(err), err);
+		logger->LogWrite(DEBUG_1, MODULE_JFR, LOG_FUNC_STRING, LOG_FUNC_VALUE);
+		return -1;
+	}
+	else
+	{
+        char* buf = NULL;
+        size_t len = 0;
+        int pidfd;
+
+        pCtx->m_nPid = pid;
+        if (pCtx->m_oEnv.m_nCanceled)		// 登记进程号前已被取消，取消方与此处先写后读，至少一方能看到对方的写入
 		{
-			logger->LogWrite(FATAL, MODULE_JFR, LOG_FUNC_STRING, LOG_FUNC_VALUE);
-			assert(0);
+			kill(-pid, SIGKILL);
+		}
+        if (pMod->m_nTimeout > 0)
+		{
+			watchdog->Watch(pCtx, pMod->m_nTimeout);
+		}
+        /// 主线模块和触发器交给反应器等待，线程池线程立即返回；静态模块同步调用，调用者需要返回时已结束
+        if (pCtx->m_pRuntime && (pidfd = ProcessReactor::OpenPidFd(pid)) != -1)
+		{
+			ProCall_t* pCall = new ProCall_t;
+			pCall->m_nPid = pid;
+			pCall->m_nPidFd = pidfd;
+			pCall->m_nFd = fd[0];
+			pCall->m_pArena = pCtx->m_pArena;
+			pCall->m_pDone = &ModuleCaller::ProDone;
+			pCall->m_pModule = pMod;
+			pCall->m_pCtx = pCtx;
+			pCall->m_pInput = pInput;
+			pCall->m_pArgValOut = pArgValOut;
+			pCall->m_ppArgs = ppArgs;
+			fcntl(fd[0], F_SETFL, fcntl(fd[0], F_GETFL) | O_NONBLOCK);
+			if (reactor->Add(pCall) == 0)
+			{
+				events->WakeStarved(pCtx->m_pRuntime->m_pLine->m_nShard);		// 线程池线程已空闲
+				return 0;
+			}
+			fcntl(fd[0], F_SETFL, fcntl(fd[0], F_GETFL) & ~O_NONBLOCK);
+			close(pidfd);
+			delete pCall;
 		}
-		pArgValOut = iter->second;
+        buf = Read(fd[0], pCtx->m_pArena, len);
+        close(fd[0]);
+        ret = Wait(pid, pCtx);
+        return FinishPro(pMod, pCtx, vInput, pArgValOut, ppArgs, buf, len, ret);
 	}
-	else
+
+	return 0;
+}
+
+/// 进程模块子进程结束后完成调用，写出参、缓存结果并通知调度线程
+int ModuleCaller::FinishPro(Module_t* pMod, ModContext_t* pCtx, const vector< size_t >& vInput, ArgValue_t* pArgValOut, ArgValue_t** ppArgs, char* buf, size_t len, int ret)
+{
+	unsigned int canceled;
+
+	if ((canceled = End(pMod, pCtx)) != 0)		// timeout or canceled
+	{
+		pCtx->m_nStat.store(canceled, boost::memory_order_release);
+		Notify(pMod, pCtx);
+		return -1;
+	}
+	/// 先写输出参数再置结束状态，后继模块看到finish时输出已就绪
+	if (pArgValOut)
+	{
+		if (pArgValOut->m_pValue)
+		{
+			pArgValOut->Free();
+		}
+		pArgValOut->m_pValue = (void*)buf;		// 属于运行时的内存区，不单独释放
+		pArgValOut->m_nLength = len;
+		pArgValOut->m_nType = AVT_BINARY;
+	}
+	if (pMod->m_pCache)
 	{
-		pArgValOut = NULL;
+		string key;
+		CacheKey(vInput, ppArgs, key);
+		if (pArgValOut)
+		{
+			pMod->m_pCache->Store(key, ret, (const char*)pArgValOut->m_pValue, pArgValOut->m_nLength, pArgValOut->m_nType);
+		}
+		else
+		{
+			pMod->m_pCache->Store(key, ret, NULL, 0, AVT_UNKNOWN);
+		}
 	}
+	pCtx->m_nRetValue = ret;
+	pCtx->m_nStat.store(RTS_FINISH, boost::memory_order_release);
+	Notify(pMod, pCtx);
+
+	return 0;
+}
+
+/// 反应器线程中调用，子进程已退出，回收后完成调用
+void ModuleCaller::ProDone(ProcWatch_t* pWatch)
+{
+	ProCall_t* pCall = static_cast< ProCall_t* >(pWatch);
+	int ret;
+
+	ret = Wait(pCall->m_nPid, pCall->m_pCtx);
+	FinishPro(pCall->m_pModule, pCall->m_pCtx, *pCall->m_pInput, pCall->m_pArgValOut, pCall->m_ppArgs, pCall->m_pBuf, pCall->m_nLength, ret);
+	delete pCall;
+}
 
-	if (pipe(fd))
+/// 同时运行以流方式连接的两个进程模块，前驱模块的标准输出为后继模块的标准输入，只读取后继模块的输出
+// 后继模块与前驱模块在同一进程组，超时或取消时一起结束，使用前驱模块的超时时间；前驱模块的出参不生成
+// 后继模块的返回值和出参写入其上下文，调度线程满足其必要条件后直接结束，前驱返回值不满足时丢弃
+int ModuleCaller::CallStream(Runtime_t* pRuntime, LineModule_t* pModule)
+{
+	pid_t pid, pidNext;
+	int fd[2], out[2];
+	int ret, status;
+	unsigned int canceled;
+	char** ppArgValIn;
+	char* argvNext[2];
+	char* buf;
+	size_t len;
+	struct rusage ru;
+	Module_t* pMod;
+	ModContext_t* pCtx;
+	LineModule_t* pNext;
+	ModContext_t* pNextCtx;
+	ArgValue_t** ppArgs;
+
+	pNext = pModule->m_pStreamTo;
+	assert(pNext && pNext->m_nIndex < pRuntime->m_vModCtxs.size());
+	pMod = pModule->m_pModule;
+	pCtx = pRuntime->m_vModCtxs[pModule->m_nIndex];
+	pNextCtx = pRuntime->m_vModCtxs[pNext->m_nIndex];
+	ppArgs = pRuntime->ArgTable();
+	assert(pCtx->m_pArena);
+	ppArgValIn = (char**)pCtx->m_pArena->Alloc((pModule->m_vInputIndexes.size() + 2) * sizeof(char*));
+	ppArgValIn[0] = (char*)pMod->m_sFileName.c_str();
+	for(size_t i = 0; i < pModule->m_vInputIndexes.size(); ++i)
 	{
-		pCtx->m_oMutex.lock();
-		pCtx->m_nStat = RTS_SYSERROR;
-		pCtx->m_oMutex.unlock();
-		free(ppArgValIn);
-		logger->LogWrite(ERROR, MODULE_JFR, "make pipe failed, %s, errno: %d.", strerror(errno), errno);
+		ppArgValIn[i + 1] = (char*)ppArgs[pModule->m_vInputIndexes[i]]->m_pValue;
+	}
+	ppArgValIn[pModule->m_vInputIndexes.size() + 1] = NULL;
+	argvNext[0] = (char*)pNext->m_pModule->m_sFileName.c_str();
+	argvNext[1] = NULL;
+
+	/// 创建管道或启动进程失败按本模块出错结束，后继模块的必要条件随之不满足，由调度线程置为error
+	Begin(pMod, pCtx);
+	if (pipe2(fd, O_CLOEXEC))
+	{
+		int err = errno;
+		End(pMod, pCtx);
+		pCtx->m_nStat.store(RTS_ERROR, boost::memory_order_release);
+		Notify(pMod, pCtx);
+		logger->LogWrite(ERROR, MODULE_JFR, "make pipe failed, %s, errno: %d.", strerror(err), err);
 		logger->LogWrite(DEBUG_1, MODULE_JFR, LOG_FUNC_STRING, LOG_FUNC_VALUE);
 		return -1;
 	}
-	pid = fork();
-	if (pid == -1)
+	if (pipe2(out, O_CLOEXEC))
 	{
-		pCtx->m_oMutex.lock();
-		pCtx->m_nStat = RTS_SYSERROR;
-		pCtx->m_oMutex.unlock();
-		free(ppArgValIn);
-		logger->LogWrite(ERROR, MODULE_JFR, "fork process failed, %s, errno: %d.", strerror(errno), errno);
+		int err = errno;
+		close(fd[0]);
+		close(fd[1]);
+		End(pMod, pCtx);
+		pCtx->m_nStat.store(RTS_ERROR, boost::memory_order_release);
+		Notify(pMod, pCtx);
+		logger->LogWrite(ERROR, MODULE_JFR, "make pipe failed, %s, errno: %d.", strerror(err), err);
 		logger->LogWrite(DEBUG_1, MODULE_JFR, LOG_FUNC_STRING, LOG_FUNC_VALUE);
 		return -1;
 	}
-	else if (pid == 0)		// child
+	pid = Spawn(pMod->m_sFileName, ppArgValIn, -1, fd[1]);
+	close(fd[1]);
+	pidNext = -1;
+	if (pid != -1)
 	{
-		close(fd[0]);
-		dup2(fd[1], 1);
-		if (fd[1] != 1)
+		pidNext = Spawn(pNext->m_pModule->m_sFileName, argvNext, fd[0], out[1], NULL, 0, pid);
+	}
+	close(fd[0]);
+	close(out[1]);
+	if (pid == -1 || pidNext == -1)
+	{
+		int err = errno;
+		close(out[0]);
+		if (pid != -1)
 		{
-			close(fd[1]);
+			kill(-pid, SIGKILL);
+			while (waitpid(pid, &status, 0) == -1 && errno == EINTR)
+			{
+			}
 		}
-        execv(pMod->m_sFileName.c_str(), ppArgValIn);
-		logger->LogWrite(ERROR, MODULE_JFR, "child: exec process failed, %s, errno: %d.", strerror(errno), errno);
+		End(pMod, pCtx);
+		pCtx->m_nStat.store(RTS_ERROR, boost::memory_order_release);
+		Notify(pMod, pCtx);
+		logger->LogWrite(ERROR, MODULE_JFR, "spawn process failed, file name: %s, %s, errno: %d.", \
+												(pid == -1 ? pMod : pNext->m_pModule)->m_sFileName.c_str(), strerror(err), err);
 		logger->LogWrite(DEBUG_1, MODULE_JFR, LOG_FUNC_STRING, LOG_FUNC_VALUE);
-		cout << JFR_CALLPRO_ERROR_STRING;
-		return JFR_CALLPRO_ERROR_NO;
+		return -1;
 	}
-	else	// parent
+	pCtx->m_nPid = pid;		// 进程组号，kill时同时结束后继模块
+	if (pCtx->m_oEnv.m_nCanceled)		// 登记进程号前已被取消，取消方与此处先写后读，至少一方能看到对方的写入
 	{
-        char* buf = NULL;
+		kill(-pid, SIGKILL);
+	}
+	if (pMod->m_nTimeout > 0)
+	{
+		watchdog->Watch(pCtx, pMod->m_nTimeout);
+	}
+	len = 0;
+	buf = Read(out[0], pCtx->m_pArena, len);
+	close(out[0]);
+	/// 先回收后继模块，前驱模块未回收前进程组号不会被复用
+	while (wait4(pidNext, &status, 0, &ru) == -1)
+	{
+		if (errno != EINTR)
+		{
+			logger->LogWrite(ERROR, MODULE_JFR, "wait process failed, %s, errno: %d.", strerror(errno), errno);
+			logger->LogWrite(FATAL, MODULE_JFR, LOG_FUNC_STRING, LOG_FUNC_VALUE);
+			assert(0);
+		}
+	}
+	ret = Wait(pid, pCtx);
+	canceled = End(pMod, pCtx);
+	/// 后继模块与本模块同时运行，运行时间相同，不经过线程池
+	pNextCtx->m_oUsage.Clear();
+	pNextCtx->m_oUsage.m_nWallUs = pCtx->m_oUsage.m_nWallUs;
+	Usage(ru, pNextCtx->m_oUsage);
+	Record(pNext->m_pModule, pNextCtx);
+	if (canceled)		// timeout or canceled
+	{
+		pCtx->m_nStat.store(canceled, boost::memory_order_release);
+		Notify(pMod, pCtx);
+		return -1;
+	}
+	/// 后继模块的结果由本模块结束状态的写入发布
+	if (pNext->m_vOutputIndexes.size() == 1)
+	{
+		ArgValue_t* pArgValOut = ppArgs[pNext->m_vOutputIndexes[0]];
+		if (pArgValOut->m_pValue)
+		{
+			pArgValOut->Free();
+		}
+		pArgValOut->m_pValue = (void*)buf;		// 属于运行时的内存区，不单独释放
+		pArgValOut->m_nLength = len;
+		pArgValOut->m_nType = AVT_BINARY;
+	}
+	pNextCtx->m_nRetValue = WEXITSTATUS(status);
+	pNextCtx->m_bStreamed = true;
+	pCtx->m_nRetValue = ret;
+	pCtx->m_nStat.store(RTS_FINISH, boost::memory_order_release);
+	Notify(pMod, pCtx);
 
-        close(fd[1]);
-        buf = Read(fd[0]);
-        close(fd[0]);
-        ret = Wait(pid);
-        if (buf)
+	return 0;
+}
+
+/// 以共享内存传递出入参的进程模块，见ShmSegment
+// 入参i在子进程中为描述符JFR_SHM_FD_BASE + i，命令行参数为"/dev/fd/<n>"；标准输出为memfd，子进程结束后映射为出参
+int ModuleCaller::CallProShm(Module_t* pMod, ModContext_t* pCtx, const vector< size_t >* pInput, const vector< size_t >* pOutput, ArgValue_t** ppArgs)
+{
+	pid_t pid;
+	int fdOut;
+	int ret;
+	unsigned int canceled;
+	char** ppArgValIn;
+	int* pFds;
+	bool* pOwned;
+	size_t nInput;
+	ArgValue_t* pArgValOut;
+	const vector< size_t >& vInput = *pInput;
+	const vector< size_t >& vOutput = *pOutput;
+
+	assert(pCtx->m_pArena && vOutput.size() <= 1);
+	nInput = vInput.size();
+	ppArgValIn = (char**)pCtx->m_pArena->Alloc((nInput + 2) * sizeof(char*));
+	pFds = (int*)pCtx->m_pArena->Alloc((nInput + 1) * sizeof(int));
+	pOwned = (bool*)pCtx->m_pArena->Alloc((nInput + 1) * sizeof(bool));
+	pArgValOut = vOutput.size() == 1 ? ppArgs[vOutput[0]] : NULL;
+
+	/// 创建、映射共享内存或启动进程失败按模块出错结束，与超时一样传递给后继模块
+	Begin(pMod, pCtx);
+	ret = 0;
+	for (size_t i = 0; i < nInput; ++i)
+	{
+		const ArgValue_t* pArgValue = ppArgs[vInput[i]];
+		pFds[i] = ShmSegment::Fd(pArgValue);		// 来自共享内存出参时直接传递其memfd
+		pOwned[i] = pFds[i] == -1;
+		if (pOwned[i])
 		{
-            if (strncmp(buf, JFR_CALLPRO_ERROR_STRING, JFR_CALLPRO_ERROR_LEN) == 0 && ret == JFR_CALLPRO_ERROR_NO)	// exec error
+			const char* value = pArgValue->m_pValue ? (const char*)pArgValue->m_pValue : "";
+			pFds[i] = ShmSegment::FromBuffer(value, pArgValue->m_nLength ? pArgValue->m_nLength : strlen(value));
+			if (pFds[i] == -1)
 			{
-				pCtx->m_oMutex.lock();
-				pCtx->m_nStat = RTS_SYSERROR;
-				pCtx->m_oMutex.unlock();
-				free(ppArgValIn);
-				free(buf);
-				logger->LogWrite(ERROR, MODULE_JFR, "parent: exec process failed.");
-				logger->LogWrite(DEBUG_1, MODULE_JFR, LOG_FUNC_STRING, LOG_FUNC_VALUE);
-				return -1;
+				ret = -1;
+				nInput = i;
+				break;
 			}
 		}
-		pCtx->m_oMutex.lock();
-		pCtx->m_nRetValue = ret;
-		pCtx->m_nStat = RTS_FINISH;
-		pCtx->m_oMutex.unlock();
+		ppArgValIn[i + 1] = (char*)pCtx->m_pArena->Alloc(32);
+		snprintf(ppArgValIn[i + 1], 32, "/dev/fd/%d", JFR_SHM_FD_BASE + (int)i);
+	}
+	fdOut = ret == 0 ? ShmSegment::Create("jfr_out") : -1;
+	if (fdOut == -1)
+	{
+		int err = errno;
+		for (size_t i = 0; i < nInput; ++i)
+		{
+			if (pOwned[i])
+			{
+				close(pFds[i]);
+			}
+		}
+		End(pMod, pCtx);
+		pCtx->m_nStat.store(RTS_ERROR, boost::memory_order_release);
+		Notify(pMod, pCtx);
+		logger->LogWrite(ERROR, MODULE_JFR, "make shared memory segment failed, module name: %s, %s, errno: %d.", pMod->m_sName.c_str(), strerror(err), err);
+		logger->LogWrite(DEBUG_1, MODULE_JFR, LOG_FUNC_STRING, LOG_FUNC_VALUE);
+		return -1;
+	}
+	ppArgValIn[0] = (char*)pMod->m_sFileName.c_str();
+	ppArgValIn[nInput + 1] = NULL;
+	pid = Spawn(pMod->m_sFileName, ppArgValIn, -1, fdOut, pFds, nInput);
+	for (size_t i = 0; i < nInput; ++i)		// 子进程已持有入参memfd，共享内存出参的memfd仍归参数值所有
+	{
+		if (pOwned[i])
+		{
+			close(pFds[i]);
+		}
+	}
+	if (pid == -1)
+	{
+		int err = errno;
+		close(fdOut);
+		End(pMod, pCtx);
+		pCtx->m_nStat.store(RTS_ERROR, boost::memory_order_release);
+		Notify(pMod, pCtx);
+		logger->LogWrite(ERROR, MODULE_JFR, "spawn process failed, file name: %s, %s, errno: %d.", pMod->m_sFileName.c_str(), strerror(err), err);
+		logger->LogWrite(DEBUG_1, MODULE_JFR, LOG_FUNC_STRING, LOG_FUNC_VALUE);
+		return -1;
+	}
+	pCtx->m_nPid = pid;
+	if (pCtx->m_oEnv.m_nCanceled)		// 登记进程号前已被取消，取消方与此处先写后读，至少一方能看到对方的写入
+	{
+		kill(-pid, SIGKILL);
+	}
+	if (pMod->m_nTimeout > 0)
+	{
+		watchdog->Watch(pCtx, pMod->m_nTimeout);
+	}
+	ret = Wait(pid, pCtx);
+	if ((canceled = End(pMod, pCtx)) != 0)		// timeout or canceled
+	{
+		close(fdOut);
+		pCtx->m_nStat.store(canceled, boost::memory_order_release);
+		Notify(pMod, pCtx);
+		return -1;
+	}
+	if (pArgValOut)
+	{
+		char* buf;
+		size_t len;
+
+		buf = ShmSegment::Map(fdOut, len);
+		if (buf == NULL)
+		{
+			int err = errno;
+			close(fdOut);
+			pCtx->m_nStat.store(RTS_ERROR, boost::memory_order_release);
+			Notify(pMod, pCtx);
+			logger->LogWrite(ERROR, MODULE_JFR, "map shared memory output failed, module name: %s, %s, errno: %d.", pMod->m_sName.c_str(), strerror(err), err);
+			logger->LogWrite(DEBUG_1, MODULE_JFR, LOG_FUNC_STRING, LOG_FUNC_VALUE);
+			return -1;
+		}
+		/// 先写输出参数再置结束状态，后继模块看到finish时输出已就绪
+		if (pArgValOut->m_pValue)
+		{
+			pArgValOut->Free();
+		}
+		pArgValOut->m_pValue = (void*)buf;
+		pArgValOut->m_pFreeFunc = &ShmSegment::Free;
+		pArgValOut->m_nLength = len;
+		pArgValOut->m_nType = AVT_BINARY;
+	}
+	else
+	{
+		close(fdOut);
+	}
+	pCtx->m_nRetValue = ret;
+	pCtx->m_nStat.store(RTS_FINISH, boost::memory_order_release);
+	Notify(pMod, pCtx);
+
+	return 0;
+}
+
+/// 由常驻进程处理一次调用，进程号登记在上下文中，超时或取消时与进程模块一样kill进程组，被kill的进程不再复用
+int ModuleCaller::CallWorker(Module_t* pMod, ModContext_t* pCtx, const vector< size_t >* pInput, const vector< size_t >* pOutput, ArgValue_t** ppArgs)
+{
+	int ret, nRetValue;
+	unsigned int canceled;
+	const ArgValue_t** ppArgValIn;
+	char* buf;
+	size_t len;
+	Worker_t* pWorker;
+	ArgValue_t* pArgValOut;
+	const vector< size_t >& vInput = *pInput;
+	const vector< size_t >& vOutput = *pOutput;
+
+	assert(pMod->m_pWorkers && pCtx->m_pArena && vOutput.size() <= 1);
+	ppArgValIn = (const ArgValue_t**)pCtx->m_pArena->Alloc((vInput.size() + 1) * sizeof(ArgValue_t*));
+	for(size_t i = 0; i < vInput.size(); ++i)
+	{
+		ppArgValIn[i] = ppArgs[vInput[i]];
+	}
+	ppArgValIn[vInput.size()] = NULL;
+	pArgValOut = vOutput.size() == 1 ? ppArgs[vOutput[0]] : NULL;
+
+	/// 取不到进程或进程调用失败按模块出错结束，与超时一样传递给后继模块
+	Begin(pMod, pCtx);
+	if (pMod->m_nTimeout > 0)		// 等待空闲进程的时间计入超时
+	{
+		watchdog->Watch(pCtx, pMod->m_nTimeout);
+	}
+	pWorker = pMod->m_pWorkers->Acquire();
+	if (pWorker == NULL)
+	{
+		End(pMod, pCtx);
+		pCtx->m_nStat.store(RTS_ERROR, boost::memory_order_release);
+		Notify(pMod, pCtx);
+		logger->LogWrite(ERROR, MODULE_JFR, "acquire worker process failed, module name: %s.", pMod->m_sName.c_str());
+		logger->LogWrite(DEBUG_1, MODULE_JFR, LOG_FUNC_STRING, LOG_FUNC_VALUE);
+		return -1;
+	}
+	if (pCtx->m_oEnv.m_nCanceled)		// 等待空闲进程期间已被取消，进程未使用，直接归还
+	{
+		pMod->m_pWorkers->Release(pWorker, true);
+		canceled = End(pMod, pCtx);
+		pCtx->m_nStat.store(canceled, boost::memory_order_release);
+		Notify(pMod, pCtx);
+		return -1;
+	}
+	pCtx->m_nPid = pWorker->m_nPid;
+	if (pCtx->m_oEnv.m_nCanceled)		// 登记进程号前已被取消，取消方与此处先写后读，至少一方能看到对方的写入
+	{
+		kill(-pWorker->m_nPid, SIGKILL);
+	}
+	ret = pMod->m_pWorkers->Call(pWorker, ppArgValIn, vInput.size(), pCtx->m_pArena, nRetValue, buf, len);
+	ClearPid(pWorker->m_nPid, pCtx);
+	canceled = End(pMod, pCtx);
+	pMod->m_pWorkers->Release(pWorker, ret == 0 && canceled == 0);
+	if (canceled)		// timeout or canceled
+	{
+		pCtx->m_nStat.store(canceled, boost::memory_order_release);
+		Notify(pMod, pCtx);
+		return -1;
+	}
+	if (ret)
+	{
+		pCtx->m_nStat.store(RTS_ERROR, boost::memory_order_release);
+		Notify(pMod, pCtx);
+		logger->LogWrite(ERROR, MODULE_JFR, "call worker process failed, worker process will be restarted, module name: %s.", pMod->m_sName.c_str());
+		logger->LogWrite(DEBUG_1, MODULE_JFR, LOG_FUNC_STRING, LOG_FUNC_VALUE);
+		return -1;
+	}
+	/// 先写输出参数再置结束状态，后继模块看到finish时输出已就绪
+	if (pArgValOut)
+	{
+		if (pArgValOut->m_pValue)
+		{
+			pArgValOut->Free();
+		}
+		pArgValOut->m_pValue = (void*)buf;		// 属于运行时的内存区，不单独释放
+		pArgValOut->m_nLength = len;
+		pArgValOut->m_nType = AVT_BINARY;
+	}
+	if (pMod->m_pCache)
+	{
+		string key;
+		CacheKey(vInput, ppArgs, key);
 		if (pArgValOut)
 		{
-            pArgValOut->m_oMutex.lock();
-            if (pArgValOut->m_pValue)
-            {
-                pArgValOut->Free();
-            }
-            pArgValOut->m_pValue = (void*)buf;
-            pArgValOut->m_pFreeFunc = free;
-            pArgValOut->m_oMutex.unlock();
+			pMod->m_pCache->Store(key, nRetValue, (const char*)pArgValOut->m_pValue, pArgValOut->m_nLength, pArgValOut->m_nType);
 		}
 		else
 		{
-			free(buf);
+			pMod->m_pCache->Store(key, nRetValue, NULL, 0, AVT_UNKNOWN);
 		}
 	}
-	free(ppArgValIn);
+	pCtx->m_nRetValue = nRetValue;
+	pCtx->m_nStat.store(RTS_FINISH, boost::memory_order_release);
+	Notify(pMod, pCtx);
 
 	return 0;
 }
 
-int ModuleCaller::CallSo(Module_t* pMod, ModContext_t* pCtx, const vector< ModArg_t* >& vInput, const vector< ModArg_t* >& vOutput, map< ModArg_t*, ArgValue_t* >& mapArg)
+/// 在调度线程中查找缓存的模块结果，命中时直接写出参并结束模块，不提交到线程池
+// 返回0表示命中，1表示未命中
+int ModuleCaller::CallCached(Module_t* pMod, ModContext_t* pCtx, const vector< size_t >* pInput, const vector< size_t >* pOutput, ArgValue_t** ppArgs)
 {
 	int ret;
-	map< ModArg_t*, ArgValue_t* >::iterator iter, end;
+	char* buf;
+	size_t len;
+	unsigned int type;
+	string key;
+
+	assert(pMod->m_pCache && pOutput->size() <= 1);
+	CacheKey(*pInput, ppArgs, key);
+	if (!pMod->m_pCache->Lookup(key, ret, buf, len, type, pCtx->m_pArena))
+	{
+		return 1;
+	}
+	if (pOutput->size() == 1)
+	{
+		ArgValue_t* pArgValOut = ppArgs[(*pOutput)[0]];
+		if (pArgValOut->m_pValue)
+		{
+			pArgValOut->Free();
+		}
+		pArgValOut->m_pValue = (void*)buf;		// 属于运行时的内存区，不单独释放
+		pArgValOut->m_nLength = len;
+		pArgValOut->m_nType = type;
+	}
+	pCtx->m_nRetValue = ret;
+	pCtx->m_nStat.store(RTS_FINISH, boost::memory_order_release);
+	Notify(pMod, pCtx);
+
+	return 0;
+}
+
+/// 以进程模块的入参内容生成缓存键
+void ModuleCaller::CacheKey(const vector< size_t >& vInput, ArgValue_t** ppArgs, string& key)
+{
+	key.clear();
+	for (size_t i = 0; i < vInput.size(); ++i)
+	{
+		ResultCache::AppendKey(key, (const char*)ppArgs[vInput[i]]->m_pValue, ppArgs[vInput[i]]->m_nLength);
+	}
+}
+
+int ModuleCaller::CallSo(Module_t* pMod, ModContext_t* pCtx, const vector< size_t >* pInput, const vector< size_t >* pOutput, ArgValue_t** ppArgs)
+{
+	int ret;
+	unsigned int canceled;
+	struct rusage before, after;
 	ArgValue_t** ppArgValIn;
 	ArgValue_t** ppArgValOut;
+	const vector< size_t >& vInput = *pInput;
+	const vector< size_t >& vOutput = *pOutput;
 
+	if (pMod->m_pCallbackV2)
+	{
+		return CallSoV2(pMod, pCtx, pInput, pOutput, ppArgs);
+	}
 	assert(pMod->m_pCallback && pMod->m_pHandle);
-	StaticModuleArgSet* pSMASet = &StaticModuleArgSet::get_mutable_instance();
-	end = mapArg.end();
-	ppArgValIn = (ArgValue_t**)malloc((vInput.size() + 1) * sizeof(ArgValue_t*));
+	assert(pCtx->m_pArena);
+	ppArgValIn = (ArgValue_t**)pCtx->m_pArena->Alloc((vInput.size() + 1) * sizeof(ArgValue_t*));
 	for(size_t i = 0; i < vInput.size(); ++i)
 	{
-		ArgValue_t* p;
-		iter = mapArg.find(vInput[i]);
-		if (iter != end)
-		{
-			p = iter->second;
-		}
-		else if ((p = pSMASet->GetElement(vInput[i])) == NULL)
-		{
-			logger->LogWrite(FATAL, MODULE_JFR, LOG_FUNC_STRING, LOG_FUNC_VALUE);
-            assert(0);
-		}
-		ppArgValIn[i] = p;
+		ppArgValIn[i] = ppArgs[vInput[i]];
 	}
 	ppArgValIn[vInput.size()] = NULL;
-	ppArgValOut = (ArgValue_t**)malloc((vOutput.size() + 1) * sizeof(ArgValue_t*));
+	ppArgValOut = (ArgValue_t**)pCtx->m_pArena->Alloc((vOutput.size() + 1) * sizeof(ArgValue_t*));
 	for(size_t i = 0; i < vOutput.size(); ++i)
 	{
-		iter = mapArg.find(vOutput[i]);
-		if (iter == end)
+        ppArgValOut[i] = ppArgs[vOutput[i]];
+	}
+	ppArgValOut[vOutput.size()] = NULL;
+
+	Begin(pMod, pCtx);
+	if (ThreadState(pMod, pCtx->m_oEnv.m_pThreadState))		// 与回调返回非0相同，按模块执行失败处理，同样计入统计
+	{
+		logger->LogWrite(ERROR, MODULE_JFR, "module thread init failed, module name: %s.", pMod->m_sName.c_str());
+		logger->LogWrite(DEBUG_1, MODULE_JFR, LOG_FUNC_STRING, LOG_FUNC_VALUE);
+		canceled = End(pMod, pCtx);
+		pCtx->m_nRetValue = -1;
+		pCtx->m_nStat.store(canceled ? canceled : (unsigned int)RTS_FINISH, boost::memory_order_release);
+		Notify(pMod, pCtx);
+		return 0;
+	}
+	pCtx->m_oEnv.m_pModuleState = pMod->m_pState;
+
+	if (pMod->m_nTimeout > 0)
+	{
+		watchdog->Watch(pCtx, pMod->m_nTimeout);
+	}
+	getrusage(RUSAGE_THREAD, &before);
+	if (pCtx->m_oEnv.m_nCanceled)		// 提交后运行前已被取消
+	{
+		ret = 0;
+	}
+	else if (pMod->m_pCallbackEx)
+	{
+		ret = pMod->m_pCallbackEx(logger, ppArgValIn, ppArgValOut, &pCtx->m_oEnv);
+	}
+	else
+	{
+		ret = pMod->m_pCallback(logger, ppArgValIn, ppArgValOut);
+	}
+	/// 本线程在回调期间的CPU时间，最大常驻内存为进程共用，不计入
+	getrusage(RUSAGE_THREAD, &after);
+	pCtx->m_oUsage.m_nUserUs = ModuleStats::Micros(after.ru_utime) - ModuleStats::Micros(before.ru_utime);
+	pCtx->m_oUsage.m_nSysUs = ModuleStats::Micros(after.ru_stime) - ModuleStats::Micros(before.ru_stime);
+	canceled = End(pMod, pCtx);
+	pCtx->m_nRetValue = ret;
+	pCtx->m_nStat.store(canceled ? canceled : (unsigned int)RTS_FINISH, boost::memory_order_release);
+	Notify(pMod, pCtx);
+
+	return 0;
+}
+
+/// v2接口动态库模块，见ModArgV2_st
+// 出参保留的缓冲区调用前移交给模块，调用后连同模块写入的类型、长度移回参数值，均不复制
+int ModuleCaller::CallSoV2(Module_t* pMod, ModContext_t* pCtx, const vector< size_t >* pInput, const vector< size_t >* pOutput, ArgValue_t** ppArgs)
+{
+	int ret;
+	unsigned int canceled;
+	struct rusage before, after;
+	ModArgV2_t* pArgs;
+	ModArgV2_t** ppArgValIn;
+	ModArgV2_t** ppArgValOut;
+	const vector< size_t >& vInput = *pInput;
+	const vector< size_t >& vOutput = *pOutput;
+
+	assert(pMod->m_pCallbackV2 && pMod->m_pHandle);
+	assert(pCtx->m_pArena);
+	pArgs = (ModArgV2_t*)pCtx->m_pArena->Alloc((vInput.size() + vOutput.size()) * sizeof(ModArgV2_t));
+	ppArgValIn = (ModArgV2_t**)pCtx->m_pArena->Alloc((vInput.size() + 1) * sizeof(ModArgV2_t*));
+	for(size_t i = 0; i < vInput.size(); ++i)
+	{
+		const ArgValue_t* pArgValue = ppArgs[vInput[i]];
+		ModArgV2_t* pArg = &pArgs[i];
+		pArg->m_nType = pArgValue->m_nType;
+		pArg->m_pData = pArgValue->m_pValue;
+		pArg->m_nLength = pArgValue->m_nLength;
+		if (pArg->m_nType == AVT_STRING && pArg->m_nLength == 0 && pArg->m_pData)
 		{
-			logger->LogWrite(FATAL, MODULE_JFR, LOG_FUNC_STRING, LOG_FUNC_VALUE);
-            assert(0);
+			pArg->m_nLength = strlen((const char*)pArg->m_pData);
 		}
-		ArgValue_t* p = iter->second;
-        ppArgValOut[i] = p;
+		pArg->m_nCapacity = 0;
+		pArg->m_pFreeFunc = NULL;
+		ppArgValIn[i] = pArg;
+	}
+	ppArgValIn[vInput.size()] = NULL;
+	ppArgValOut = (ModArgV2_t**)pCtx->m_pArena->Alloc((vOutput.size() + 1) * sizeof(ModArgV2_t*));
+	for(size_t i = 0; i < vOutput.size(); ++i)
+	{
+		ArgValue_t* pArgValue = ppArgs[vOutput[i]];
+		ModArgV2_t* pArg = &pArgs[vInput.size() + i];
+		pArgValue->Recycle();		// 本实例中已有的值，可复用时转为保留的缓冲区
+		pArg->m_nType = AVT_UNKNOWN;
+		pArg->m_pData = pArgValue->m_pSpare;
+		pArg->m_nLength = 0;
+		pArg->m_nCapacity = pArgValue->m_nSpareCapacity;
+		pArg->m_pFreeFunc = pArgValue->m_pSpareFree;
+		ppArgValOut[i] = pArg;
 	}
 	ppArgValOut[vOutput.size()] = NULL;
 
-	ret = pMod->m_pCallback(logger, ppArgValIn, ppArgValOut);
-	pCtx->m_oMutex.lock();
+	Begin(pMod, pCtx);
+	if (ThreadState(pMod, pCtx->m_oEnv.m_pThreadState))		// 与回调返回非0相同，按模块执行失败处理，同样计入统计
+	{
+		logger->LogWrite(ERROR, MODULE_JFR, "module thread init failed, module name: %s.", pMod->m_sName.c_str());
+		logger->LogWrite(DEBUG_1, MODULE_JFR, LOG_FUNC_STRING, LOG_FUNC_VALUE);
+		canceled = End(pMod, pCtx);
+		pCtx->m_nRetValue = -1;
+		pCtx->m_nStat.store(canceled ? canceled : (unsigned int)RTS_FINISH, boost::memory_order_release);
+		Notify(pMod, pCtx);
+		return 0;
+	}
+	pCtx->m_oEnv.m_pModuleState = pMod->m_pState;
+
+	if (pMod->m_nTimeout > 0)
+	{
+		watchdog->Watch(pCtx, pMod->m_nTimeout);
+	}
+	getrusage(RUSAGE_THREAD, &before);
+	if (pCtx->m_oEnv.m_nCanceled)		// 提交后运行前已被取消
+	{
+		ret = 0;
+	}
+	else
+	{
+		ret = pMod->m_pCallbackV2(logger, ppArgValIn, ppArgValOut, &pCtx->m_oEnv);
+	}
+	getrusage(RUSAGE_THREAD, &after);
+	pCtx->m_oUsage.m_nUserUs = ModuleStats::Micros(after.ru_utime) - ModuleStats::Micros(before.ru_utime);
+	pCtx->m_oUsage.m_nSysUs = ModuleStats::Micros(after.ru_stime) - ModuleStats::Micros(before.ru_stime);
+	/// 先写输出参数再置结束状态，后继模块看到finish时输出已就绪
+	for(size_t i = 0; i < vOutput.size(); ++i)
+	{
+		ArgValue_t* pArgValue = ppArgs[vOutput[i]];
+		ModArgV2_t* pArg = &pArgs[vInput.size() + i];
+		if (pArgValue->m_pSpare && pArg->m_pData == pArgValue->m_pSpare && pArg->m_pFreeFunc != pArgValue->m_pSpareFree)
+		{
+			/// 保留了移交的缓冲区却改了释放回调函数，所有权不明确，按原释放回调函数释放，丢弃输出
+			logger->LogWrite(WARNING, MODULE_JFR, "so module kept the spare output buffer but changed its free function, output discarded, module name: %s, output index: %lu.", \
+													pMod->m_sName.c_str(), (unsigned long)i);
+			logger->LogWrite(DEBUG_1, MODULE_JFR, LOG_FUNC_STRING, LOG_FUNC_VALUE);
+			pArgValue->FreeSpare();
+			pArg->m_nType = AVT_UNKNOWN;
+			pArg->m_pData = NULL;
+			pArg->m_nLength = 0;
+			pArg->m_nCapacity = 0;
+			pArg->m_pFreeFunc = NULL;
+		}
+		else if (pArg->m_pData == pArgValue->m_pSpare)		// 缓冲区和释放回调函数均未变，仍为移交的保留缓冲区
+		{
+			pArgValue->m_pSpare = NULL;
+			pArgValue->m_pSpareFree = NULL;
+			pArgValue->m_nSpareCapacity = 0;
+		}
+		else		// 模块换成了自己的缓冲区，原缓冲区由jfr释放
+		{
+			pArgValue->FreeSpare();
+		}
+		pArgValue->m_pValue = pArg->m_pData;
+		pArgValue->m_pFreeFunc = pArg->m_pFreeFunc;
+		pArgValue->m_nLength = pArg->m_nLength;
+		pArgValue->m_nType = pArg->m_nType;
+		pArgValue->m_nCapacity = pArg->m_nCapacity;
+		if (pArg->m_nType == AVT_UNKNOWN)		// 没有输出，缓冲区可复用时保留
+		{
+			pArgValue->Recycle();
+		}
+	}
+	canceled = End(pMod, pCtx);
 	pCtx->m_nRetValue = ret;
-	pCtx->m_nStat = RTS_FINISH;
-	pCtx->m_oMutex.unlock();
-	free(ppArgValIn);
-	free(ppArgValOut);
+	pCtx->m_nStat.store(canceled ? canceled : (unsigned int)RTS_FINISH, boost::memory_order_release);
+	Notify(pMod, pCtx);
 
 	return 0;
 }
 
-char* ModuleCaller::Read(int fd)
+/// 以posix_spawn启动进程模块，标准输出重定向到fdOut，fdIn不为-1时标准输入重定向到fdIn，pFds[i]重定向到JFR_SHM_FD_BASE + i
+// 子进程与父进程共享地址空间直到exec，启动耗时与jfr占用的内存无关；exec失败由返回值报告，子进程中不执行其他代码
+// 子进程为单独的进程组(nPgid不为0时加入该进程组)，超时时连同孙进程一起结束；信号屏蔽字和信号处理恢复默认，不继承调度线程屏蔽的重新加载信号
+pid_t ModuleCaller::Spawn(const string& sFileName, char** ppArgv, int fdIn, int fdOut, const int* pFds, size_t nFds, pid_t nPgid)
 {
-	int ret, len, pos;
+	pid_t pid;
+	int ret;
+	sigset_t sigset;
+	posix_spawnattr_t attr;
+	posix_spawn_file_actions_t actions;
+	vector< int > vTemp;
+
+	/// 目标描述符可能与后面的源描述符相同，先把落在目标范围内的源描述符复制到范围之外
+	for (size_t i = 0; i < nFds; ++i)
+	{
+		if (pFds[i] < JFR_SHM_FD_BASE + (int)nFds)
+		{
+			int fd = fcntl(pFds[i], F_DUPFD_CLOEXEC, JFR_SHM_FD_BASE + (int)nFds);
+			if (fd == -1)
+			{
+				int err = errno;
+				for (size_t j = 0; j < vTemp.size(); ++j)
+				{
+					close(vTemp[j]);
+				}
+				errno = err;
+				return -1;
+			}
+			vTemp.push_back(fd);
+		}
+	}
+	posix_spawnattr_init(&attr);
+	posix_spawnattr_setflags(&attr, POSIX_SPAWN_SETPGROUP | POSIX_SPAWN_SETSIGMASK | POSIX_SPAWN_SETSIGDEF);
+	posix_spawnattr_setpgroup(&attr, nPgid);
+	sigemptyset(&sigset);
+	posix_spawnattr_setsigmask(&attr, &sigset);
+	sigfillset(&sigset);
+	posix_spawnattr_setsigdefault(&attr, &sigset);
+	posix_spawn_file_actions_init(&actions);
+	if (fdIn != -1)
+	{
+		posix_spawn_file_actions_adddup2(&actions, fdIn, 0);
+	}
+	posix_spawn_file_actions_adddup2(&actions, fdOut, 1);		// dup2后的标准输入输出不带O_CLOEXEC
+	for (size_t i = 0, j = 0; i < nFds; ++i)
+	{
+		int fd = pFds[i] < JFR_SHM_FD_BASE + (int)nFds ? vTemp[j++] : pFds[i];
+		posix_spawn_file_actions_adddup2(&actions, fd, JFR_SHM_FD_BASE + (int)i);
+	}
+	ret = posix_spawn(&pid, sFileName.c_str(), &actions, &attr, ppArgv, environ);
+	posix_spawn_file_actions_destroy(&actions);
+	posix_spawnattr_destroy(&attr);
+	for (size_t j = 0; j < vTemp.size(); ++j)
+	{
+		close(vTemp[j]);
+	}
+	if (ret != 0)
+	{
+		errno = ret;
+		return -1;
+	}
+
+	return pid;
+}
+
+/// 读取到文件结束，内容从内存区分配，以'\0'结尾，nLength为内容长度
+char* ModuleCaller::Read(int fd, Arena* pArena, size_t& nLength)
+{
+	int ret;
+	size_t len, pos;
 	char* buf;
 
-    assert(fd >= 0);
+    assert(fd >= 0 && pArena);
     buf = NULL;
-    ret = len = pos = 0;
-    const int block = 1024;
+    len = pos = 0;
+    const size_t block = 1024;
     while (1)
 	{
-		if (pos == len)
+		if (pos == len)		// 从内存区扩展，不能原地扩展时按倍数增长以减少复制
 		{
-			len += block;
-			buf = (char*)realloc((void*)buf, len);
-			assert(buf);
+			size_t newLen = len ? len * 2 : block;
+			buf = (char*)pArena->Grow((void*)buf, pos, newLen);
+			len = newLen;
 		}
 		ret = read(fd, buf + pos, len  - pos);
 		if (ret == -1)
 		{
             if (errno != EINTR)
 			{
-                free(buf);
 				logger->LogWrite(ERROR, MODULE_JFR, "read failed, %s, errno: %d.", strerror(errno), errno);
 				logger->LogWrite(DEBUG_1, MODULE_JFR, LOG_FUNC_STRING, LOG_FUNC_VALUE);
                 return NULL;
@@ -374,6 +1032,7 @@ char* ModuleCaller::Read(int fd)
 		else if (ret == 0)
 		{
             buf[pos] = '\0';
+            nLength = pos;
             return buf;
 		}
 		else
@@ -385,14 +1044,39 @@ char* ModuleCaller::Read(int fd)
 	return NULL;
 }
 
-int ModuleCaller::Wait(pid_t pid)
+/// 清除上下文中登记的进程号，取消方正在kill时等待其完成，清除后取消方不会再kill该进程组
+void ModuleCaller::ClearPid(pid_t pid, ModContext_t* pCtx)
+{
+	pid_t busy = pid;
+	while (!pCtx->m_nPid.compare_exchange_weak(busy, 0))
+	{
+		busy = pid;
+		boost::this_thread::yield();
+	}
+}
+
+/// 先等待子进程结束但不回收，清除上下文中的进程号后再回收，避免Watchdog杀掉复用的进程号
+// 回收时取得子进程的rusage，计入上下文的资源占用
+int ModuleCaller::Wait(pid_t pid, ModContext_t* pCtx)
 {
 	int ret;
+	siginfo_t info;
+	struct rusage ru;
 
-    assert(pid > 0);
+    assert(pid > 0 && pCtx);
+    while (waitid(P_PID, pid, &info, WEXITED | WNOWAIT) == -1)
+	{
+		if (errno != EINTR)
+		{
+			logger->LogWrite(ERROR, MODULE_JFR, "wait process failed, %s, errno: %d.", strerror(errno), errno);
+			logger->LogWrite(FATAL, MODULE_JFR, LOG_FUNC_STRING, LOG_FUNC_VALUE);
+			assert(0);
+		}
+	}
+	ClearPid(pid, pCtx);
     while (1)
 	{
-		if (waitpid(pid, &ret, 0) == -1)
+		if (wait4(pid, &ret, 0, &ru) == -1)
 		{
             if (errno == EINTR)
 			{
@@ -404,6 +1088,7 @@ int ModuleCaller::Wait(pid_t pid)
 		}
 		else
 		{
+			Usage(ru, pCtx->m_oUsage);
 			return WEXITSTATUS(ret);
 		}
 	}
@@ -411,5 +1096,110 @@ int ModuleCaller::Wait(pid_t pid)
 	return 0;
 }
 
+/// 模块开始运行，设置运行环境；取消标志在运行时回收时清除，提交后运行前的取消仍然有效
+void ModuleCaller::Begin(Module_t* pMod, ModContext_t* pCtx)
+{
+	pCtx->m_oEnv.m_nTimeout = pMod->m_nTimeout;
+	pCtx->m_nBegin = ModuleStats::Now();
+	pCtx->m_oUsage.Clear();
+	if (pCtx->m_nSubmit)
+	{
+		pCtx->m_oUsage.m_nQueueUs = pCtx->m_nBegin - pCtx->m_nSubmit;
+		pCtx->m_nSubmit = 0;
+	}
+}
+
+/// 模块运行结束，注销超时监控，记录资源占用，返回取消后的状态(RTS_TIMEOUT、RTS_CANCEL)，未取消时返回0
+unsigned int ModuleCaller::End(Module_t* pMod, ModContext_t* pCtx)
+{
+	unsigned int canceled;
+
+	if (pMod->m_nTimeout > 0)
+	{
+		watchdog->Unwatch(pCtx);
+	}
+	canceled = pCtx->m_oEnv.m_nCanceled;
+	pCtx->m_oUsage.m_nWallUs = ModuleStats::Now() - pCtx->m_nBegin;
+	Record(pMod, pCtx);
+
+	return canceled;
+}
+
+/// 计入模块和所属主线的统计，超时、取消的调用同样计入
+void ModuleCaller::Record(Module_t* pMod, ModContext_t* pCtx)
+{
+	if (pMod->m_pStats)
+	{
+		pMod->m_pStats->Record(pCtx->m_oUsage);
+	}
+	if (pCtx->m_pRuntime && pCtx->m_pRuntime->m_pLine->m_pStats)
+	{
+		pCtx->m_pRuntime->m_pLine->m_pStats->Record(pCtx->m_oUsage);
+	}
+}
+
+/// 子进程的CPU时间和最大常驻内存
+void ModuleCaller::Usage(const struct rusage& ru, ModUsage_t& usage)
+{
+	usage.m_nUserUs = ModuleStats::Micros(ru.ru_utime);
+	usage.m_nSysUs = ModuleStats::Micros(ru.ru_stime);
+	usage.m_nMaxRss = ru.ru_maxrss;
+}
+
+/// 取得本线程的模块线程状态，首次调用模块时以<main>_thread_init生成，失败时返回-1，下次调用时重试
+// 线程状态按加载序号保存在线程局部的map中，查找不加锁；生成后同时登记到模块，卸载模块时释放
+int ModuleCaller::ThreadState(Module_t* pMod, void*& pThreadState)
+{
+	map< unsigned long, void* >* pStates;
+	map< unsigned long, void* >::iterator iter;
+
+	pThreadState = NULL;
+	if (!pMod->m_pThreadInit)
+	{
+		return 0;
+	}
+	pStates = threadStates->get();
+	if (!pStates)
+	{
+		pStates = new map< unsigned long, void* >;
+		threadStates->reset(pStates);
+	}
+	iter = pStates->find(pMod->m_nSerial);
+	if (iter != pStates->end())
+	{
+		pThreadState = iter->second;
+		return 0;
+	}
+	if (pMod->m_pThreadInit(logger, pMod->m_pState, &pThreadState))
+	{
+		pThreadState = NULL;
+		return -1;
+	}
+	{
+		boost::lock_guard< boost::mutex > guard(pMod->m_oThreadMutex);
+		pMod->m_vThreadStates.push_back(pThreadState);
+	}
+	pStates->insert(make_pair(pMod->m_nSerial, pThreadState));
+
+	return 0;
+}
+
+/// 通知调度线程模块运行结束，静态模块同步调用无需通知
+int ModuleCaller::Notify(Module_t* pMod, ModContext_t* pCtx)
+{
+	assert(pMod && pCtx);
+	if (pCtx->m_pRuntime == NULL)
+	{
+		return 0;
+	}
+
+	size_t shard = pCtx->m_pRuntime->m_pLine->m_nShard;
+	events->Post(shard, pCtx->m_pRuntime, pCtx, IS_TRIGGER(pMod->m_nType) ? RTE_TRIGGER_FINISH : RTE_MODULE_FINISH);
+	/// 线程池为各分片共享，模块结束后唤醒等待空位的其它分片
+	events->WakeStarved(shard);
+
+	return 0;
+}
+
 
 CLOSE_NAMESPACE_JFR
@@ -7,6 +7,8 @@ OPEN_NAMESPACE_JFR
 ModuleManager::ModuleManager(void)
 {
 	m_bInited = false;
+	m_bPrevious = false;
+	m_nSerial = 0;
 	m_pLogger = NULL;
 }
 
@@ -46,15 +48,54 @@ void ModuleManager::Clear(void)
 	for (iter = m_mapAllModule.begin(); iter != end; ++iter)
 	{
 		assert(iter->second);
-		if (IS_SO(iter->second->m_nType))
-		{
-			dlclose(iter->second->m_pHandle);
-		}
-		delete iter->second;
+		Release(iter->second);
 	}
 	m_mapAllModule.clear();
 }
 
+void ModuleManager::ClearPrevious(void)
+{
+	map< string, Module_t* >::iterator iter, end;
+
+	end = m_mapPrevious.end();
+	for (iter = m_mapPrevious.begin(); iter != end; ++iter)
+	{
+		assert(iter->second);
+		Release(iter->second);
+	}
+	m_mapPrevious.clear();
+	m_mapPrevModule.clear();
+	m_mapPrevTrigger.clear();
+	m_mapPrevStaticModule.clear();
+	m_bPrevious = false;
+}
+
+/// 释放本次加载的模块，恢复上一次加载的模块，仍在运行的旧一代主线和下一次加载继续使用
+void ModuleManager::RestorePrevious(void)
+{
+	Clear();
+	m_mapAllModule.swap(m_mapPrevious);
+	m_mapModule.swap(m_mapPrevModule);
+	m_mapTrigger.swap(m_mapPrevTrigger);
+	m_mapStaticModule.swap(m_mapPrevStaticModule);
+	m_bPrevious = false;
+}
+
+/// 重新加载成功，释放上一次加载的模块
+void ModuleManager::Commit(void)
+{
+	ClearPrevious();
+}
+
+/// 加载模块之后的步骤失败，恢复上一次加载的模块；没有保留上一次加载的模块时不处理
+void ModuleManager::Rollback(void)
+{
+	if (m_bPrevious)
+	{
+		RestorePrevious();
+	}
+}
+
 int ModuleManager::LoadAllModules(const vector< ConfigModule_t* >& vCfgModules, \
 								const vector< ConfigTrigger_t* >& vCfgTriggers, \
 								const vector< ConfigStaticModule_t* >& vCfgStaticModules)
@@ -67,20 +108,27 @@ int ModuleManager::LoadAllModules(const vector< ConfigModule_t* >& vCfgModules,
 
 	m_pLogger->LogWrite(DEBUG_3, MODULE_JFR, "Begin to load all modules.");
 	m_pLogger->LogWrite(DEBUG_1, MODULE_JFR, LOG_FUNC_STRING, LOG_FUNC_VALUE);
-	Clear();
+	/// 上一次加载的模块保留至Commit，期间未改变的模块直接复用，不重新打开动态库；本次或之后的步骤失败时恢复
+	ClearPrevious();
+	m_mapPrevious.swap(m_mapAllModule);
+	m_mapPrevModule.swap(m_mapModule);
+	m_mapPrevTrigger.swap(m_mapTrigger);
+	m_mapPrevStaticModule.swap(m_mapStaticModule);
 	if (SyntaxCheck(vCfgModules, vCfgTriggers, vCfgStaticModules))
 	{
+		RestorePrevious();
 		m_pLogger->LogWrite(ERROR, MODULE_JFR, "module syntax check failed.");
 		m_pLogger->LogWrite(DEBUG_1, MODULE_JFR, LOG_FUNC_STRING, LOG_FUNC_VALUE);
 		return -1;
 	}
 	if (LoadModules(vCfgModules) || LoadTriggers(vCfgTriggers) || LoadStaticModules(vCfgStaticModules))
 	{
-		Clear();
+		RestorePrevious();
 		m_pLogger->LogWrite(ERROR, MODULE_JFR, "load modules failed.");
 		m_pLogger->LogWrite(DEBUG_1, MODULE_JFR, LOG_FUNC_STRING, LOG_FUNC_VALUE);
 		return -1;
 	}
+	m_bPrevious = true;
 	m_pLogger->LogWrite(DEBUG_3, MODULE_JFR, "End to load all modules.");
 	m_pLogger->LogWrite(DEBUG_1, MODULE_JFR, LOG_FUNC_STRING, LOG_FUNC_VALUE);
 
@@ -114,7 +162,7 @@ int ModuleManager::SyntaxCheck(const vector< ConfigModule_t* >& vCfgModules, \
 			m_pLogger->LogWrite(DEBUG_1, MODULE_JFR, LOG_FUNC_STRING, LOG_FUNC_VALUE);
             return -1;
 		}
-		if (vCfgModules[i]->m_sType != "so" && vCfgModules[i]->m_sType != "pro")
+		if (vCfgModules[i]->m_sType != "so" && vCfgModules[i]->m_sType != "pro" && vCfgModules[i]->m_sType != "worker")
 		{
 			m_pLogger->LogWrite(ERROR, MODULE_JFR, "module syntax check failed, wrong <type>, name: %s, type: %s, main: %s, filename: %s.",
 														vCfgModules[i]->m_sName.c_str(), \
@@ -256,6 +304,7 @@ int ModuleManager::SyntaxCheck(const vector< ConfigModule_t* >& vCfgModules, \
 int ModuleManager::LoadModules(const vector< ConfigModule_t* >& vCfgModules)
 {
 	Module_t* pMod = NULL;
+	Module_t* pReuse;
 	void* pRet;
 	bool flag;
 
@@ -265,6 +314,13 @@ int ModuleManager::LoadModules(const vector< ConfigModule_t* >& vCfgModules)
 	for (size_t i = 0; i < vCfgModules.size(); ++i)
 	{
 		assert(vCfgModules[i]);
+		pReuse = Reuse(*vCfgModules[i], GET_MODULE_TYPE_MOD(vCfgModules[i]->m_sType));
+		if (pReuse)
+		{
+			m_mapAllModule.insert(make_pair(pReuse->m_sName, pReuse));
+			m_mapModule.insert(make_pair(pReuse->m_sName, pReuse));
+			continue;
+		}
         if (!flag)
 		{
 			pMod = new Module_t;
@@ -275,6 +331,7 @@ int ModuleManager::LoadModules(const vector< ConfigModule_t* >& vCfgModules)
         pMod->m_sMain = vCfgModules[i]->m_sMain;
         pMod->m_sFileName = vCfgModules[i]->m_sFileName;
         pMod->m_sDesc = vCfgModules[i]->m_sDesc;
+        pMod->m_nTimeout = vCfgModules[i]->m_nTimeout;
 
         if (IS_SO(pMod->m_nType))
 		{
@@ -298,7 +355,10 @@ int ModuleManager::LoadModules(const vector< ConfigModule_t* >& vCfgModules)
 				m_pLogger->LogWrite(DEBUG_1, MODULE_JFR, LOG_FUNC_STRING, LOG_FUNC_VALUE);
 				continue;
 			}
-			pMod->m_pCallback = (ModCallback)pRet;
+			if (LoadCallback(pMod, pRet))
+			{
+				continue;
+			}
 		}
 		else
 		{
@@ -309,6 +369,42 @@ int ModuleManager::LoadModules(const vector< ConfigModule_t* >& vCfgModules)
 				continue;
 			}
 		}
+		if (vCfgModules[i]->m_sTransport == "shm")
+		{
+			if (!IS_PRO(pMod->m_nType))
+			{
+				m_pLogger->LogWrite(WARNING, MODULE_JFR, "module shm transport only supports pro modules, transport ignored, name: %s.", pMod->m_sName.c_str());
+				m_pLogger->LogWrite(DEBUG_1, MODULE_JFR, LOG_FUNC_STRING, LOG_FUNC_VALUE);
+			}
+			else
+			{
+				pMod->m_bShm = true;
+			}
+		}
+		if (vCfgModules[i]->m_bCache)
+		{
+			if (IS_SO(pMod->m_nType))		// 动态库模块的参数为不透明指针，无法缓存
+			{
+				m_pLogger->LogWrite(WARNING, MODULE_JFR, "module result cache only supports pro and worker modules, cache ignored, name: %s.", pMod->m_sName.c_str());
+				m_pLogger->LogWrite(DEBUG_1, MODULE_JFR, LOG_FUNC_STRING, LOG_FUNC_VALUE);
+			}
+			else if (pMod->m_bShm)		// 缓存以字符串保存出入参，不适用于二进制内容
+			{
+				m_pLogger->LogWrite(WARNING, MODULE_JFR, "module result cache does not support shm transport, cache ignored, name: %s.", pMod->m_sName.c_str());
+				m_pLogger->LogWrite(DEBUG_1, MODULE_JFR, LOG_FUNC_STRING, LOG_FUNC_VALUE);
+			}
+			else
+			{
+				pMod->m_pCache = new ResultCache(pMod->m_sName, vCfgModules[i]->m_nCacheTtl, vCfgModules[i]->m_nCacheMaxBytes);
+			}
+		}
+		if (IS_WORKER(pMod->m_nType))
+		{
+			pMod->m_pWorkers = new WorkerPool(pMod->m_sName, pMod->m_sFileName, vCfgModules[i]->m_nWorkers, vCfgModules[i]->m_nMaxRequests, vCfgModules[i]->m_nMaxReplyBytes);
+		}
+		pMod->m_pStats = new ModuleStats("module", pMod->m_sName);
+		Signature(*vCfgModules[i], pMod->m_nType, pMod->m_sSignature);
+		pMod->m_nRef = 1;
 		m_mapAllModule.insert(make_pair(pMod->m_sName, pMod));
 		m_mapModule.insert(make_pair(pMod->m_sName, pMod));
 		flag = false;
@@ -327,6 +423,7 @@ int ModuleManager::LoadModules(const vector< ConfigModule_t* >& vCfgModules)
 int ModuleManager::LoadTriggers(const vector< ConfigTrigger_t* >& vCfgTriggers)
 {
 	Trigger_t* pMod = NULL;
+	Module_t* pReuse;
 	void* pRet;
 	bool flag;
 
@@ -336,6 +433,13 @@ int ModuleManager::LoadTriggers(const vector< ConfigTrigger_t* >& vCfgTriggers)
 	for (size_t i = 0; i < vCfgTriggers.size(); ++i)
 	{
 		assert(vCfgTriggers[i]);
+		pReuse = Reuse(*vCfgTriggers[i], GET_MODULE_TYPE_TRIG(vCfgTriggers[i]->m_sType));
+		if (pReuse)
+		{
+			m_mapAllModule.insert(make_pair(pReuse->m_sName, pReuse));
+			m_mapTrigger.insert(make_pair(pReuse->m_sName, pReuse));
+			continue;
+		}
         if (!flag)
 		{
 			pMod = new Trigger_t;
@@ -346,6 +450,7 @@ int ModuleManager::LoadTriggers(const vector< ConfigTrigger_t* >& vCfgTriggers)
         pMod->m_sMain = vCfgTriggers[i]->m_sMain;
         pMod->m_sFileName = vCfgTriggers[i]->m_sFileName;
         pMod->m_sDesc = vCfgTriggers[i]->m_sDesc;
+        pMod->m_nTimeout = vCfgTriggers[i]->m_nTimeout;
 
         if (IS_SO(pMod->m_nType))
 		{
@@ -369,7 +474,10 @@ int ModuleManager::LoadTriggers(const vector< ConfigTrigger_t* >& vCfgTriggers)
 				m_pLogger->LogWrite(DEBUG_1, MODULE_JFR, LOG_FUNC_STRING, LOG_FUNC_VALUE);
 				continue;
 			}
-			pMod->m_pCallback = (ModCallback)pRet;
+			if (LoadCallback(pMod, pRet))
+			{
+				continue;
+			}
 		}
 		else
 		{
@@ -380,6 +488,9 @@ int ModuleManager::LoadTriggers(const vector< ConfigTrigger_t* >& vCfgTriggers)
 				continue;
 			}
 		}
+		pMod->m_pStats = new ModuleStats("module", pMod->m_sName);
+		Signature(*vCfgTriggers[i], pMod->m_nType, pMod->m_sSignature);
+		pMod->m_nRef = 1;
 		m_mapAllModule.insert(make_pair(pMod->m_sName, pMod));
 		m_mapTrigger.insert(make_pair(pMod->m_sName, pMod));
 		flag = false;
@@ -398,6 +509,7 @@ int ModuleManager::LoadTriggers(const vector< ConfigTrigger_t* >& vCfgTriggers)
 int ModuleManager::LoadStaticModules(const vector< ConfigStaticModule_t* >& vCfgStaticModules)
 {
 	Trigger_t* pMod = NULL;
+	Module_t* pReuse;
 	void* pRet;
 	bool flag;
 
@@ -407,6 +519,13 @@ int ModuleManager::LoadStaticModules(const vector< ConfigStaticModule_t* >& vCfg
 	for (size_t i = 0; i < vCfgStaticModules.size(); ++i)
 	{
 		assert(vCfgStaticModules[i]);
+		pReuse = Reuse(*vCfgStaticModules[i], GET_MODULE_TYPE_STATIC(vCfgStaticModules[i]->m_sType));
+		if (pReuse)
+		{
+			m_mapAllModule.insert(make_pair(pReuse->m_sName, pReuse));
+			m_mapStaticModule.insert(make_pair(pReuse->m_sName, pReuse));
+			continue;
+		}
         if (!flag)
 		{
 			pMod = new StaticModule_t;
@@ -440,7 +559,10 @@ int ModuleManager::LoadStaticModules(const vector< ConfigStaticModule_t* >& vCfg
 				m_pLogger->LogWrite(DEBUG_1, MODULE_JFR, LOG_FUNC_STRING, LOG_FUNC_VALUE);
 				continue;
 			}
-			pMod->m_pCallback = (ModCallback)pRet;
+			if (LoadCallback(pMod, pRet))
+			{
+				continue;
+			}
 		}
 		else
 		{
@@ -451,6 +573,9 @@ int ModuleManager::LoadStaticModules(const vector< ConfigStaticModule_t* >& vCfg
 				continue;
 			}
 		}
+		pMod->m_pStats = new ModuleStats("module", pMod->m_sName);
+		Signature(*vCfgStaticModules[i], pMod->m_nType, pMod->m_sSignature);
+		pMod->m_nRef = 1;
 		m_mapAllModule.insert(make_pair(pMod->m_sName, pMod));
 		m_mapStaticModule.insert(make_pair(pMod->m_sName, pMod));
 		flag = false;
@@ -466,6 +591,156 @@ int ModuleManager::LoadStaticModules(const vector< ConfigStaticModule_t* >& vCfg
 	return 0;
 }
 
+/// 重新加载时查找可复用的模块，名称、类型、配置和文件均未改变时复用，返回NULL表示需要重新加载
+Module_t* ModuleManager::Reuse(const ConfigModule_t& cfgModule, unsigned int nType)
+{
+	map< string, Module_t* >::iterator iter;
+	string sSignature;
+
+	iter = m_mapPrevious.find(cfgModule.m_sName);
+	if (iter == m_mapPrevious.end())
+	{
+		return NULL;
+	}
+	Signature(cfgModule, nType, sSignature);
+	if (sSignature == "" || sSignature != iter->second->m_sSignature)
+	{
+		return NULL;
+	}
+	m_oMutex.lock();
+	++iter->second->m_nRef;
+	m_oMutex.unlock();
+	m_pLogger->LogWrite(DEBUG_3, MODULE_JFR, "Reuse module, name: %s, filename: %s.", iter->second->m_sName.c_str(), iter->second->m_sFileName.c_str());
+	m_pLogger->LogWrite(DEBUG_1, MODULE_JFR, LOG_FUNC_STRING, LOG_FUNC_VALUE);
+
+	return iter->second;
+}
+
+/// 模块标识：类型、入口函数、文件名、超时、缓存配置、常驻进程配置，以及文件的设备号、inode、修改时间、大小；文件不存在时为空
+void ModuleManager::Signature(const ConfigModule_t& cfgModule, unsigned int nType, string& sSignature)
+{
+	struct stat st;
+	char buf[256];
+
+	sSignature = "";
+	if (stat(cfgModule.m_sFileName.c_str(), &st))
+	{
+		return;
+	}
+	snprintf(buf, sizeof(buf), "|%u|%u|%d|%u|%u|%u|%u|%u|%s|%lu|%lu|%ld|%ld", nType, cfgModule.m_nTimeout, cfgModule.m_bCache ? 1 : 0, \
+							cfgModule.m_nCacheTtl, cfgModule.m_nCacheMaxBytes, cfgModule.m_nWorkers, cfgModule.m_nMaxRequests, cfgModule.m_nMaxReplyBytes, cfgModule.m_sTransport.c_str(), \
+							(unsigned long)st.st_dev, (unsigned long)st.st_ino, (long)st.st_mtime, (long)st.st_size);
+	sSignature = cfgModule.m_sMain + "|" + cfgModule.m_sFileName + buf;
+}
+
+/// 按动态库导出的接口版本号取得回调函数，未导出版本号时为v1接口，v1接口可另有扩展回调函数<main>_ex
+int ModuleManager::LoadCallback(Module_t* pMod, void* pMain)
+{
+	const int* pVersion;
+	void* pRet;
+
+	pMod->m_pCallback = NULL;
+	pMod->m_pCallbackEx = NULL;
+	pMod->m_pCallbackV2 = NULL;
+	pVersion = (const int*)dlsym(pMod->m_pHandle, JFR_MODULE_ABI_SYMBOL);
+	pMod->m_nAbi = pVersion ? *pVersion : JFR_MODULE_ABI_V1;
+	if (pMod->m_nAbi == JFR_MODULE_ABI_V2)
+	{
+		pMod->m_pCallbackV2 = (ModCallbackV2)pMain;
+		return LoadHooks(pMod);
+	}
+	if (pMod->m_nAbi != JFR_MODULE_ABI_V1)
+	{
+		m_pLogger->LogWrite(WARNING, MODULE_JFR, "unsupported module abi version, name: %s, version: %d, filename: %s.", pMod->m_sName.c_str(), pMod->m_nAbi, pMod->m_sFileName.c_str());
+		m_pLogger->LogWrite(DEBUG_1, MODULE_JFR, LOG_FUNC_STRING, LOG_FUNC_VALUE);
+		return -1;
+	}
+	pMod->m_pCallback = (ModCallback)pMain;
+	pRet = dlsym(pMod->m_pHandle, (pMod->m_sMain + JFR_MODULE_CALLBACK_EX_SUFFIX).c_str());
+	if (pRet)		// 扩展接口，可选
+	{
+		pMod->m_pCallbackEx = (ModCallbackEx)pRet;
+	}
+
+	return LoadHooks(pMod);
+}
+
+/// 查找可选的生命周期函数<main>_init、<main>_thread_init、<main>_thread_fini、<main>_fini，并调用<main>_init生成模块状态
+// 模块状态和线程状态通过运行环境传给扩展回调函数和v2接口回调函数；<main>_init失败时不加载模块
+int ModuleManager::LoadHooks(Module_t* pMod)
+{
+	ModInit pInit;
+
+	pInit = (ModInit)dlsym(pMod->m_pHandle, (pMod->m_sMain + JFR_MODULE_INIT_SUFFIX).c_str());
+	pMod->m_pThreadInit = (ModThreadInit)dlsym(pMod->m_pHandle, (pMod->m_sMain + JFR_MODULE_THREAD_INIT_SUFFIX).c_str());
+	pMod->m_pThreadFini = (ModThreadFini)dlsym(pMod->m_pHandle, (pMod->m_sMain + JFR_MODULE_THREAD_FINI_SUFFIX).c_str());
+	pMod->m_pFini = (ModFini)dlsym(pMod->m_pHandle, (pMod->m_sMain + JFR_MODULE_FINI_SUFFIX).c_str());
+	pMod->m_pState = NULL;
+	pMod->m_nSerial = ++m_nSerial;
+	if (pInit && pInit(m_pLogger, &pMod->m_pState))
+	{
+		m_pLogger->LogWrite(WARNING, MODULE_JFR, "module init failed, name: %s, main: %s, filename: %s.", pMod->m_sName.c_str(), pMod->m_sMain.c_str(), pMod->m_sFileName.c_str());
+		m_pLogger->LogWrite(DEBUG_1, MODULE_JFR, LOG_FUNC_STRING, LOG_FUNC_VALUE);
+		pMod->m_pThreadInit = NULL;
+		pMod->m_pThreadFini = NULL;
+		pMod->m_pFini = NULL;
+		pMod->m_pState = NULL;
+		return -1;
+	}
+
+	return 0;
+}
+
+/// 卸载动态库前释放线程状态和模块状态，此时模块已没有运行中的调用
+void ModuleManager::Finalize(Module_t* pMod)
+{
+	for (size_t i = 0; i < pMod->m_vThreadStates.size(); ++i)
+	{
+		if (pMod->m_pThreadFini)
+		{
+			pMod->m_pThreadFini(m_pLogger, pMod->m_pState, pMod->m_vThreadStates[i]);
+		}
+	}
+	pMod->m_vThreadStates.clear();
+	if (pMod->m_pFini)
+	{
+		pMod->m_pFini(m_pLogger, pMod->m_pState);
+	}
+	pMod->m_pState = NULL;
+}
+
+/// 当前加载的所有模块引用计数加一，由流程配置代持有
+void ModuleManager::RetainAll(vector< Module_t* >& vModules)
+{
+	map< string, Module_t* >::iterator iter, end;
+
+	boost::lock_guard< boost::mutex > guard(m_oMutex);
+	end = m_mapAllModule.end();
+	for (iter = m_mapAllModule.begin(); iter != end; ++iter)
+	{
+		++iter->second->m_nRef;
+		vModules.push_back(iter->second);
+	}
+}
+
+/// 引用计数减一，归零时关闭动态库并释放模块
+void ModuleManager::Release(Module_t* pMod)
+{
+	assert(pMod);
+	boost::lock_guard< boost::mutex > guard(m_oMutex);
+	assert(pMod->m_nRef > 0);
+	if (--pMod->m_nRef > 0)
+	{
+		return;
+	}
+	if (IS_SO(pMod->m_nType) && pMod->m_pHandle)
+	{
+		Finalize(pMod);
+		dlclose(pMod->m_pHandle);
+	}
+	delete pMod;
+}
+
 const Module_t* ModuleManager::GetModule(const string& name) const
 {
     map< string, Module_t* >::const_iterator iter = m_mapModule.find(name);
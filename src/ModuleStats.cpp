@@ -0,0 +1,80 @@
+#include "ModuleStats.h"
+
+OPEN_NAMESPACE_JFR
+
+ModuleStats::ModuleStats(const string& kind, const string& name)
+{
+	m_sKind = kind;
+	m_sName = name;
+	m_nCalls = 0;
+	m_nQueueUs = 0;
+	m_nWallUs = 0;
+	m_nUserUs = 0;
+	m_nSysUs = 0;
+	m_nMaxRss = 0;
+	m_oReport = boost::get_system_time();
+	m_pLogger = &jfr::LoggerSingleton::get_mutable_instance();
+}
+
+ModuleStats::~ModuleStats(void)
+{
+	Report();
+}
+
+/// 单调时钟，微秒
+uint64_t ModuleStats::Now(void)
+{
+	struct timespec ts;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return (uint64_t)ts.tv_sec * 1000000 + ts.tv_nsec / 1000;
+}
+
+void ModuleStats::Record(const ModUsage_t& usage)
+{
+	boost::lock_guard< boost::mutex > guard(m_oMutex);
+	++m_nCalls;
+	m_nQueueUs += usage.m_nQueueUs;
+	m_nWallUs += usage.m_nWallUs;
+	m_nUserUs += usage.m_nUserUs;
+	m_nSysUs += usage.m_nSysUs;
+	if (usage.m_nMaxRss > m_nMaxRss)
+	{
+		m_nMaxRss = usage.m_nMaxRss;
+	}
+	TryReport();
+}
+
+/// 输出资源统计，没有调用时不输出
+void ModuleStats::Report(void)
+{
+	boost::lock_guard< boost::mutex > guard(m_oMutex);
+	if (m_nCalls > 0)
+	{
+		LogStats();
+	}
+}
+
+/// 持有m_oMutex时调用，距上次输出超过间隔时输出统计
+void ModuleStats::TryReport(void)
+{
+	if (boost::get_system_time() - m_oReport >= boost::posix_time::milliseconds(JFR_MODULE_STATS_REPORT_INTERVAL))
+	{
+		LogStats();
+	}
+}
+
+/// 持有m_oMutex时调用，统计自创建起累计
+void ModuleStats::LogStats(void)
+{
+	m_pLogger->LogWrite(INFO, MODULE_JFR, "%s stats, name: %s, calls: %lu, avg queue: %.3f ms, avg wall: %.3f ms, user cpu: %.3f s, sys cpu: %.3f s, max rss: %ld KB.", \
+											m_sKind.c_str(), m_sName.c_str(), m_nCalls, \
+											m_nCalls ? m_nQueueUs / 1000.0 / m_nCalls : 0.0, \
+											m_nCalls ? m_nWallUs / 1000.0 / m_nCalls : 0.0, \
+											m_nUserUs / 1000000.0, m_nSysUs / 1000000.0, m_nMaxRss);
+	m_pLogger->LogWrite(DEBUG_1, MODULE_JFR, LOG_FUNC_STRING, LOG_FUNC_VALUE);
+	m_oReport = boost::get_system_time();
+}
+
+
+CLOSE_NAMESPACE_JFR
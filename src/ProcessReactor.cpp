@@ -0,0 +1,240 @@
+#include "ProcessReactor.h"
+
+OPEN_NAMESPACE_JFR
+
+ProcessReactor::ProcessReactor(void)
+{
+	m_nEpoll = -1;
+	m_nWake = -1;
+	m_pThread = NULL;
+	m_bStop = false;
+	m_pLogger = &jfr::LoggerSingleton::get_mutable_instance();
+}
+
+ProcessReactor::~ProcessReactor(void)
+{
+	Stop();
+}
+
+int ProcessReactor::Start(void)
+{
+	struct epoll_event ev;
+
+	boost::lock_guard< boost::mutex > guard(m_oMutex);
+	if (m_pThread)
+	{
+		return 0;
+	}
+	m_nEpoll = epoll_create1(EPOLL_CLOEXEC);
+	m_nWake = eventfd(0, EFD_CLOEXEC | EFD_NONBLOCK);
+	ev.events = EPOLLIN;
+	ev.data.fd = m_nWake;
+	if (m_nEpoll == -1 || m_nWake == -1 || epoll_ctl(m_nEpoll, EPOLL_CTL_ADD, m_nWake, &ev) == -1)
+	{
+		m_pLogger->LogWrite(ERROR, MODULE_JFR, "make process reactor failed, %s, errno: %d.", strerror(errno), errno);
+		m_pLogger->LogWrite(DEBUG_1, MODULE_JFR, LOG_FUNC_STRING, LOG_FUNC_VALUE);
+		if (m_nEpoll != -1)
+		{
+			close(m_nEpoll);
+			m_nEpoll = -1;
+		}
+		if (m_nWake != -1)
+		{
+			close(m_nWake);
+			m_nWake = -1;
+		}
+		return -1;
+	}
+	m_bStop = false;
+	m_pThread = new boost::thread(boost::bind(&ProcessReactor::Run, this));
+
+	return 0;
+}
+
+/// 停止后未结束的监控项不再处理
+void ProcessReactor::Stop(void)
+{
+	boost::thread* pThread;
+	uint64_t one = 1;
+
+	{
+		boost::lock_guard< boost::mutex > guard(m_oMutex);
+		pThread = m_pThread;
+		m_pThread = NULL;
+		m_bStop = true;
+		if (pThread && write(m_nWake, &one, sizeof(one)) == -1)
+		{
+			m_pLogger->LogWrite(ERROR, MODULE_JFR, "wake process reactor failed, %s, errno: %d.", strerror(errno), errno);
+			m_pLogger->LogWrite(DEBUG_1, MODULE_JFR, LOG_FUNC_STRING, LOG_FUNC_VALUE);
+		}
+	}
+	if (pThread)
+	{
+		pThread->join();
+		delete pThread;
+		close(m_nEpoll);
+		close(m_nWake);
+		m_nEpoll = -1;
+		m_nWake = -1;
+	}
+}
+
+/// 登记子进程，返回后监控项归反应器所有直到调用m_pDone；未启动时返回-1，调用者同步等待
+int ProcessReactor::Add(ProcWatch_t* pWatch)
+{
+	struct epoll_event ev;
+
+	assert(pWatch && pWatch->m_nFd >= 0 && pWatch->m_nPidFd >= 0 && pWatch->m_pArena && pWatch->m_pDone);
+	boost::lock_guard< boost::mutex > guard(m_oMutex);
+	if (m_pThread == NULL || m_bStop)
+	{
+		return -1;
+	}
+	m_mapFds[pWatch->m_nFd] = pWatch;
+	m_mapFds[pWatch->m_nPidFd] = pWatch;
+	ev.events = EPOLLIN;
+	ev.data.fd = pWatch->m_nFd;
+	if (epoll_ctl(m_nEpoll, EPOLL_CTL_ADD, pWatch->m_nFd, &ev) == -1)
+	{
+		m_mapFds.erase(pWatch->m_nFd);
+		m_mapFds.erase(pWatch->m_nPidFd);
+		return -1;
+	}
+	ev.data.fd = pWatch->m_nPidFd;
+	if (epoll_ctl(m_nEpoll, EPOLL_CTL_ADD, pWatch->m_nPidFd, &ev) == -1)		// 输出描述符已登记，此后由反应器线程处理
+	{
+		m_pLogger->LogWrite(FATAL, MODULE_JFR, "watch child process failed, %s, errno: %d, pid: %d.", strerror(errno), errno, pWatch->m_nPid);
+		m_pLogger->LogWrite(FATAL, MODULE_JFR, LOG_FUNC_STRING, LOG_FUNC_VALUE);
+		assert(0);
+	}
+
+	return 0;
+}
+
+/// 内核不支持时返回-1
+int ProcessReactor::OpenPidFd(pid_t pid)
+{
+	return syscall(SYS_pidfd_open, pid, 0);
+}
+
+void ProcessReactor::Run(void)
+{
+	struct epoll_event events[JFR_REACTOR_MAX_EVENTS];
+	map< int, ProcWatch_t* >::iterator iter;
+	int n;
+
+	m_pLogger->LogWrite(DEBUG_3, MODULE_JFR, "Begin to run process reactor.");
+	m_pLogger->LogWrite(DEBUG_1, MODULE_JFR, LOG_FUNC_STRING, LOG_FUNC_VALUE);
+	while (1)
+	{
+		n = epoll_wait(m_nEpoll, events, JFR_REACTOR_MAX_EVENTS, -1);
+		if (n == -1)
+		{
+			if (errno == EINTR)
+			{
+				continue;
+			}
+			m_pLogger->LogWrite(ERROR, MODULE_JFR, "wait process reactor events failed, %s, errno: %d.", strerror(errno), errno);
+			m_pLogger->LogWrite(FATAL, MODULE_JFR, LOG_FUNC_STRING, LOG_FUNC_VALUE);
+			assert(0);
+		}
+		for (int i = 0; i < n; ++i)
+		{
+			int fd = events[i].data.fd;
+			ProcWatch_t* pWatch;
+
+			if (fd == m_nWake)
+			{
+				boost::lock_guard< boost::mutex > guard(m_oMutex);
+				if (m_bStop)
+				{
+					m_pLogger->LogWrite(DEBUG_3, MODULE_JFR, "End to run process reactor.");
+					m_pLogger->LogWrite(DEBUG_1, MODULE_JFR, LOG_FUNC_STRING, LOG_FUNC_VALUE);
+					return;
+				}
+				continue;
+			}
+			{
+				boost::lock_guard< boost::mutex > guard(m_oMutex);
+				iter = m_mapFds.find(fd);
+				if (iter == m_mapFds.end())		// 同一批事件中已处理完的监控项
+				{
+					continue;
+				}
+				pWatch = iter->second;
+			}
+			if (fd == pWatch->m_nFd)
+			{
+				OnOutput(pWatch);
+			}
+			else
+			{
+				Remove(pWatch->m_nPidFd);
+				pWatch->m_nPidFd = -1;
+				pWatch->m_bExited = true;
+			}
+			if (pWatch->m_bEof && pWatch->m_bExited)
+			{
+				pWatch->m_pDone(pWatch);
+			}
+		}
+	}
+}
+
+/// 读取到EAGAIN或文件结束，按倍数从内存区扩展缓冲区
+void ProcessReactor::OnOutput(ProcWatch_t* pWatch)
+{
+	ssize_t ret;
+
+	while (1)
+	{
+		if (pWatch->m_nLength == pWatch->m_nCap)
+		{
+			size_t cap = pWatch->m_nCap ? pWatch->m_nCap * 2 : 1024;
+			pWatch->m_pBuf = (char*)pWatch->m_pArena->Grow((void*)pWatch->m_pBuf, pWatch->m_nLength, cap);
+			pWatch->m_nCap = cap;
+		}
+		ret = read(pWatch->m_nFd, pWatch->m_pBuf + pWatch->m_nLength, pWatch->m_nCap - pWatch->m_nLength);
+		if (ret > 0)
+		{
+			pWatch->m_nLength += ret;
+			continue;
+		}
+		if (ret == -1 && errno == EINTR)
+		{
+			continue;
+		}
+		if (ret == -1 && errno == EAGAIN)
+		{
+			return;
+		}
+		if (ret == -1)
+		{
+			m_pLogger->LogWrite(ERROR, MODULE_JFR, "read failed, %s, errno: %d, pid: %d.", strerror(errno), errno, pWatch->m_nPid);
+			m_pLogger->LogWrite(DEBUG_1, MODULE_JFR, LOG_FUNC_STRING, LOG_FUNC_VALUE);
+			pWatch->m_pBuf = NULL;
+			pWatch->m_nLength = 0;
+		}
+		else
+		{
+			pWatch->m_pBuf[pWatch->m_nLength] = '\0';		// 读取前保证至少有一个字节空间
+		}
+		Remove(pWatch->m_nFd);
+		pWatch->m_nFd = -1;
+		pWatch->m_bEof = true;
+		return;
+	}
+}
+
+void ProcessReactor::Remove(int fd)
+{
+	{
+		boost::lock_guard< boost::mutex > guard(m_oMutex);
+		m_mapFds.erase(fd);
+	}
+	epoll_ctl(m_nEpoll, EPOLL_CTL_DEL, fd, NULL);
+	close(fd);
+}
+
+
+CLOSE_NAMESPACE_JFR
@@ -0,0 +1,154 @@
+#include "ResultCache.h"
+
+OPEN_NAMESPACE_JFR
+
+ResultCache::ResultCache(const string& name, unsigned int ttl, size_t maxBytes)
+{
+	m_sName = name;
+	m_nTtl = ttl;
+	m_nMaxBytes = maxBytes;
+	m_nBytes = 0;
+	m_nHits = 0;
+	m_nMisses = 0;
+	m_nEvictions = 0;
+	m_oReport = boost::get_system_time();
+	m_pLogger = &jfr::LoggerSingleton::get_mutable_instance();
+}
+
+ResultCache::~ResultCache(void)
+{
+	Report();
+}
+
+/// 追加一个入参到缓存键，带长度前缀避免不同入参拼接后相同，NULL与空字符串区分
+// len为0时按'\0'结尾的字符串处理
+void ResultCache::AppendKey(string& key, const char* value, size_t len)
+{
+	char prefix[32];
+
+	if (!value)
+	{
+		key.append("-:", 2);
+		return;
+	}
+	size_t n = len ? len : strlen(value);
+	snprintf(prefix, sizeof(prefix), "%lu:", (unsigned long)n);
+	key.append(prefix);
+	key.append(value, n);
+}
+
+/// 命中时返回true，pOutput为出参的副本(从pArena分配，另以'\0'结尾)，nLength、nType为保存时的长度和类型，无出参时为NULL
+bool ResultCache::Lookup(const string& key, int& nRetValue, char*& pOutput, size_t& nLength, unsigned int& nType, Arena* pArena)
+{
+	boost::unordered_map< string, EntryIter >::iterator iter;
+
+	boost::lock_guard< boost::mutex > guard(m_oMutex);
+	TryReport();
+	iter = m_mapIndex.find(key);
+	if (iter == m_mapIndex.end())
+	{
+		++m_nMisses;
+		return false;
+	}
+	EntryIter e_iter = iter->second;
+	if (m_nTtl > 0 && e_iter->m_oExpire <= boost::get_system_time())		// 已过期
+	{
+		Evict(e_iter);
+		++m_nEvictions;
+		++m_nMisses;
+		return false;
+	}
+	m_lEntries.splice(m_lEntries.begin(), m_lEntries, e_iter);
+	nRetValue = e_iter->m_nRetValue;
+	pOutput = NULL;
+	nLength = 0;
+	nType = e_iter->m_nType;
+	if (e_iter->m_bOutput)
+	{
+		pOutput = pArena->Strdup(e_iter->m_sOutput.data(), e_iter->m_sOutput.length());
+		nLength = e_iter->m_sOutput.length();
+	}
+	++m_nHits;
+
+	return true;
+}
+
+/// 保存模块结果，出参按nLength字节保存，单个结果超过占用上限时不缓存
+void ResultCache::Store(const string& key, int nRetValue, const char* pOutput, size_t nLength, unsigned int nType)
+{
+	boost::unordered_map< string, EntryIter >::iterator iter;
+	CacheEntry_t entry;
+
+	entry.m_sKey = key;
+	entry.m_bOutput = pOutput != NULL;
+	if (pOutput)
+	{
+		entry.m_sOutput.assign(pOutput, nLength);
+	}
+	entry.m_nType = nType;
+	entry.m_nRetValue = nRetValue;
+	entry.m_nBytes = sizeof(CacheEntry_t) + key.length() * 2 + entry.m_sOutput.length();		// 键在索引中另存一份
+	if (m_nTtl > 0)
+	{
+		entry.m_oExpire = boost::get_system_time() + boost::posix_time::milliseconds(m_nTtl);
+	}
+	if (entry.m_nBytes > m_nMaxBytes)
+	{
+		return;
+	}
+
+	boost::lock_guard< boost::mutex > guard(m_oMutex);
+	iter = m_mapIndex.find(key);
+	if (iter != m_mapIndex.end())		// 并发运行的相同调用
+	{
+		Evict(iter->second);
+	}
+	while (m_nBytes + entry.m_nBytes > m_nMaxBytes && !m_lEntries.empty())
+	{
+		Evict(--m_lEntries.end());
+		++m_nEvictions;
+	}
+	m_lEntries.push_front(entry);
+	m_mapIndex.insert(make_pair(key, m_lEntries.begin()));
+	m_nBytes += entry.m_nBytes;
+}
+
+/// 输出命中统计
+void ResultCache::Report(void)
+{
+	boost::lock_guard< boost::mutex > guard(m_oMutex);
+	LogStats();
+}
+
+/// 持有m_oMutex时调用
+void ResultCache::Evict(EntryIter iter)
+{
+	m_nBytes -= iter->m_nBytes;
+	m_mapIndex.erase(iter->m_sKey);
+	m_lEntries.erase(iter);
+}
+
+/// 持有m_oMutex时调用，距上次输出超过间隔时输出统计
+void ResultCache::TryReport(void)
+{
+	if (boost::get_system_time() - m_oReport >= boost::posix_time::milliseconds(JFR_RESULT_CACHE_REPORT_INTERVAL))
+	{
+		LogStats();
+	}
+}
+
+/// 持有m_oMutex时调用
+void ResultCache::LogStats(void)
+{
+	unsigned long total;
+
+	total = m_nHits + m_nMisses;
+	m_pLogger->LogWrite(INFO, MODULE_JFR, "result cache stats, module name: %s, hits: %lu, misses: %lu, hit rate: %.1f%%, evictions: %lu, entries: %lu, bytes: %lu.", \
+											m_sName.c_str(), m_nHits, m_nMisses, total ? m_nHits * 100.0 / total : 0.0, \
+											m_nEvictions, (unsigned long)m_mapIndex.size(), (unsigned long)m_nBytes);
+	m_pLogger->LogWrite(DEBUG_1, MODULE_JFR, LOG_FUNC_STRING, LOG_FUNC_VALUE);
+	m_oReport = boost::get_system_time();
+}
+
+
+CLOSE_NAMESPACE_JFR
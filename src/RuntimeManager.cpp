@@ -6,8 +6,9 @@ RuntimeManager::RuntimeManager(void)
 {
 	m_pLineSet = NULL;
 	m_pStaticSet = NULL;
+	m_pRefreshThread = NULL;
+	m_pReloadThread = NULL;
 	m_pLogger = NULL;
-	m_nRunListMaxSize = 0;
 	m_bInited = false;
 }
 
@@ -16,8 +17,12 @@ RuntimeManager::~RuntimeManager(void)
     Clear();
 }
 
-int RuntimeManager::Init(size_t max, const vector< Line_t* >& vLines, const vector< LineStaticModule_t* >& vStaticModules)
+/// max为运行队列总长度，threads为调度线程数，ready为就绪队列总上限
+int RuntimeManager::Init(size_t max, size_t threads, size_t ready, const FlowGenerationPtr& pGeneration)
 {
+	size_t shards;
+	const vector< Line_t* >& vLines = pGeneration->m_vLines;
+
 	if (IsInited())
 	{
 		Clear();
@@ -26,21 +31,37 @@ int RuntimeManager::Init(size_t max, const vector< Line_t* >& vLines, const vect
 	m_pLineSet = &RuntimeSet< Runtime_t, Line_t >::get_mutable_instance();
 	m_pStaticSet = &RuntimeSet< StaticRuntime_t, LineStaticModule_t >::get_mutable_instance();
 	m_pLogger = &jfr::LoggerSingleton::get_mutable_instance();
-    m_nRunListMaxSize = max;
-    if (m_pLineSet->Init(vLines) || m_pStaticSet->Init(vStaticModules))
+    if (m_pLineSet->Init(vLines, pGeneration) || m_pStaticSet->Init(pGeneration->m_vStaticModules, pGeneration))
 	{
 		m_pLogger->LogWrite(ERROR, MODULE_JFR, "init runtime set failed.");
 		m_pLogger->LogWrite(DEBUG_1, MODULE_JFR, LOG_FUNC_STRING, LOG_FUNC_VALUE);
 		return -1;
 	}
-	for(size_t i = 0; i < vLines.size(); ++i)
+
+	/// 分片数不超过主线数和运行队列长度，主线按编号取模划分，运行队列长度、就绪队列上限平均分配
+	shards = min(min(threads, vLines.size()), max);
+	if (shards == 0)
 	{
-		m_vLineNames.push_back(vLines[i]->m_sName);
+		shards = 1;
 	}
-	for (size_t i = 0; i < vStaticModules.size(); ++i)
+	EventQueue::get_mutable_instance().Init(shards);
+	for (size_t i = 0; i < shards; ++i)
 	{
-		m_vStaticNames.push_back(vStaticModules[i]->m_sName);
+		vector< Line_t* > vShardLines;
+		for (size_t j = i; j < vLines.size(); j += shards)
+		{
+			vLines[j]->m_nShard = i;
+			vShardLines.push_back(vLines[j]);
+		}
+		RuntimeShard* pShard = new RuntimeShard;
+		pShard->Init(i, max / shards + (i < max % shards ? 1 : 0), ready > shards ? ready / shards + (i < ready % shards ? 1 : 0) : 1, vShardLines, pGeneration->m_nGeneration);
+		m_vShards.push_back(pShard);
 	}
+	m_pLogger->LogWrite(DEBUG_3, MODULE_JFR, "runtime shards: %d, lines: %d.", shards, vLines.size());
+	m_pLogger->LogWrite(DEBUG_1, MODULE_JFR, LOG_FUNC_STRING, LOG_FUNC_VALUE);
+
+	m_pGeneration = pGeneration;
+	SetStaticModules();
 	m_bInited = true;
 
 	return 0;
@@ -48,40 +69,67 @@ int RuntimeManager::Init(size_t max, const vector< Line_t* >& vLines, const vect
 
 void RuntimeManager::Clear(void)
 {
+	if (m_pReloadThread)
+	{
+		m_pReloadThread->interrupt();
+		m_pReloadThread->join();
+		delete m_pReloadThread;
+		m_pReloadThread = NULL;
+	}
 	ClearLines();
 	ClearStaticModules();
 }
 
 void RuntimeManager::ClearStaticModules(void)
 {
-	list< StaticRuntime_t* >::iterator l_iter, l_end;
+	StopRefresh();
+	/// 静态模块运行时由参数版本持有，版本不再被主线实例使用时归还
+	StaticModuleArgSet::get_mutable_instance().Clear();
+}
 
-	l_end = m_lStaticList.end();
-	for (l_iter = m_lStaticList.begin(); l_iter != l_end; ++l_iter)
+/// 按当前的一代记录静态模块名称和刷新间隔
+void RuntimeManager::SetStaticModules(void)
+{
+	m_vStaticNames.clear();
+	m_vStaticRefresh.clear();
+	for (size_t i = 0; i < m_pGeneration->m_vStaticModules.size(); ++i)
 	{
-		if (*l_iter == NULL)
+		m_vStaticNames.push_back(m_pGeneration->m_vStaticModules[i]->m_sName);
+		m_vStaticRefresh.push_back(m_pGeneration->m_vStaticModules[i]->m_nRefreshInterval);
+	}
+}
+
+/// 有静态模块配置了刷新间隔时启动刷新线程
+void RuntimeManager::StartRefresh(void)
+{
+	for (size_t i = 0; i < m_vStaticRefresh.size(); ++i)
+	{
+		if (m_vStaticRefresh[i] > 0)
 		{
-			continue;
+			m_pRefreshThread = new boost::thread(boost::bind(&RuntimeManager::RefreshStaticModules, this));
+			break;
 		}
-        m_pStaticSet->Release(*l_iter);
 	}
-	m_lStaticList.clear();
 }
 
-void RuntimeManager::ClearLines(void)
+void RuntimeManager::StopRefresh(void)
 {
-	list< Runtime_t* >::iterator l_iter, l_end;
+	if (m_pRefreshThread)
+	{
+		m_pRefreshThread->interrupt();
+		m_pRefreshThread->join();
+		delete m_pRefreshThread;
+		m_pRefreshThread = NULL;
+	}
+}
 
-	l_end = m_lRunList.end();
-	for (l_iter = m_lRunList.begin(); l_iter != l_end; ++l_iter)
+void RuntimeManager::ClearLines(void)
+{
+	for (size_t i = 0; i < m_vShards.size(); ++i)
 	{
-		if (*l_iter == NULL)
-		{
-			continue;
-		}
-        m_pLineSet->Release(*l_iter);
+		delete m_vShards[i];
 	}
-	m_lRunList.clear();
+	m_vShards.clear();
 }
 
 bool RuntimeManager::IsInited(void)
@@ -105,537 +153,272 @@ int RuntimeManager::Run(void)
 		m_pLogger->LogWrite(DEBUG_1, MODULE_JFR, LOG_FUNC_STRING, LOG_FUNC_VALUE);
 		return -1;
 	}
+	PrewarmLines(m_pGeneration);
+	m_pReloadThread = new boost::thread(boost::bind(&RuntimeManager::WaitReload, this));
 	return RunLines();
 }
 
 int RuntimeManager::RunStaticModules(void)
 {
-	int ret;
-
-    if (!m_lStaticList.empty())
-	{
-		ClearStaticModules();
-	}
-
+	ClearStaticModules();
 	m_pLogger->LogWrite(DEBUG_3, MODULE_JFR, "Begin to run static modules.");
 	m_pLogger->LogWrite(DEBUG_1, MODULE_JFR, LOG_FUNC_STRING, LOG_FUNC_VALUE);
 	for (size_t i = 0; i < m_vStaticNames.size(); ++i)
 	{
-		StaticRuntime_t* pRuntime = m_pStaticSet->Obtain(m_vStaticNames[i]);
+		StaticRuntime_t* pRuntime = RunStaticModule(m_vStaticNames[i]);
 		if (pRuntime == NULL)
 		{
-			m_pLogger->LogWrite(ERROR, MODULE_JFR, "create static modules instance failed, static module name: %s.", m_vStaticNames[i].c_str());
-			m_pLogger->LogWrite(DEBUG_1, MODULE_JFR, LOG_FUNC_STRING, LOG_FUNC_VALUE);
-            return -1;
-		}
-		ret = ModuleCaller::Call(pRuntime);
-		if (ret == -1)
-		{
-			m_pLogger->LogWrite(ERROR, MODULE_JFR, "call static modules instance failed, static module name: %s.", m_vStaticNames[i].c_str());
-			m_pLogger->LogWrite(DEBUG_1, MODULE_JFR, LOG_FUNC_STRING, LOG_FUNC_VALUE);
-            return -1;
-		}
-		pRuntime->m_pCtx->m_oMutex.lock();
-		if (pRuntime->m_pCtx->m_nStat != RTS_FINISH)
-		{
-			pRuntime->m_pCtx->m_oMutex.unlock();
-			m_pLogger->LogWrite(ERROR, MODULE_JFR, "call static modules instance failed, not finished, static module name: %s.", m_vStaticNames[i].c_str());
-			m_pLogger->LogWrite(DEBUG_1, MODULE_JFR, LOG_FUNC_STRING, LOG_FUNC_VALUE);
             return -1;
 		}
-		if (pRuntime->m_pCtx->m_nRetValue != 0)		// 静态模块返回值非零表示运行失败
-		{
-			pRuntime->m_pCtx->m_nStat = RTS_ERROR;
-			pRuntime->m_pCtx->m_oMutex.unlock();
-			m_pLogger->LogWrite(ERROR, MODULE_JFR, "call static modules instance failed, return value not expected, static module name: %s, return value: %d.", m_vStaticNames[i].c_str(), pRuntime->m_pCtx->m_nRetValue);
-			m_pLogger->LogWrite(DEBUG_1, MODULE_JFR, LOG_FUNC_STRING, LOG_FUNC_VALUE);
-			return -1;
-		}
-		else
-		{
-            pRuntime->m_pCtx->m_nStat = RTS_STATIC;
-		}
-		pRuntime->m_pCtx->m_oMutex.unlock();
-		m_lStaticList.push_back(pRuntime);
+		StaticModuleArgSet::get_mutable_instance().Publish(pRuntime);
 	}
+	StartRefresh();
 	m_pLogger->LogWrite(DEBUG_3, MODULE_JFR, "End to run static modules.");
 	m_pLogger->LogWrite(DEBUG_1, MODULE_JFR, LOG_FUNC_STRING, LOG_FUNC_VALUE);
 
 	return 0;
 }
 
-int RuntimeManager::RunLines(void)
+/// 运行一次静态模块，返回持有运行结果的运行时，失败时返回NULL
+StaticRuntime_t* RuntimeManager::RunStaticModule(const string& name)
 {
-	list< Runtime_t* >::iterator l_iter, l_end;
-	vector< string >::iterator v_iter;
+	int ret;
 
-	if (!m_lRunList.empty())
+	StaticRuntime_t* pRuntime = m_pStaticSet->Obtain(name);
+	if (pRuntime == NULL)
 	{
-		ClearLines();
+		m_pLogger->LogWrite(ERROR, MODULE_JFR, "create static modules instance failed, static module name: %s.", name.c_str());
+		m_pLogger->LogWrite(DEBUG_1, MODULE_JFR, LOG_FUNC_STRING, LOG_FUNC_VALUE);
+		return NULL;
 	}
-
-	m_pLogger->LogWrite(DEBUG_3, MODULE_JFR, "Begin to run lines.");
-	m_pLogger->LogWrite(DEBUG_1, MODULE_JFR, LOG_FUNC_STRING, LOG_FUNC_VALUE);
-	while (1)
+	ret = ModuleCaller::Call(pRuntime);
+	if (ret == -1)
 	{
-		v_iter = m_vLineNames.begin();
-		while (v_iter != m_vLineNames.end())
-		{
-			if (m_lRunList.size() < m_nRunListMaxSize)
-			{
-				Runtime_t* pRuntime = m_pLineSet->Obtain(*v_iter);
-				assert(pRuntime);
-				m_lRunList.push_back(pRuntime);
-				v_iter = m_vLineNames.erase(v_iter);
-				continue;
-			}
-			else
-			{
-				break;
-			}
-			++v_iter;
-		}
-
-		l_iter = m_lRunList.begin();
-		l_end = m_lRunList.end();
-		while (l_iter != l_end)
-		{
-			if (*l_iter == NULL)
-			{
-				l_iter = m_lRunList.erase(l_iter);
-				continue;
-			}
-
-			MainlineFSM(*l_iter);
-			++l_iter;
-		}
-
-		usleep(100 * 1000);
+		m_pStaticSet->Release(pRuntime);
+		m_pLogger->LogWrite(ERROR, MODULE_JFR, "call static modules instance failed, static module name: %s.", name.c_str());
+		m_pLogger->LogWrite(DEBUG_1, MODULE_JFR, LOG_FUNC_STRING, LOG_FUNC_VALUE);
+		return NULL;
 	}
-	m_pLogger->LogWrite(DEBUG_3, MODULE_JFR, "End to run lines.");
-	m_pLogger->LogWrite(DEBUG_1, MODULE_JFR, LOG_FUNC_STRING, LOG_FUNC_VALUE);
-
-	return 0;
-}
-
-int RuntimeManager::MainlineFSM(Runtime_t* pRuntime)
-{
-	assert(pRuntime);
-	switch (pRuntime->m_nStat)
+	if (pRuntime->m_pCtx->m_nStat.load(boost::memory_order_acquire) != RTS_FINISH)		// 静态模块同步运行，结束状态已写入
 	{
-		case RTS_INIT:
-			m_pLogger->LogWrite(DEBUG_3, MODULE_JFR, "New line init.");
-			m_pLogger->LogWrite(DEBUG_1, MODULE_JFR, LOG_FUNC_STRING, LOG_FUNC_VALUE);
-		case RTS_WAIT:
-			TriggerFSM(pRuntime);
-			break;
-		case RTS_RUN:
-			ModuleFSM(pRuntime);
-			break;
-		case RTS_FINISH:
-			m_pLogger->LogWrite(DEBUG_3, MODULE_JFR, "New line finish.");
-			m_pLogger->LogWrite(DEBUG_1, MODULE_JFR, LOG_FUNC_STRING, LOG_FUNC_VALUE);
-			pRuntime->m_oMutex.lock();
-			pRuntime->m_nStat = RTS_DESTROY;
-			pRuntime->m_oMutex.unlock();
-			break;
-		case RTS_ERROR:
-			m_pLogger->LogWrite(DEBUG_3, MODULE_JFR, "New line error.");
-			m_pLogger->LogWrite(DEBUG_1, MODULE_JFR, LOG_FUNC_STRING, LOG_FUNC_VALUE);
-			pRuntime->m_oMutex.lock();
-			pRuntime->m_nStat = RTS_DESTROY;
-			pRuntime->m_oMutex.unlock();
-			break;
-		case RTS_DESTROY:
-			m_pLogger->LogWrite(DEBUG_3, MODULE_JFR, "New line destroy.");
-			m_pLogger->LogWrite(DEBUG_1, MODULE_JFR, LOG_FUNC_STRING, LOG_FUNC_VALUE);
-			FSMLineDestroy(pRuntime);
-			break;
-		default:
-			m_pLogger->LogWrite(DEBUG_1, MODULE_JFR, LOG_FUNC_STRING, LOG_FUNC_VALUE);
-			assert(0);
-			break;
+		m_pStaticSet->Release(pRuntime);
+		m_pLogger->LogWrite(ERROR, MODULE_JFR, "call static modules instance failed, not finished, static module name: %s.", name.c_str());
+		m_pLogger->LogWrite(DEBUG_1, MODULE_JFR, LOG_FUNC_STRING, LOG_FUNC_VALUE);
+		return NULL;
 	}
-
-	return 0;
-}
-
-int RuntimeManager::TriggerFSM(Runtime_t* pRuntime)
-{
-	assert(pRuntime);
-	switch (pRuntime->m_pTriggerCtx->m_nStat)
+	if (pRuntime->m_pCtx->m_nRetValue != 0)		// 静态模块返回值非零表示运行失败
 	{
-		case RTS_INIT:
-			FSMTriggerInit(pRuntime);
-			m_pLogger->LogWrite(DEBUG_3, MODULE_JFR, "New trigger init.");
-			m_pLogger->LogWrite(DEBUG_1, MODULE_JFR, LOG_FUNC_STRING, LOG_FUNC_VALUE);
-			break;
-		case RTS_RUN:
-			break;
-		case RTS_FINISH:
-			FSMTriggerFinish(pRuntime);
-			m_pLogger->LogWrite(DEBUG_3, MODULE_JFR, "New trigger finish.");
-			m_pLogger->LogWrite(DEBUG_1, MODULE_JFR, LOG_FUNC_STRING, LOG_FUNC_VALUE);
-			break;
-		case RTS_SYSERROR:
-			m_pLogger->LogWrite(DEBUG_1, MODULE_JFR, LOG_FUNC_STRING, LOG_FUNC_VALUE);
-			assert(0);
-			break;
-		case RTS_DESTROY:
-			break;
-		default:
-			m_pLogger->LogWrite(DEBUG_1, MODULE_JFR, LOG_FUNC_STRING, LOG_FUNC_VALUE);
-			assert(0);
-			break;
+		ret = pRuntime->m_pCtx->m_nRetValue;
+		pRuntime->m_pCtx->m_nStat.store(RTS_ERROR, boost::memory_order_relaxed);
+		m_pStaticSet->Release(pRuntime);
+		m_pLogger->LogWrite(ERROR, MODULE_JFR, "call static modules instance failed, return value not expected, static module name: %s, return value: %d.", name.c_str(), ret);
+		m_pLogger->LogWrite(DEBUG_1, MODULE_JFR, LOG_FUNC_STRING, LOG_FUNC_VALUE);
+		return NULL;
 	}
+	pRuntime->m_pCtx->m_nStat.store(RTS_STATIC, boost::memory_order_relaxed);
 
-	return 0;
+	return pRuntime;
 }
 
-int RuntimeManager::ModuleFSM(Runtime_t* pRuntime)
+/// 按刷新间隔重新运行静态模块，成功时发布新的参数版本，失败时继续使用旧版本
+void RuntimeManager::RefreshStaticModules(void)
 {
-	map< LineModule_t*, ModContext_t* >::iterator m_iter, m_end;
-	ModContext_t* pCtx;
-
-	assert(pRuntime);
-	m_end = pRuntime->m_mapModCtxs.end();
-	m_iter = pRuntime->m_mapModCtxs.find(pRuntime->m_pLine->m_pEnd);
-	assert(m_iter != m_end);
-	pCtx = m_iter->second;
-	switch (pCtx->m_nStat)
+	multimap< boost::system_time, size_t > mapDue;		// 下次刷新时间点 -> 静态模块编号
+
+	for (size_t i = 0; i < m_vStaticRefresh.size(); ++i)
 	{
-		case RTS_INIT:
-		case RTS_WAIT:
-		case RTS_RUN:
-		case RTS_EQUAL:
-			break;
-		case RTS_FINISH:
-			FSMEndModuleFinish(pRuntime, pCtx);
-			break;
-		case RTS_ERROR:
-			FSMEndModuleFinish(pRuntime, pCtx);
-			break;
-		case RTS_SYSERROR:
-			m_pLogger->LogWrite(DEBUG_1, MODULE_JFR, LOG_FUNC_STRING, LOG_FUNC_VALUE);
-			assert(0);
-			break;
-		case RTS_DESTROY:
-			break;
-		default:
-			m_pLogger->LogWrite(DEBUG_1, MODULE_JFR, LOG_FUNC_STRING, LOG_FUNC_VALUE);
-			assert(0);
-			break;
+		if (m_vStaticRefresh[i] > 0)
+		{
+			mapDue.insert(make_pair(boost::get_system_time() + boost::posix_time::seconds(m_vStaticRefresh[i]), i));
+		}
 	}
-
-	for (size_t i = 0; i < pRuntime->m_pLine->m_vModules.size(); ++i)
+	try
 	{
-        LineModule_t* pLineMod = pRuntime->m_pLine->m_vModules[i];
-		m_iter = pRuntime->m_mapModCtxs.find(pLineMod);
-		assert(m_iter != m_end);
-		pCtx = m_iter->second;
-        switch (pCtx->m_nStat)
-        {
-			case RTS_INIT:
-				pCtx->m_oMutex.lock();
-				pCtx->m_nStat = RTS_WAIT;
-				pCtx->m_oMutex.unlock();
-				break;
-			case RTS_WAIT:
-				FSMModuleWait(pRuntime, pLineMod, pCtx);
-				break;
-			case RTS_RUN:
-			case RTS_EQUAL:
-			case RTS_FINISH:
-			case RTS_ERROR:
-				break;
-			case RTS_SYSERROR:
+		while (!mapDue.empty())
+		{
+			boost::this_thread::sleep(mapDue.begin()->first);
+			size_t i = mapDue.begin()->second;
+			mapDue.erase(mapDue.begin());
+			StaticRuntime_t* pRuntime = RunStaticModule(m_vStaticNames[i]);
+			if (pRuntime)
+			{
+				StaticModuleArgSet::get_mutable_instance().Publish(pRuntime);
+				m_pLogger->LogWrite(DEBUG_3, MODULE_JFR, "Static module refreshed, static module name: %s, version: %lu.", \
+																m_vStaticNames[i].c_str(), (unsigned long)StaticModuleArgSet::get_mutable_instance().Current()->m_nVersion);
 				m_pLogger->LogWrite(DEBUG_1, MODULE_JFR, LOG_FUNC_STRING, LOG_FUNC_VALUE);
-				assert(0);
-				break;
-			case RTS_DESTROY:
-				break;
-			default:
+			}
+			else
+			{
+				m_pLogger->LogWrite(WARNING, MODULE_JFR, "refresh static module failed, keep the previous result, static module name: %s.", m_vStaticNames[i].c_str());
 				m_pLogger->LogWrite(DEBUG_1, MODULE_JFR, LOG_FUNC_STRING, LOG_FUNC_VALUE);
-				assert(0);
-				break;
-        }
+			}
+			mapDue.insert(make_pair(boost::get_system_time() + boost::posix_time::seconds(m_vStaticRefresh[i]), i));
+		}
 	}
-
-	return 0;
-}
-
-int RuntimeManager::FSMLineDestroy(Runtime_t* pRuntime)
-{
-	list< Runtime_t* >::iterator l_iter, l_end;
-
-	assert(pRuntime);
-	l_end = m_lRunList.end();
-	for (l_iter = m_lRunList.begin(); l_iter != l_end; ++l_iter)
+	catch (boost::thread_interrupted&)
 	{
-        if (*l_iter == pRuntime)
-		{
-            *l_iter = NULL;
-            m_pLineSet->Release(pRuntime);
-            return 0;
-		}
 	}
-
-	m_pLogger->LogWrite(DEBUG_1, MODULE_JFR, LOG_FUNC_STRING, LOG_FUNC_VALUE);
-	assert(0);
-	return -1;
 }
 
-int RuntimeManager::FSMTriggerInit(Runtime_t* pRuntime)
+/// 等待重新加载信号，信号须在创建其他线程之前屏蔽
+void RuntimeManager::WaitReload(void)
 {
-	int ret;
-	map< LineModule_t*, ModContext_t* >::iterator m_iter, m_end;
-	assert(pRuntime);
-
-	pRuntime->m_oMutex.lock();
-	pRuntime->m_nStat = RTS_WAIT;
-	pRuntime->m_pTriggerCtx->m_oMutex.lock();
-	pRuntime->m_pTriggerCtx->m_nStat = RTS_RUN;
-	pRuntime->m_pTriggerCtx->m_oMutex.unlock();
-	m_end = pRuntime->m_mapModCtxs.end();
-	for (m_iter = pRuntime->m_mapModCtxs.begin(); m_iter != m_end; ++m_iter)
+	sigset_t sigset;
+	struct timespec timeout;
+
+	sigemptyset(&sigset);
+	sigaddset(&sigset, JFR_RELOAD_SIGNAL);
+	timeout.tv_sec = JFR_RELOAD_WAIT_INTERVAL;
+	timeout.tv_nsec = 0;
+	try
 	{
-		ModContext_t* pCtx = m_iter->second;
-		pCtx->m_oMutex.lock();
-		pCtx->m_nStat = RTS_WAIT;
-		pCtx->m_oMutex.unlock();
+		while (1)
+		{
+			boost::this_thread::interruption_point();
+			if (sigtimedwait(&sigset, NULL, &timeout) != JFR_RELOAD_SIGNAL)
+			{
+				continue;
+			}
+			Reload();
+		}
 	}
-	pRuntime->m_oMutex.unlock();
-	ret = ModuleCaller::Call(pRuntime);
-	if (ret == -1)
+	catch (boost::thread_interrupted&)
 	{
-		m_pLogger->LogWrite(FATAL, MODULE_JFR, "call trigger instance failed, trigger name: %s.", pRuntime->m_pLine->m_oTrigger.m_pTrigger->m_sName.c_str());
-		m_pLogger->LogWrite(DEBUG_1, MODULE_JFR, LOG_FUNC_STRING, LOG_FUNC_VALUE);
-		assert(0);
-		return -1;
 	}
-
-	return 0;
 }
 
-int RuntimeManager::FSMTriggerFinish(Runtime_t* pRuntime)
+/// 重新加载流程配置文件，生成新的一代
+// 新一代的静态模块运行成功后，依次发布静态模块结果、切换主线运行时集合、通知各分片切换，最后移除旧一代的静态模块结果
+// 旧一代的主线实例继续在旧的一代上运行至结束，未改变的模块直接复用
+int RuntimeManager::Reload(void)
 {
-    assert(pRuntime);
-    pRuntime->m_oMutex.lock();
-    pRuntime->m_nStat = RTS_RUN;
-    m_vLineNames.push_back(pRuntime->m_pLine->m_sName);
-    pRuntime->m_oMutex.unlock();
-
-    return 0;
-}
-
-int RuntimeManager::FSMEndModuleFinish(Runtime_t* pRuntime, ModContext_t* pEndCtx)
-{
-	bool flag = false;
-	map< LineModule_t*, ModContext_t* >::iterator m_iter, m_end;
-
-	assert(pRuntime && pEndCtx);
-	m_end = pRuntime->m_mapModCtxs.end();
-	for (m_iter = pRuntime->m_mapModCtxs.begin(); m_iter != m_end; ++m_iter)
+	ConfigParser& cfg_parser = ConfigParser::get_mutable_instance();
+	ModuleManager& module_man = ModuleManager::get_mutable_instance();
+	MainlineManager& mainline_man = MainlineManager::get_mutable_instance();
+	StaticModuleArgSet& argSet = StaticModuleArgSet::get_mutable_instance();
+	FlowGenerationPtr pGeneration;
+	vector< StaticRuntime_t* > vRuntimes;
+	vector< vector< Line_t* > > vShardLines;
+
+	m_pLogger->LogWrite(INFO, MODULE_JFR, "Begin to reload flow config, file name: %s.", cfg_parser.GetFileName().c_str());
+	m_pLogger->LogWrite(DEBUG_1, MODULE_JFR, LOG_FUNC_STRING, LOG_FUNC_VALUE);
+	if (cfg_parser.Parse() || \
+		module_man.LoadAllModules(cfg_parser.GetModules(), cfg_parser.GetTriggers(), cfg_parser.GetStaticModules()))
 	{
-		ModContext_t* pCtx = m_iter->second;
-		if (pCtx == pEndCtx)
-		{
-			continue;
-		}
-		pCtx->m_oMutex.lock();
-		if (pCtx->m_nStat != RTS_RUN)
-		{
-			pCtx->m_nStat = RTS_DESTROY;
-		}
-		else
-		{
-			flag = true;
-		}
-		pCtx->m_oMutex.unlock();
+		m_pLogger->LogWrite(ERROR, MODULE_JFR, "reload flow config failed, keep running flow generation: %lu.", (unsigned long)m_pGeneration->m_nGeneration);
+		m_pLogger->LogWrite(DEBUG_1, MODULE_JFR, LOG_FUNC_STRING, LOG_FUNC_VALUE);
+		return -1;
 	}
-	if (!flag)
+	if (mainline_man.LoadStaticModules(cfg_parser.GetStaticModules()) || \
+		mainline_man.LoadMainlines(cfg_parser.GetMainlines()))
 	{
-		pRuntime->m_oMutex.lock();
-		pEndCtx->m_oMutex.lock();
-		pRuntime->m_nStat = pEndCtx->m_nStat;
-		pEndCtx->m_nStat = RTS_DESTROY;
-		pEndCtx->m_oMutex.unlock();
-		pRuntime->m_oMutex.unlock();
+		module_man.Rollback();		// 恢复上一次加载的模块，下一次重新加载时复用
+		m_pLogger->LogWrite(ERROR, MODULE_JFR, "reload flow config failed, keep running flow generation: %lu.", (unsigned long)m_pGeneration->m_nGeneration);
+		m_pLogger->LogWrite(DEBUG_1, MODULE_JFR, LOG_FUNC_STRING, LOG_FUNC_VALUE);
+		return -1;
 	}
+	pGeneration = mainline_man.TakeGeneration();
 
-	return 0;
-}
-
-int RuntimeManager::FSMModuleWait(Runtime_t* pRuntime, LineModule_t* pLineMod, ModContext_t* pCtx)
-{
-	map< LineModule_t*, int >::iterator m_iter1, m_end1;
-	map< int, vector< LineModule_t* > >::iterator m_iter2, m_end2;
-	map< LineModule_t*, ModContext_t* >::iterator m_iter3, m_end3;
-	set< Module_t* > sProcMods;
-
-    assert(pRuntime && pLineMod && pCtx);
-    m_end1 = pRuntime->m_pLine->m_mapModPtr.end();
-    m_end2 = pRuntime->m_pLine->m_mapModIds.end();
-    m_end3 = pRuntime->m_mapModCtxs.end();
-    size_t nReqRstIgnoreTimes = 0, nReqRstFinishTimes = 0, nReqRstErrorTimes = 0;
-	for (size_t i = 0; i < pLineMod->m_vRequirement.size(); ++i)
+	/// 运行新一代的静态模块，期间暂停刷新
+	StopRefresh();
+	m_pStaticSet->Reload(pGeneration->m_vStaticModules, pGeneration);
+	for (size_t i = 0; i < pGeneration->m_vStaticModules.size(); ++i)
 	{
-        Module_t* pReqMod = pLineMod->m_vRequirement[i].first;
-        if (FindProcedMod(sProcMods, pReqMod))
-		{
-			continue;
-		}
-		/// trigger 特殊处理，是trigger，根据返回值，直接设定run or error
-		if (pRuntime->m_pLine->m_oTrigger.m_pTrigger == pReqMod)
+		StaticRuntime_t* pRuntime = RunStaticModule(pGeneration->m_vStaticModules[i]->m_sName);
+		if (pRuntime == NULL)
 		{
-			pRuntime->m_pTriggerCtx->m_oMutex.lock();
-			if (pRuntime->m_pTriggerCtx->m_nStat != RTS_FINISH)
+			m_pStaticSet->Reload(m_pGeneration->m_vStaticModules, m_pGeneration);
+			for (size_t j = 0; j < vRuntimes.size(); ++j)
 			{
-				pRuntime->m_pTriggerCtx->m_oMutex.unlock();
-				continue;
+				m_pStaticSet->Release(vRuntimes[j]);
 			}
-			RetValue_t& retVal = pLineMod->m_vRequirement[i].second;
-			if (retVal.Euqal(pRuntime->m_pTriggerCtx->m_nRetValue))
-			{
-				++nReqRstFinishTimes;
-			}
-			else
-			{
-				++nReqRstErrorTimes;
-			}
-			pRuntime->m_pTriggerCtx->m_oMutex.unlock();
-			continue;
-		}
-        LineModule_t* pReqLineMod = FindLineMod(pRuntime->m_pLine->m_vModules, pReqMod);
-        assert(pReqLineMod);
-        m_iter1 = pRuntime->m_pLine->m_mapModPtr.find(pReqLineMod);
-        assert(m_iter1 != m_end1);
-        int nReqSetId = m_iter1->second;
-        m_iter2 = pRuntime->m_pLine->m_mapModIds.find(nReqSetId);
-        assert(m_iter2 != m_end2);
-        vector< LineModule_t* >& vEquLineMods = m_iter2->second;
-        size_t nEquRstIgnoreTimes = 0, nEquRstFinishTimes = 0, nEquRstErrorTimes = 0;
-        for (size_t j = 0; j < vEquLineMods.size(); ++j)
-		{
-            LineModule_t* pEquLineMod = vEquLineMods[j];
-            sProcMods.insert(pEquLineMod->m_pModule);
-            m_iter3 = pRuntime->m_mapModCtxs.find(pEquLineMod);
-            assert(m_iter3 != m_end3);
-            ModContext_t* pEquCtx = m_iter3->second;
-            pEquCtx->m_oMutex.lock();
-            switch (pEquCtx->m_nStat)
-            {
-				case RTS_INIT:
-				case RTS_WAIT:
-				case RTS_RUN:
-				case RTS_EQUAL:	// ignore
-					++nEquRstIgnoreTimes;
-					break;
-				case RTS_FINISH:
-					{
-						const RetValue_t& retVal = FindRequireRetVal(pLineMod, pEquLineMod->m_pModule);
-						if (retVal.Euqal(pEquCtx->m_nRetValue))			// finish
-						{
-							++nEquRstFinishTimes;
-						}
-						else	// error
-						{
-							++nEquRstErrorTimes;
-						}
-					}
-					break;
-				case RTS_ERROR:	// error
-					++nEquRstErrorTimes;
-					break;
-				case RTS_DESTROY:	// line quit, do not check
-					pEquCtx->m_oMutex.unlock();
-					return 0;
-					break;
-				case RTS_SYSERROR:
-					m_pLogger->LogWrite(DEBUG_1, MODULE_JFR, LOG_FUNC_STRING, LOG_FUNC_VALUE);
-					assert(0);
-					break;
-				default:
-					m_pLogger->LogWrite(DEBUG_1, MODULE_JFR, LOG_FUNC_STRING, LOG_FUNC_VALUE);
-					assert(0);
-					break;
-            }
-            pEquCtx->m_oMutex.unlock();
-		}
-		if (nEquRstFinishTimes > 0)
-		{
-			++nReqRstFinishTimes;
-		}
-		else if (nEquRstErrorTimes == vEquLineMods.size())
-		{
-			++nReqRstErrorTimes;
-		}
-		else if (nEquRstIgnoreTimes > 0)
-		{
-			++nReqRstIgnoreTimes;
+			module_man.Rollback();
+			StartRefresh();
+			m_pLogger->LogWrite(ERROR, MODULE_JFR, "reload flow config failed, run static module failed, keep running flow generation: %lu.", (unsigned long)m_pGeneration->m_nGeneration);
+			m_pLogger->LogWrite(DEBUG_1, MODULE_JFR, LOG_FUNC_STRING, LOG_FUNC_VALUE);
+			return -1;
 		}
+		vRuntimes.push_back(pRuntime);
+	}
+	for (size_t i = 0; i < vRuntimes.size(); ++i)
+	{
+		argSet.Publish(vRuntimes[i]);
 	}
 
-	pCtx->m_oMutex.lock();
-	if (nReqRstIgnoreTimes > 0)
+	/// 主线按编号取模划分到各分片，分片数不变
+	vShardLines.resize(m_vShards.size());
+	for (size_t i = 0; i < pGeneration->m_vLines.size(); ++i)
 	{
-		pCtx->m_nStat = RTS_WAIT;
+		pGeneration->m_vLines[i]->m_nShard = i % m_vShards.size();
+		vShardLines[i % m_vShards.size()].push_back(pGeneration->m_vLines[i]);
 	}
-	else if (nReqRstErrorTimes > 0)
+	for (size_t i = 0; i < m_vShards.size(); ++i)
 	{
-		pCtx->m_nStat = RTS_ERROR;
+		m_vShards[i]->Reload(vShardLines[i], pGeneration->m_nGeneration);
 	}
-	else
+	m_pLineSet->Reload(pGeneration->m_vLines, pGeneration);
+	PrewarmLines(pGeneration);
+	for (size_t i = 0; i < m_vShards.size(); ++i)
 	{
-		pCtx->m_nStat = RTS_RUN;
-		if (ModuleCaller::Call(pRuntime, pLineMod))
-		{
-			m_pLogger->LogWrite(FATAL, MODULE_JFR, "call module instance failed, module name: %s.", pLineMod->m_pModule->m_sName.c_str());
-			m_pLogger->LogWrite(DEBUG_1, MODULE_JFR, LOG_FUNC_STRING, LOG_FUNC_VALUE);
-		}
+		EventQueue::get_mutable_instance().Post(i, NULL, NULL, RTE_RELOAD);
 	}
-	pCtx->m_oMutex.unlock();
+	/// 之后取得的主线运行时均属于新的一代，旧一代的静态模块结果只由已运行的实例持有
+	argSet.Retain(pGeneration->m_vStaticModules);
+	m_pGeneration = pGeneration;
+	SetStaticModules();
+	StartRefresh();
+	module_man.Commit();		// 旧一代主线引用的模块在其结束后释放
+	m_pLogger->LogWrite(INFO, MODULE_JFR, "End to reload flow config, flow generation: %lu, lines: %lu, static modules: %lu.", (unsigned long)pGeneration->m_nGeneration, \
+											(unsigned long)pGeneration->m_vLines.size(), (unsigned long)pGeneration->m_vStaticModules.size());
+	m_pLogger->LogWrite(DEBUG_1, MODULE_JFR, LOG_FUNC_STRING, LOG_FUNC_VALUE);
 
-    return 0;
+	return 0;
 }
 
-LineModule_t* RuntimeManager::FindLineMod(const vector< LineModule_t* >& vLineMods, const Module_t* pMod)
+/// 为配置了prewarm的主线预先创建运行时，须在静态模块结果发布之后调用，运行时初始化时固定静态模块参数
+// 预热失败不影响运行，运行时在首次取得时创建
+void RuntimeManager::PrewarmLines(const FlowGenerationPtr& pGeneration)
 {
-	assert(pMod);
-    for (size_t i = 0; i < vLineMods.size(); ++i)
+	for (size_t i = 0; i < pGeneration->m_vLines.size(); ++i)
 	{
-		if (vLineMods[i]->m_pModule == pMod)
+		Line_t* pLine = pGeneration->m_vLines[i];
+		if (pLine->m_nPrewarm == 0)
+		{
+			continue;
+		}
+		if (m_pLineSet->Prewarm(pLine->m_sName, pLine->m_nPrewarm))
 		{
-			return vLineMods[i];
+			m_pLogger->LogWrite(WARNING, MODULE_JFR, "prewarm line runtimes failed, line name: %s, prewarm: %u.", pLine->m_sName.c_str(), pLine->m_nPrewarm);
+			m_pLogger->LogWrite(DEBUG_1, MODULE_JFR, LOG_FUNC_STRING, LOG_FUNC_VALUE);
+			continue;
 		}
+		m_pLogger->LogWrite(DEBUG_3, MODULE_JFR, "prewarm line runtimes, line name: %s, prewarm: %u.", pLine->m_sName.c_str(), pLine->m_nPrewarm);
+		m_pLogger->LogWrite(DEBUG_1, MODULE_JFR, LOG_FUNC_STRING, LOG_FUNC_VALUE);
 	}
-
-	return NULL;
 }
 
-const RetValue_t& RuntimeManager::FindRequireRetVal(const LineModule_t* pLineMod, const Module_t* pMod)
+int RuntimeManager::RunLines(void)
 {
-	assert(pLineMod && pMod);
-	for (size_t i = 0; i < pLineMod->m_vRequirement.size(); ++i)
+	boost::thread_group threads;
+
+	Watchdog::get_mutable_instance().Start();
+	ProcessReactor::get_mutable_instance().Start();		// 启动失败时进程模块同步等待子进程
+	if (m_vShards.size() == 1)
 	{
-        if (pLineMod->m_vRequirement[i].first == pMod)
-		{
-			return pLineMod->m_vRequirement[i].second;
-		}
+		return m_vShards[0]->Run();
 	}
-	assert(0);
-}
 
-bool RuntimeManager::FindProcedMod(const set< Module_t* >& sProcedMods, const Module_t* pMod)
-{
-	assert(pMod);
-	if (sProcedMods.find((Module_t*)pMod) == sProcedMods.end())
+	m_pLogger->LogWrite(DEBUG_3, MODULE_JFR, "Begin to run shards, shard count: %d.", m_vShards.size());
+	m_pLogger->LogWrite(DEBUG_1, MODULE_JFR, LOG_FUNC_STRING, LOG_FUNC_VALUE);
+	for (size_t i = 0; i < m_vShards.size(); ++i)
 	{
-        return false;
+		threads.create_thread(boost::bind(&RuntimeShard::Run, m_vShards[i]));
 	}
+	threads.join_all();
+	m_pLogger->LogWrite(DEBUG_3, MODULE_JFR, "End to run shards.");
+	m_pLogger->LogWrite(DEBUG_1, MODULE_JFR, LOG_FUNC_STRING, LOG_FUNC_VALUE);
 
-	return true;
+	return 0;
 }
 
-
 CLOSE_NAMESPACE_JFR
@@ -7,112 +7,126 @@ Runtime_st::Runtime_st(void)
 {
 	m_nStat = RTS_INVALID;
 	m_pLine = NULL;
+	m_nGeneration = 0;
+	m_pArgValues = NULL;
 	m_pTriggerCtx = NULL;
+	m_pCtxs = NULL;
 	m_bInit = false;
 }
 
 Runtime_st::~Runtime_st(void)
 {
-	map< ModArg_t*, ArgValue_t* >::iterator iter1, end1;
-	map< LineModule_t*, ModContext_t* >::iterator iter2, end2;
+	delete[] m_pArgValues;
+	delete[] m_pCtxs;
+}
 
-	StaticModuleArgSet& argSet = StaticModuleArgSet::get_mutable_instance();
-    end1 = m_mapArgs.end();
-    for (iter1 = m_mapArgs.begin(); iter1 != end1; ++iter1)
+void Runtime_st::Recycling(void)
+{
+    m_nStat = RTS_INIT;
+    for (size_t i = 0; i < m_pLine->m_vArgs.size(); ++i)		// 静态模块参数的值属于静态模块参数版本
 	{
-		if (argSet.GetElement(iter1->first))
+		if (m_pLine->m_vArgs[i]->m_nType != AT_STRING)
 		{
-			continue;
+			m_pArgValues[i].Recycle();		// v2接口模块出参的缓冲区保留到下次运行
 		}
-		delete iter1->second;
 	}
-	end2 = m_mapModCtxs.end();
-	for (iter2 = m_mapModCtxs.begin(); iter2 != end2; ++iter2)
+	m_oArena.Reset();
+	/// 归还时已没有运行中的模块，上下文只由回收线程访问
+	for (size_t i = 0; i <= m_pLine->m_vModules.size(); ++i)
 	{
-		delete iter2->second;
+		ModContext_t* pCtx = &m_pCtxs[i];
+		pCtx->m_nStat.store(RTS_INIT, boost::memory_order_relaxed);
+		pCtx->m_nRetValue = 0;
+		pCtx->m_bStreamed = false;
+		pCtx->m_oEnv.m_nCanceled.store(0, boost::memory_order_relaxed);
 	}
-	delete m_pTriggerCtx;
+	m_pStaticArgs.reset();		// 释放对静态模块参数版本的引用，下次运行时重新固定
+	ResetGraph();
 }
 
-void Runtime_st::Recycling(void)
+/// 实例开始运行前固定使用当前的静态模块参数版本，参数表中的静态模块参数指向该版本的参数值
+void Runtime_st::PinStaticArgs(void)
 {
-	map< ModArg_t*, ArgValue_t* >::iterator iter1, end1;
-	map< LineModule_t*, ModContext_t* >::iterator iter2, end2;
+	map< ModArg_t*, ArgValue_t* >::const_iterator iter;
+	StaticArgVersionPtr pCurrent;
+	size_t nArgs;
 
-	boost::lock_guard< boost::mutex > guard(m_oMutex);
-	StaticModuleArgSet& argSet = StaticModuleArgSet::get_mutable_instance();
-    m_nStat = RTS_INIT;
-    end1 = m_mapArgs.end();
-    for (iter1 = m_mapArgs.begin(); iter1 != end1; ++iter1)
+	pCurrent = StaticModuleArgSet::get_mutable_instance().Current();
+	if (pCurrent == m_pStaticArgs)
 	{
-		ArgValue_t* pArgValue = iter1->second;
-		ModArg_t* pModArg = iter1->first;
-		if (argSet.GetElement(pModArg))
-		{
-			continue;
-		}
-		if (pModArg->m_nType != AT_STRING)
-		{
-			pArgValue->m_oMutex.lock();
-			pArgValue->Free();
-			pArgValue->m_oMutex.unlock();
-		}
+		return;
 	}
-	end2 = m_mapModCtxs.end();
-	for (iter2 = m_mapModCtxs.begin(); iter2 != end2; ++iter2)
+	nArgs = m_pLine->m_vArgs.size();
+	for (size_t i = 0; i < m_pLine->m_vStaticArgs.size(); ++i)
 	{
-		ModContext_t* pCtx = iter2->second;
-		pCtx->m_oMutex.lock();
-		pCtx->m_nStat = RTS_INIT;
-		pCtx->m_nRetValue = 0;
-		pCtx->m_oMutex.unlock();
+		iter = pCurrent->m_mapArgs.find(m_pLine->m_vStaticArgs[i]);
+		assert(iter != pCurrent->m_mapArgs.end());
+		m_vArgs[nArgs + i] = iter->second;
 	}
-	m_pTriggerCtx->m_oMutex.lock();
-	m_pTriggerCtx->m_nStat = RTS_INIT;
-	m_pTriggerCtx->m_nRetValue = 0;
-	m_pTriggerCtx->m_oMutex.unlock();
+	m_pStaticArgs = pCurrent;
 }
 
+/// 依赖计数复位为主线编译结果
+void Runtime_st::ResetGraph(void)
+{
+	m_vRemaining.resize(m_pLine->m_vModules.size());
+	m_vFailed.assign(m_pLine->m_vModules.size(), 0);
+	m_vPropagated.assign(m_pLine->m_vModules.size(), false);
+	m_vSlotFails.assign(m_pLine->m_vSlotSizes.size(), 0);
+	m_vHeld.assign(m_pLine->m_vModules.size(), false);
+	m_vGroupLaunched.assign(m_pLine->m_vEquGroups.size(), 0);
+	m_vGroupAllowed.assign(m_pLine->m_vEquGroups.size(), 1);
+	m_vGroupDone.assign(m_pLine->m_vEquGroups.size(), false);
+	for (size_t i = 0; i < m_pLine->m_vModules.size(); ++i)
+	{
+		m_vRemaining[i] = m_pLine->m_vModules[i]->m_nSlotNum;
+	}
+}
+
+/// 参数值、运行上下文按主线编译时的下标连续分配
 int Runtime_st::Init(Line_t* line)
 {
+	size_t nArgs, nMods;
+
 	assert(line);
-	boost::lock_guard< boost::mutex > guard(m_oMutex);
-	StaticModuleArgSet& argSet = StaticModuleArgSet::get_mutable_instance();
 	m_nStat = RTS_INIT;
 	m_pLine = line;
-	for (size_t i = 0; i < m_pLine->m_vArgs.size(); ++i)
+	nArgs = m_pLine->m_vArgs.size();
+	nMods = m_pLine->m_vModules.size();
+	m_pArgValues = new ArgValue_t[nArgs];
+	m_vArgs.assign(nArgs + m_pLine->m_vStaticArgs.size(), NULL);
+	for (size_t i = 0; i < nArgs; ++i)
 	{
 		ModArg_t* pModArg = m_pLine->m_vArgs[i];
 		assert(pModArg);
-		ArgValue_t* pArgValue = argSet.GetElement(pModArg);
-		if (!pArgValue)
+		ArgValue_t* pArgValue = &m_pArgValues[i];
+		pArgValue->m_pModArg = pModArg;
+		if (pModArg->m_nType == AT_STRING)		// 字符串参数分配在基准点之前，回收时保留
 		{
-			pArgValue = new ArgValue_t;		// do not lock
-			pArgValue->m_pModArg = pModArg;
-			if (pModArg->m_nType == AT_STRING)
-			{
-				pArgValue->m_pValue = malloc(pModArg->m_sName.length() + 1);
-				memset(pArgValue->m_pValue, 0, pModArg->m_sName.length() + 1);
-				strncpy((char*)pArgValue->m_pValue, pModArg->m_sName.c_str(), pModArg->m_sName.length());
-				pArgValue->m_pFreeFunc = free;
-			}
+			pArgValue->m_pValue = m_oArena.Strdup(pModArg->m_sName.c_str(), pModArg->m_sName.length());
+			pArgValue->m_nLength = pModArg->m_sName.length();
+			pArgValue->m_nType = AVT_STRING;
 		}
-		m_mapArgs.insert(make_pair(pModArg, pArgValue));
+		m_vArgs[i] = pArgValue;
 	}
-	for (size_t i = 0; i < m_pLine->m_vModules.size(); ++i)
+	m_pCtxs = new ModContext_t[nMods + 1];
+	m_vModCtxs.resize(nMods);
+	for (size_t i = 0; i < nMods; ++i)
 	{
 		LineModule_t* pLineMod = m_pLine->m_vModules[i];
 		assert(pLineMod);
-		ModContext_t* pCtx = new ModContext_t;
-		pCtx->m_nStat = RTS_INIT;		// do not lock
-		pCtx->m_nRetValue = 0;
-		m_mapModCtxs.insert(make_pair(pLineMod, pCtx));
+		ModContext_t* pCtx = &m_pCtxs[i];
+		pCtx->m_pRuntime = this;
+		pCtx->m_pLineMod = pLineMod;
+		pCtx->SetArena(&m_oArena);
+		m_vModCtxs[i] = pCtx;
 	}
-	m_pTriggerCtx = new ModContext_t;
-	m_pTriggerCtx->m_oMutex.lock();
-	m_pTriggerCtx->m_nStat = RTS_INIT;
-	m_pTriggerCtx->m_nRetValue = 0;
-	m_pTriggerCtx->m_oMutex.unlock();
+	m_pTriggerCtx = &m_pCtxs[nMods];
+	m_pTriggerCtx->m_pRuntime = this;
+	m_pTriggerCtx->SetArena(&m_oArena);
+	m_oArena.Mark();
+	ResetGraph();
+	PinStaticArgs();
 	m_bInit = true;
 
 	return 0;
@@ -123,74 +137,63 @@ int Runtime_st::Init(Line_t* line)
 StaticRuntime_st::StaticRuntime_st(void)
 {
 	m_pStaticModule = NULL;
+	m_nGeneration = 0;
 	m_pCtx = NULL;
+	m_pArgValues = NULL;
 	m_bInit = false;
 }
 
 StaticRuntime_st::~StaticRuntime_st(void)
 {
-	map< ModArg_t*, ArgValue_t* >::iterator iter, end;
-
 	delete m_pCtx;
-	end = m_mapArgs.end();
-	for (iter = m_mapArgs.begin(); iter != end; ++iter)
-	{
-		delete iter->second;
-	}
+	delete[] m_pArgValues;
 }
 
 void StaticRuntime_st::Recycling(void)
 {
-	map< ModArg_t*, ArgValue_t* >::iterator iter, end;
-	boost::lock_guard< boost::mutex > guard(m_oMutex);
 	if (!m_bInit)
 	{
 		return;
 	}
-	m_pCtx->m_oMutex.lock();
-	m_pCtx->m_nStat = RTS_INIT;
+	m_pCtx->m_nStat.store(RTS_INIT, boost::memory_order_relaxed);
 	m_pCtx->m_nRetValue = 0;
-	m_pCtx->m_oMutex.unlock();
-	end = m_mapArgs.end();
-	for (iter = m_mapArgs.begin(); iter != end; ++iter)
+	m_pCtx->m_oEnv.m_nCanceled.store(0, boost::memory_order_relaxed);
+	for (size_t i = 0; i < m_pStaticModule->m_vArgs.size(); ++i)
 	{
-		ArgValue_t* pArgValue = iter->second;
-		ModArg_t* pModArg = iter->first;
-		if (pModArg->m_nType != AT_STRING)
+		if (m_pStaticModule->m_vArgs[i]->m_nType != AT_STRING)
 		{
-			pArgValue->m_oMutex.lock();
-			pArgValue->Free();
-			pArgValue->m_oMutex.unlock();
+			m_pArgValues[i].Free();
 		}
 	}
+	m_oArena.Reset();
 }
 
 int StaticRuntime_st::Init(LineStaticModule_t* module)
 {
+	size_t nArgs;
+
 	assert(module);
 	m_pStaticModule = module;
 	m_pCtx = new ModContext_t;
-	m_pCtx->m_oMutex.lock();
-	m_pCtx->m_nStat = RTS_INIT;
-	m_pCtx->m_nRetValue = 0;
-	m_pCtx->m_oMutex.unlock();
-	for (size_t i = 0; i < m_pStaticModule->m_vArgs.size(); ++i)
+	m_pCtx->SetArena(&m_oArena);
+	nArgs = m_pStaticModule->m_vArgs.size();
+	m_pArgValues = new ArgValue_t[nArgs];
+	m_vArgs.assign(nArgs, NULL);
+	for (size_t i = 0; i < nArgs; ++i)
 	{
 		ModArg_t* pModArg = m_pStaticModule->m_vArgs[i];
 		assert(pModArg);
-		ArgValue_t* pArgValue = new ArgValue_t;		// do not lock
+		ArgValue_t* pArgValue = &m_pArgValues[i];
 		pArgValue->m_pModArg = pModArg;
-		if (pModArg->m_nType == AT_STRING)
+		if (pModArg->m_nType == AT_STRING)		// 字符串参数分配在基准点之前，回收时保留
 		{
-			pArgValue->m_pValue = malloc(pModArg->m_sName.length() + 1);
-			memset(pArgValue->m_pValue, 0, pModArg->m_sName.length() + 1);
-			strncpy((char*)pArgValue->m_pValue, pModArg->m_sName.c_str(), pModArg->m_sName.length());
-			pArgValue->m_pFreeFunc = free;
+			pArgValue->m_pValue = m_oArena.Strdup(pModArg->m_sName.c_str(), pModArg->m_sName.length());
+			pArgValue->m_nLength = pModArg->m_sName.length();
+			pArgValue->m_nType = AVT_STRING;
 		}
-		m_mapArgs.insert(make_pair(pModArg, pArgValue));
-		StaticModuleArgSet& argSet = StaticModuleArgSet::get_mutable_instance();
-		argSet.InsertElement(pModArg, pArgValue);
+		m_vArgs[i] = pArgValue;
 	}
+	m_oArena.Mark();
 	m_bInit = true;
 
 	return 0;
@@ -206,26 +209,62 @@ StaticModuleArgSet::~StaticModuleArgSet(void)
 {
 }
 
-int StaticModuleArgSet::InsertElement(ModArg_t* pModArg, ArgValue_t* pArgVal)
+/// 以静态模块的运行结果生成新版本并替换当前版本，pRuntime由参数版本持有，不再使用时归还
+int StaticModuleArgSet::Publish(StaticRuntime_t* pRuntime)
 {
-	assert(pModArg && pArgVal);
-	m_mapArgs.insert(make_pair(pModArg, pArgVal));
+	StaticArgVersion_t* pVersion;
+
+	assert(pRuntime);
+	boost::lock_guard< boost::mutex > guard(m_oMutex);
+	pVersion = m_pCurrent ? new StaticArgVersion_t(*m_pCurrent) : new StaticArgVersion_t;
+	pVersion->m_nVersion = m_pCurrent ? m_pCurrent->m_nVersion + 1 : 1;
+	pVersion->m_mapRuntimes[pRuntime->m_pStaticModule] = boost::shared_ptr< StaticRuntime_t >(pRuntime, StaticRuntimeRelease_t());
+	for (size_t i = 0; i < pRuntime->m_vArgs.size(); ++i)
+	{
+		pVersion->m_mapArgs[pRuntime->m_vArgs[i]->m_pModArg] = pRuntime->m_vArgs[i];
+	}
+	boost::atomic_store(&m_pCurrent, StaticArgVersionPtr(pVersion));
 
 	return 0;
 }
 
-ArgValue_t* StaticModuleArgSet::GetElement(ModArg_t* pModArg)
+/// 生成只包含vStaticModules运行结果的新版本并替换当前版本
+int StaticModuleArgSet::Retain(const vector< LineStaticModule_t* >& vStaticModules)
 {
-	map< ModArg_t*, ArgValue_t* >::iterator iter;
+	map< LineStaticModule_t*, boost::shared_ptr< StaticRuntime_t > >::const_iterator r_iter;
+	StaticArgVersion_t* pVersion;
 
-	assert(pModArg);
-	iter = m_mapArgs.find(pModArg);
-	if (iter == m_mapArgs.end())
+	boost::lock_guard< boost::mutex > guard(m_oMutex);
+	pVersion = new StaticArgVersion_t;
+	pVersion->m_nVersion = m_pCurrent ? m_pCurrent->m_nVersion + 1 : 1;
+	for (size_t i = 0; m_pCurrent && i < vStaticModules.size(); ++i)
 	{
-		return NULL;
+		r_iter = m_pCurrent->m_mapRuntimes.find(vStaticModules[i]);
+		if (r_iter == m_pCurrent->m_mapRuntimes.end())
+		{
+			continue;
+		}
+		pVersion->m_mapRuntimes.insert(*r_iter);
+		const vector< ArgValue_t* >& vArgs = r_iter->second->m_vArgs;
+		for (size_t j = 0; j < vArgs.size(); ++j)
+		{
+			pVersion->m_mapArgs[vArgs[j]->m_pModArg] = vArgs[j];
+		}
 	}
+	boost::atomic_store(&m_pCurrent, StaticArgVersionPtr(pVersion));
 
-	return iter->second;
+	return 0;
+}
+
+StaticArgVersionPtr StaticModuleArgSet::Current(void) const
+{
+	return boost::atomic_load(&m_pCurrent);
+}
+
+void StaticModuleArgSet::Clear(void)
+{
+	boost::lock_guard< boost::mutex > guard(m_oMutex);
+	boost::atomic_store(&m_pCurrent, StaticArgVersionPtr());
 }
 
 
@@ -0,0 +1,966 @@
+#include "RuntimeShard.h"
+
+OPEN_NAMESPACE_JFR
+
+RuntimeShard::RuntimeShard(void)
+{
+	m_nId = 0;
+	m_pLineSet = NULL;
+	m_pEventQueue = NULL;
+	m_pWatchdog = NULL;
+	m_pLogger = NULL;
+	m_nRunListMaxSize = 0;
+	m_nReadyListMaxSize = 0;
+	m_bPaused = false;
+	m_nGeneration = 0;
+	m_nReloadGeneration = 0;
+}
+
+RuntimeShard::~RuntimeShard(void)
+{
+	Clear();
+}
+
+/// vLines为划分到本分片的主线，max为运行队列长度，ready为就绪队列上限，nGeneration为主线所属的流程配置代编号
+int RuntimeShard::Init(size_t id, size_t max, size_t ready, const vector< Line_t* >& vLines, size_t nGeneration)
+{
+	Clear();
+	m_nId = id;
+	m_nRunListMaxSize = max;
+	m_nReadyListMaxSize = ready;
+	m_pLineSet = &RuntimeSet< Runtime_t, Line_t >::get_mutable_instance();
+	m_pEventQueue = &EventQueue::get_mutable_instance();
+	m_pWatchdog = &Watchdog::get_mutable_instance();
+	m_pLogger = &jfr::LoggerSingleton::get_mutable_instance();
+	m_oAdmitQueue.Reset();
+	m_oReadyQueue.Reset();
+	m_mapFlows.clear();
+	m_nGeneration = nGeneration;
+	AddLines(vLines);
+
+	return 0;
+}
+
+/// 每个待触发的实例在触发队列中占一个位置，触发器结束后放回，同一主线最多同时运行m_nMaxInflight个实例
+// 两个队列的流编号一致；已有同名主线的流时沿用并更新优先级和权重，旧一代实例的就绪任务与新一代排在同一个流中
+void RuntimeShard::AddLines(const vector< Line_t* >& vLines)
+{
+	map< string, size_t >::iterator m_iter;
+
+	for (size_t i = 0; i < vLines.size(); ++i)
+	{
+		m_iter = m_mapFlows.find(vLines[i]->m_sName);
+		if (m_iter != m_mapFlows.end())
+		{
+			vLines[i]->m_nFlow = m_iter->second;
+			m_oAdmitQueue.SetFlow(m_iter->second, vLines[i]->m_nPriority, vLines[i]->m_nWeight);
+			m_oReadyQueue.SetFlow(m_iter->second, vLines[i]->m_nPriority, vLines[i]->m_nWeight);
+		}
+		else
+		{
+			vLines[i]->m_nFlow = m_oAdmitQueue.AddFlow(vLines[i]->m_nPriority, vLines[i]->m_nWeight);
+			m_oReadyQueue.AddFlow(vLines[i]->m_nPriority, vLines[i]->m_nWeight);
+			m_mapFlows.insert(make_pair(vLines[i]->m_sName, vLines[i]->m_nFlow));
+		}
+		for (unsigned int j = 0; j < vLines[i]->m_nMaxInflight; ++j)
+		{
+			m_oAdmitQueue.Push(vLines[i]->m_nFlow, vLines[i]);
+		}
+	}
+}
+
+/// 由重新加载配置的线程调用，调用者切换主线运行时集合后投递RTE_RELOAD事件，分片线程处理事件时切换
+// 分片在事件之前取得新一代的运行时，说明主线运行时集合已切换，立即切换
+int RuntimeShard::Reload(const vector< Line_t* >& vLines, size_t nGeneration)
+{
+	m_oReloadMutex.lock();
+	m_vReloadLines = vLines;
+	m_nReloadGeneration = nGeneration;
+	m_oReloadMutex.unlock();
+
+	return 0;
+}
+
+/// 切换到新一代主线，返回1表示已切换
+// 旧一代的待触发实例作废；没有正在运行的实例时重建公平队列，否则保留旧的流，供旧一代实例的就绪任务使用，
+// 同名主线沿用原来的流，流的个数不随重新加载的次数增长
+int RuntimeShard::ApplyReload(void)
+{
+	vector< Line_t* > vLines;
+	size_t nGeneration;
+
+	m_oReloadMutex.lock();
+	nGeneration = m_nReloadGeneration;
+	vLines.swap(m_vReloadLines);
+	m_nReloadGeneration = 0;
+	m_oReloadMutex.unlock();
+	if (nGeneration == 0)
+	{
+		return 0;
+	}
+	m_oAdmitQueue.Clear();
+	if (m_sRunList.empty() && m_oReadyQueue.Empty())
+	{
+		m_oAdmitQueue.Reset();
+		m_oReadyQueue.Reset();
+		m_mapFlows.clear();
+	}
+	m_nGeneration = nGeneration;
+	AddLines(vLines);
+	m_pLogger->LogWrite(DEBUG_3, MODULE_JFR, "Switch to flow generation: %lu, shard: %d, lines: %d, running lines: %d.", (unsigned long)nGeneration, m_nId, vLines.size(), m_sRunList.size());
+	m_pLogger->LogWrite(DEBUG_1, MODULE_JFR, LOG_FUNC_STRING, LOG_FUNC_VALUE);
+
+	return 1;
+}
+
+void RuntimeShard::Clear(void)
+{
+	set< Runtime_t* >::iterator s_iter, s_end;
+
+	s_end = m_sRunList.end();
+	for (s_iter = m_sRunList.begin(); s_iter != s_end; ++s_iter)
+	{
+        m_pLineSet->Release(*s_iter);
+	}
+	m_sRunList.clear();
+	s_end = m_sDrainList.end();
+	for (s_iter = m_sDrainList.begin(); s_iter != s_end; ++s_iter)
+	{
+        m_pLineSet->Release(*s_iter);
+	}
+	m_sDrainList.clear();
+	m_oReadyQueue.Clear();
+	m_mapHedgeTimers.clear();
+	m_bPaused = false;
+}
+
+int RuntimeShard::Run(void)
+{
+	list< RuntimeEvent_t > lEvents;
+	list< RuntimeEvent_t >::iterator e_iter, e_end;
+	boost::system_time sweep;
+
+	if (!m_sRunList.empty())
+	{
+		Clear();
+	}
+
+	m_pLogger->LogWrite(DEBUG_3, MODULE_JFR, "Begin to run lines, shard: %d.", m_nId);
+	m_pLogger->LogWrite(DEBUG_1, MODULE_JFR, LOG_FUNC_STRING, LOG_FUNC_VALUE);
+	sweep = boost::get_system_time();
+	while (1)
+	{
+		/// 就绪队列达到上限时暂停触发，避免触发器继续产生无法提交的任务
+		if (m_oReadyQueue.Size() < m_nReadyListMaxSize)
+		{
+			if (m_bPaused)
+			{
+				m_bPaused = false;
+				m_pLogger->LogWrite(DEBUG_3, MODULE_JFR, "Resume triggers, shard: %d, ready jobs: %d.", m_nId, m_oReadyQueue.Size());
+				m_pLogger->LogWrite(DEBUG_1, MODULE_JFR, LOG_FUNC_STRING, LOG_FUNC_VALUE);
+			}
+			AdmitLines();
+		}
+		else if (!m_bPaused)
+		{
+			m_bPaused = true;
+			m_pLogger->LogWrite(DEBUG_3, MODULE_JFR, "Pause triggers, shard: %d, ready jobs: %d.", m_nId, m_oReadyQueue.Size());
+			m_pLogger->LogWrite(DEBUG_1, MODULE_JFR, LOG_FUNC_STRING, LOG_FUNC_VALUE);
+		}
+
+		FireHedgeTimers();
+		lEvents.clear();
+		if (m_pEventQueue->Wait(m_nId, lEvents, WaitTimeout()) == 0)
+		{
+			DrainReadyList();
+			if (boost::get_system_time() - sweep < boost::posix_time::milliseconds(JFR_RUNTIME_SWEEP_INTERVAL))
+			{
+				continue;
+			}
+			/// 超时无事件，全量检查一次正在运行的主线
+			vector< Runtime_t* > vRuntimes(m_sRunList.begin(), m_sRunList.end());
+			for (size_t i = 0; i < vRuntimes.size(); ++i)
+			{
+				SweepRuntime(vRuntimes[i]);
+			}
+			vRuntimes.assign(m_sDrainList.begin(), m_sDrainList.end());
+			for (size_t i = 0; i < vRuntimes.size(); ++i)
+			{
+				ReapRuntime(vRuntimes[i]);
+			}
+			sweep = boost::get_system_time();
+			continue;
+		}
+
+		/// 只推进产生事件的主线
+		e_end = lEvents.end();
+		for (e_iter = lEvents.begin(); e_iter != e_end; ++e_iter)
+		{
+			if (e_iter->m_nType == RTE_SLOT_FREE)
+			{
+				continue;
+			}
+			if (e_iter->m_nType == RTE_RELOAD)
+			{
+				ApplyReload();
+				continue;
+			}
+			if (m_sRunList.find(e_iter->m_pRuntime) == m_sRunList.end())	// 主线已销毁
+			{
+				if (m_sDrainList.find(e_iter->m_pRuntime) != m_sDrainList.end())
+				{
+					ReapRuntime(e_iter->m_pRuntime);
+				}
+				continue;
+			}
+			DriveRuntime(e_iter->m_pRuntime, e_iter->m_pCtx);
+		}
+		/// 模块结束后线程池有空位，提交就绪任务
+		DrainReadyList();
+	}
+	m_pLogger->LogWrite(DEBUG_3, MODULE_JFR, "End to run lines, shard: %d.", m_nId);
+	m_pLogger->LogWrite(DEBUG_1, MODULE_JFR, LOG_FUNC_STRING, LOG_FUNC_VALUE);
+
+	return 0;
+}
+
+/// 等待事件的超时时间(毫秒)，不超过最近的hedge定时器
+unsigned int RuntimeShard::WaitTimeout(void)
+{
+	unsigned int timeout;
+	long long left;
+
+	timeout = m_oReadyQueue.Empty() ? JFR_RUNTIME_SWEEP_INTERVAL : JFR_RUNTIME_READY_RETRY_INTERVAL;
+	if (!m_mapHedgeTimers.empty())
+	{
+		left = (m_mapHedgeTimers.begin()->first - boost::get_system_time()).total_milliseconds() + 1;
+		if (left < 1)
+		{
+			left = 1;
+		}
+		if (left < timeout)
+		{
+			timeout = (unsigned int)left;
+		}
+	}
+
+	return timeout;
+}
+
+/// 处理到期的hedge定时器，等效组仍未有结果时允许多运行一个模块，返回处理的定时器个数
+int RuntimeShard::FireHedgeTimers(void)
+{
+	int count = 0;
+	boost::system_time now;
+
+	now = boost::get_system_time();
+	while (!m_mapHedgeTimers.empty() && m_mapHedgeTimers.begin()->first <= now)
+	{
+		HedgeTimer_t timer = m_mapHedgeTimers.begin()->second;
+		m_mapHedgeTimers.erase(m_mapHedgeTimers.begin());
+		Runtime_t* pRuntime = timer.m_pRuntime;
+		if (pRuntime->m_vGroupDone[timer.m_nGroup] || pRuntime->m_vGroupLaunched[timer.m_nGroup] != timer.m_nStamp)
+		{
+			continue;
+		}
+		if (pRuntime->m_vGroupAllowed[timer.m_nGroup] <= timer.m_nStamp)
+		{
+			pRuntime->m_vGroupAllowed[timer.m_nGroup] = timer.m_nStamp + 1;
+		}
+		FSMGroupLaunch(pRuntime, timer.m_nGroup);
+		++count;
+	}
+
+	return count;
+}
+
+/// 按优先级、权重为等待触发的主线创建运行时，返回新加入运行的主线个数
+int RuntimeShard::AdmitLines(void)
+{
+	int count = 0;
+	Line_t** ppLine;
+
+	while (m_sRunList.size() < m_nRunListMaxSize && (ppLine = m_oAdmitQueue.Front()) != NULL)
+	{
+		Runtime_t* pRuntime = m_pLineSet->Obtain((*ppLine)->m_sName);
+		if (pRuntime == NULL || pRuntime->m_nGeneration != m_nGeneration)		// 配置已重新加载，先切换到新一代主线
+		{
+			if (pRuntime)
+			{
+				m_pLineSet->Release(pRuntime);
+			}
+			if (ApplyReload() == 0)
+			{
+				m_pLogger->LogWrite(ERROR, MODULE_JFR, "create line instance failed, line name: %s.", (*ppLine)->m_sName.c_str());
+				m_pLogger->LogWrite(DEBUG_1, MODULE_JFR, LOG_FUNC_STRING, LOG_FUNC_VALUE);
+				m_oAdmitQueue.Pop();
+			}
+			continue;
+		}
+		m_oAdmitQueue.Pop();
+		m_sRunList.insert(pRuntime);
+		DriveRuntime(pRuntime, NULL);
+		++count;
+	}
+
+	return count;
+}
+
+/// 推进主线状态机，直至本主线没有可推进的状态；pCtx为产生事件的模块上下文，可以为NULL
+// 返回1表示主线已销毁
+int RuntimeShard::DriveRuntime(Runtime_t* pRuntime, ModContext_t* pCtx)
+{
+	assert(pRuntime);
+	if (MainlineFSM(pRuntime, pCtx) > 0)
+	{
+		while (MainlineFSM(pRuntime, NULL) > 0)
+		{
+		}
+	}
+
+	return m_sRunList.find(pRuntime) == m_sRunList.end() ? 1 : 0;
+}
+
+/// 全量检查主线各模块，处理可能遗漏的事件
+int RuntimeShard::SweepRuntime(Runtime_t* pRuntime)
+{
+	assert(pRuntime);
+	if (DriveRuntime(pRuntime, NULL))
+	{
+		return 0;
+	}
+	for (size_t i = 0; i < pRuntime->m_vModCtxs.size(); ++i)
+	{
+		if (DriveRuntime(pRuntime, pRuntime->m_vModCtxs[i]))
+		{
+			break;
+		}
+	}
+
+	return 0;
+}
+
+/// 返回本次状态变化的次数，为0表示主线已无可推进的状态
+int RuntimeShard::MainlineFSM(Runtime_t* pRuntime, ModContext_t* pCtx)
+{
+	int count = 0;
+
+	assert(pRuntime);
+	switch (pRuntime->m_nStat)
+	{
+		case RTS_INIT:
+			m_pLogger->LogWrite(DEBUG_3, MODULE_JFR, "New line init.");
+			m_pLogger->LogWrite(DEBUG_1, MODULE_JFR, LOG_FUNC_STRING, LOG_FUNC_VALUE);
+		case RTS_WAIT:
+			count = TriggerFSM(pRuntime);
+			break;
+		case RTS_RUN:
+			count = ModuleFSM(pRuntime, pCtx);
+			break;
+		case RTS_FINISH:
+			m_pLogger->LogWrite(DEBUG_3, MODULE_JFR, "New line finish.");
+			m_pLogger->LogWrite(DEBUG_1, MODULE_JFR, LOG_FUNC_STRING, LOG_FUNC_VALUE);
+			pRuntime->m_nStat = RTS_DESTROY;
+			count = 1;
+			break;
+		case RTS_ERROR:
+			m_pLogger->LogWrite(DEBUG_3, MODULE_JFR, "New line error.");
+			m_pLogger->LogWrite(DEBUG_1, MODULE_JFR, LOG_FUNC_STRING, LOG_FUNC_VALUE);
+			pRuntime->m_nStat = RTS_DESTROY;
+			count = 1;
+			break;
+		case RTS_DESTROY:
+			m_pLogger->LogWrite(DEBUG_3, MODULE_JFR, "New line destroy.");
+			m_pLogger->LogWrite(DEBUG_1, MODULE_JFR, LOG_FUNC_STRING, LOG_FUNC_VALUE);
+			FSMLineDestroy(pRuntime);		// 运行时已释放，不再推进
+			break;
+		default:
+			m_pLogger->LogWrite(DEBUG_1, MODULE_JFR, LOG_FUNC_STRING, LOG_FUNC_VALUE);
+			assert(0);
+			break;
+	}
+
+	return count;
+}
+
+int RuntimeShard::TriggerFSM(Runtime_t* pRuntime)
+{
+	int count = 0;
+
+	assert(pRuntime);
+	switch (pRuntime->m_pTriggerCtx->m_nStat.load(boost::memory_order_acquire))
+	{
+		case RTS_INIT:
+			FSMTriggerInit(pRuntime);
+			count = 1;
+			m_pLogger->LogWrite(DEBUG_3, MODULE_JFR, "New trigger init.");
+			m_pLogger->LogWrite(DEBUG_1, MODULE_JFR, LOG_FUNC_STRING, LOG_FUNC_VALUE);
+			break;
+		case RTS_RUN:
+		case RTS_READY:
+			break;
+		case RTS_FINISH:
+			FSMTriggerFinish(pRuntime);
+			count = 1;
+			m_pLogger->LogWrite(DEBUG_3, MODULE_JFR, "New trigger finish.");
+			m_pLogger->LogWrite(DEBUG_1, MODULE_JFR, LOG_FUNC_STRING, LOG_FUNC_VALUE);
+			break;
+		case RTS_TIMEOUT:
+			FSMTriggerTimeout(pRuntime);
+			count = 1;
+			m_pLogger->LogWrite(DEBUG_3, MODULE_JFR, "New trigger timeout.");
+			m_pLogger->LogWrite(DEBUG_1, MODULE_JFR, LOG_FUNC_STRING, LOG_FUNC_VALUE);
+			break;
+		case RTS_SYSERROR:		// 启动触发器失败，与超时相同，本次实例作废
+			FSMTriggerTimeout(pRuntime);
+			count = 1;
+			m_pLogger->LogWrite(DEBUG_3, MODULE_JFR, "New trigger system error.");
+			m_pLogger->LogWrite(DEBUG_1, MODULE_JFR, LOG_FUNC_STRING, LOG_FUNC_VALUE);
+			break;
+		case RTS_DESTROY:
+			break;
+		default:
+			m_pLogger->LogWrite(DEBUG_1, MODULE_JFR, LOG_FUNC_STRING, LOG_FUNC_VALUE);
+			assert(0);
+			break;
+	}
+
+	return count;
+}
+
+int RuntimeShard::ModuleFSM(Runtime_t* pRuntime, ModContext_t* pCtx)
+{
+	ModContext_t* pEndCtx;
+	int count = 0;
+
+	assert(pRuntime);
+	if (pCtx && pCtx->m_pLineMod)
+	{
+		count += FSMModuleFinish(pRuntime, pCtx->m_pLineMod);
+	}
+
+	assert(pRuntime->m_pLine->m_pEnd);
+	pEndCtx = pRuntime->m_vModCtxs[pRuntime->m_pLine->m_pEnd->m_nIndex];
+	switch (pEndCtx->m_nStat.load(boost::memory_order_acquire))
+	{
+		case RTS_INIT:
+		case RTS_WAIT:
+		case RTS_RUN:
+		case RTS_READY:
+		case RTS_EQUAL:
+			break;
+		case RTS_FINISH:
+			count += FSMEndModuleFinish(pRuntime, pEndCtx);
+			break;
+		case RTS_ERROR:
+		case RTS_TIMEOUT:
+		case RTS_CANCEL:
+		case RTS_SYSERROR:
+			count += FSMEndModuleFinish(pRuntime, pEndCtx);
+			break;
+		case RTS_DESTROY:
+			break;
+		default:
+			m_pLogger->LogWrite(DEBUG_1, MODULE_JFR, LOG_FUNC_STRING, LOG_FUNC_VALUE);
+			assert(0);
+			break;
+	}
+
+	return count;
+}
+
+int RuntimeShard::FSMLineDestroy(Runtime_t* pRuntime)
+{
+	set< Runtime_t* >::iterator s_iter;
+	multimap< boost::system_time, HedgeTimer_t >::iterator t_iter;
+
+	assert(pRuntime);
+	s_iter = m_sRunList.find(pRuntime);
+	if (s_iter != m_sRunList.end())
+	{
+		/// 运行时将被复用，清除就绪队列中属于本实例的任务
+		m_oReadyQueue.RemoveIf(ReadyJobMatch_t(pRuntime));
+		t_iter = m_mapHedgeTimers.begin();
+		while (t_iter != m_mapHedgeTimers.end())
+		{
+			if (t_iter->second.m_pRuntime == pRuntime)
+			{
+				m_mapHedgeTimers.erase(t_iter++);
+			}
+			else
+			{
+				++t_iter;
+			}
+		}
+		m_sRunList.erase(s_iter);
+		m_sDrainList.insert(pRuntime);
+		ReapRuntime(pRuntime);
+		return 0;
+	}
+
+	m_pLogger->LogWrite(DEBUG_1, MODULE_JFR, LOG_FUNC_STRING, LOG_FUNC_VALUE);
+	assert(0);
+	return -1;
+}
+
+/// 已结束的主线没有仍在运行的模块时回收运行时，返回1表示已回收
+// 运行中的模块返回前仍会写入出参和上下文，运行时不能提前复用
+int RuntimeShard::ReapRuntime(Runtime_t* pRuntime)
+{
+	assert(pRuntime);
+	for (size_t i = 0; i < pRuntime->m_vModCtxs.size(); ++i)
+	{
+		ModContext_t* pCtx = pRuntime->m_vModCtxs[i];
+		if (pCtx->m_nStat.load(boost::memory_order_acquire) == RTS_RUN)
+		{
+			return 0;
+		}
+	}
+	m_sDrainList.erase(pRuntime);
+	m_pLineSet->Release(pRuntime);
+
+	return 1;
+}
+
+int RuntimeShard::FSMTriggerInit(Runtime_t* pRuntime)
+{
+	int ret;
+	assert(pRuntime);
+
+	pRuntime->m_nStat = RTS_WAIT;
+	pRuntime->m_pTriggerCtx->m_nStat.store(RTS_RUN, boost::memory_order_relaxed);
+	for (size_t i = 0; i < pRuntime->m_vModCtxs.size(); ++i)
+	{
+		ModContext_t* pCtx = pRuntime->m_vModCtxs[i];
+		pCtx->m_nStat.store(RTS_WAIT, boost::memory_order_relaxed);
+	}
+	ret = Submit(pRuntime, NULL);
+	if (ret == -1)
+	{
+		m_pLogger->LogWrite(FATAL, MODULE_JFR, "call trigger instance failed, trigger name: %s.", pRuntime->m_pLine->m_oTrigger.m_pTrigger->m_sName.c_str());
+		m_pLogger->LogWrite(DEBUG_1, MODULE_JFR, LOG_FUNC_STRING, LOG_FUNC_VALUE);
+		assert(0);
+		return -1;
+	}
+
+	return 0;
+}
+
+int RuntimeShard::FSMTriggerFinish(Runtime_t* pRuntime)
+{
+	int ret;
+	list< LineModule_t* > lErrorMods;
+
+    assert(pRuntime);
+    pRuntime->m_nStat = RTS_RUN;
+    if (pRuntime->m_nGeneration == m_nGeneration)		// 旧一代的实例不再放回
+    {
+        m_oAdmitQueue.Push(pRuntime->m_pLine->m_nFlow, pRuntime->m_pLine);
+    }
+
+	/// 无必要条件的模块直接运行，依赖触发器的模块根据触发器返回值运行
+	for (size_t i = 0; i < pRuntime->m_pLine->m_vModules.size(); ++i)
+	{
+		if (pRuntime->m_pLine->m_vModules[i]->m_nSlotNum == 0)
+		{
+			FSMModuleReady(pRuntime, pRuntime->m_pLine->m_vModules[i], lErrorMods);
+		}
+	}
+	ret = pRuntime->m_pTriggerCtx->m_nRetValue;
+	FSMResolve(pRuntime, pRuntime->m_pLine->m_vTriggerSuccessors, true, ret);
+
+    return 0;
+}
+
+/// 触发器超时，本次实例作废，放回待触发队列
+int RuntimeShard::FSMTriggerTimeout(Runtime_t* pRuntime)
+{
+	assert(pRuntime);
+	pRuntime->m_nStat = RTS_ERROR;
+	if (pRuntime->m_nGeneration == m_nGeneration)		// 旧一代的实例不再放回
+	{
+		m_oAdmitQueue.Push(pRuntime->m_pLine->m_nFlow, pRuntime->m_pLine);
+	}
+
+	return 0;
+}
+
+/// 结束条件已有结果，其余模块不再影响主线结果，仍在运行的模块取消，主线不等待其返回
+int RuntimeShard::FSMEndModuleFinish(Runtime_t* pRuntime, ModContext_t* pEndCtx)
+{
+	bool flag;
+
+	assert(pRuntime && pEndCtx);
+	for (size_t i = 0; i < pRuntime->m_vModCtxs.size(); ++i)
+	{
+		ModContext_t* pCtx = pRuntime->m_vModCtxs[i];
+		if (pCtx == pEndCtx)
+		{
+			continue;
+		}
+		flag = pCtx->m_nStat.load(boost::memory_order_acquire) == RTS_RUN;
+		if (!flag)
+		{
+			pCtx->m_nStat.store(RTS_DESTROY, boost::memory_order_relaxed);
+		}
+		if (flag)
+		{
+			m_pWatchdog->Cancel(pCtx, RTS_CANCEL);
+		}
+	}
+	pRuntime->m_nStat = pEndCtx->m_nStat.load(boost::memory_order_acquire) == RTS_FINISH ? RTS_FINISH : RTS_ERROR;
+	pEndCtx->m_nStat.store(RTS_DESTROY, boost::memory_order_relaxed);
+
+	return 1;
+}
+
+/// 模块运行结束，将结果传递给后继模块；运行出错(常驻进程调用失败等)、系统错误(创建进程失败等)、超时、取消的模块按出错传递
+// 因必要条件失败置为error的模块已在FSMModuleReady中传递
+int RuntimeShard::FSMModuleFinish(Runtime_t* pRuntime, LineModule_t* pLineMod)
+{
+	unsigned int stat;
+	int ret;
+	ModContext_t* pCtx;
+
+	assert(pRuntime && pLineMod);
+	if (pRuntime->m_vPropagated[pLineMod->m_nIndex])
+	{
+		return 0;
+	}
+	pCtx = pRuntime->m_vModCtxs[pLineMod->m_nIndex];
+	stat = pCtx->m_nStat.load(boost::memory_order_acquire);
+	ret = pCtx->m_nRetValue;
+	if (stat != RTS_FINISH && stat != RTS_ERROR && stat != RTS_TIMEOUT && stat != RTS_CANCEL && stat != RTS_SYSERROR)
+	{
+		return 0;
+	}
+	pRuntime->m_vPropagated[pLineMod->m_nIndex] = true;
+	if (pLineMod->m_nGroup != JFR_LINE_NO_GROUP)
+	{
+		FSMGroupFinish(pRuntime, pLineMod, stat == RTS_FINISH, ret);
+	}
+
+	return FSMResolve(pRuntime, pLineMod->m_vSuccessors, stat == RTS_FINISH, ret) + 1;
+}
+
+/// 等效组模块的必要条件均已满足，按策略决定运行、暂缓或取消
+int RuntimeShard::FSMGroupAdmit(Runtime_t* pRuntime, LineModule_t* pLineMod)
+{
+	size_t nGroup;
+	const LineEquGroup_t* pGroup;
+
+	assert(pRuntime && pLineMod && pLineMod->m_nGroup != JFR_LINE_NO_GROUP);
+	nGroup = pLineMod->m_nGroup;
+	pGroup = &pRuntime->m_pLine->m_vEquGroups[nGroup];
+	if (pRuntime->m_vGroupDone[nGroup])
+	{
+		return GA_CANCEL;
+	}
+	if (pGroup->m_nPolicy == EP_HEDGE && pRuntime->m_vGroupLaunched[nGroup] >= pRuntime->m_vGroupAllowed[nGroup])
+	{
+		pRuntime->m_vHeld[pLineMod->m_nIndex] = true;
+		return GA_HOLD;
+	}
+	++pRuntime->m_vGroupLaunched[nGroup];
+	/// 组内还有未运行的模块时设置定时器
+	if (pGroup->m_nPolicy == EP_HEDGE && pRuntime->m_vGroupLaunched[nGroup] < pGroup->m_vMembers.size())
+	{
+		HedgeTimer_t timer;
+		timer.m_pRuntime = pRuntime;
+		timer.m_nGroup = nGroup;
+		timer.m_nStamp = pRuntime->m_vGroupLaunched[nGroup];
+		m_mapHedgeTimers.insert(make_pair(boost::get_system_time() + boost::posix_time::milliseconds(pGroup->m_nDelay), timer));
+	}
+
+	return GA_LAUNCH;
+}
+
+/// 按组内顺序运行暂缓的模块，直至达到允许运行的个数，返回运行的模块个数
+int RuntimeShard::FSMGroupLaunch(Runtime_t* pRuntime, size_t nGroup)
+{
+	int count = 0;
+	const LineEquGroup_t* pGroup;
+
+	assert(pRuntime);
+	pGroup = &pRuntime->m_pLine->m_vEquGroups[nGroup];
+	for (size_t i = 0; i < pGroup->m_vMembers.size(); ++i)
+	{
+		size_t nIndex = pGroup->m_vMembers[i];
+		if (pRuntime->m_vGroupLaunched[nGroup] >= pRuntime->m_vGroupAllowed[nGroup])
+		{
+			break;
+		}
+		if (!pRuntime->m_vHeld[nIndex])
+		{
+			continue;
+		}
+		pRuntime->m_vHeld[nIndex] = false;
+		LineModule_t* pLineMod = pRuntime->m_pLine->m_vModules[nIndex];
+		if (FSMGroupAdmit(pRuntime, pLineMod) != GA_LAUNCH)
+		{
+			break;
+		}
+		ModContext_t* pCtx = pRuntime->m_vModCtxs[nIndex];
+		if (pCtx->m_nStat.load(boost::memory_order_acquire) != RTS_WAIT)		// line quit, do not run
+		{
+			continue;
+		}
+		pCtx->m_nStat.store(RTS_RUN, boost::memory_order_relaxed);
+		if (Submit(pRuntime, pLineMod) == -1)
+		{
+			m_pLogger->LogWrite(FATAL, MODULE_JFR, "call module instance failed, module name: %s.", pLineMod->m_pModule->m_sName.c_str());
+			m_pLogger->LogWrite(DEBUG_1, MODULE_JFR, LOG_FUNC_STRING, LOG_FUNC_VALUE);
+		}
+		++count;
+	}
+
+	return count;
+}
+
+/// 等效组模块运行结束；满足所有后继模块的要求时取消其余模块，否则hedge策略运行下一个
+int RuntimeShard::FSMGroupFinish(Runtime_t* pRuntime, LineModule_t* pLineMod, bool bFinish, int nRetValue)
+{
+	size_t nGroup;
+
+	assert(pRuntime && pLineMod && pLineMod->m_nGroup != JFR_LINE_NO_GROUP);
+	nGroup = pLineMod->m_nGroup;
+	if (pRuntime->m_vGroupDone[nGroup])
+	{
+		return 0;
+	}
+	for (size_t i = 0; bFinish && i < pLineMod->m_vSuccessors.size(); ++i)
+	{
+		if (!pLineMod->m_vSuccessors[i].m_oRetValue.Euqal(nRetValue))
+		{
+			bFinish = false;
+		}
+	}
+	if (bFinish)
+	{
+		pRuntime->m_vGroupDone[nGroup] = true;
+		return FSMGroupCancel(pRuntime, nGroup);
+	}
+	if (pRuntime->m_pLine->m_vEquGroups[nGroup].m_nPolicy == EP_HEDGE)
+	{
+		++pRuntime->m_vGroupAllowed[nGroup];
+		return FSMGroupLaunch(pRuntime, nGroup);
+	}
+
+	return 0;
+}
+
+/// 取消等效组中尚无结果的模块，返回取消的模块个数
+// 等效组即后继模块的一个必要条件集合，集合已满足要求，取消的模块无需再传递结果
+int RuntimeShard::FSMGroupCancel(Runtime_t* pRuntime, size_t nGroup)
+{
+	int count = 0;
+	unsigned int stat;
+	const LineEquGroup_t* pGroup;
+
+	assert(pRuntime);
+	pGroup = &pRuntime->m_pLine->m_vEquGroups[nGroup];
+	for (size_t i = 0; i < pGroup->m_vMembers.size(); ++i)
+	{
+		size_t nIndex = pGroup->m_vMembers[i];
+		ModContext_t* pCtx = pRuntime->m_vModCtxs[nIndex];
+		pRuntime->m_vHeld[nIndex] = false;
+		stat = pCtx->m_nStat.load(boost::memory_order_acquire);
+		if (stat == RTS_WAIT || stat == RTS_READY)		// 就绪队列中的任务提交时丢弃
+		{
+			pCtx->m_nStat.store(RTS_CANCEL, boost::memory_order_relaxed);
+			pRuntime->m_vPropagated[nIndex] = true;
+		}
+		if (stat == RTS_RUN)		// 运行结束时状态为cancel
+		{
+			m_pWatchdog->Cancel(pCtx, RTS_CANCEL);
+		}
+		if (stat == RTS_WAIT || stat == RTS_READY || stat == RTS_RUN)
+		{
+			++count;
+		}
+	}
+
+	return count;
+}
+
+/// 按依赖边更新后继模块的必要条件集合；因依赖失败置为error的模块继续向后传递
+int RuntimeShard::FSMResolve(Runtime_t* pRuntime, const vector< LineEdge_t >& vEdges, bool bFinish, int nRetValue)
+{
+	int count;
+	list< LineModule_t* > lErrorMods;
+
+	assert(pRuntime);
+	count = FSMResolveEdges(pRuntime, vEdges, bFinish, nRetValue, lErrorMods);
+	while (!lErrorMods.empty())
+	{
+		LineModule_t* pLineMod = lErrorMods.front();
+		lErrorMods.pop_front();
+		count += FSMResolveEdges(pRuntime, pLineMod->m_vSuccessors, false, 0, lErrorMods);
+	}
+
+	return count;
+}
+
+int RuntimeShard::FSMResolveEdges(Runtime_t* pRuntime, const vector< LineEdge_t >& vEdges, bool bFinish, int nRetValue, list< LineModule_t* >& lErrorMods)
+{
+	int count = 0;
+	Line_t* pLine;
+
+	assert(pRuntime);
+	pLine = pRuntime->m_pLine;
+	for (size_t i = 0; i < vEdges.size(); ++i)
+	{
+		const LineEdge_t& edge = vEdges[i];
+		int& nSlotFails = pRuntime->m_vSlotFails[edge.m_nSlot];
+		if (nSlotFails < 0)		// 集合已有结果
+		{
+			continue;
+		}
+		if (bFinish && edge.m_oRetValue.Euqal(nRetValue))		// 等效条件中有一个满足要求，集合满足要求
+		{
+			nSlotFails = -1;
+		}
+		else if ((size_t)++nSlotFails == pLine->m_vSlotSizes[edge.m_nSlot])		// 等效条件均不满足要求，集合为error
+		{
+			nSlotFails = -1;
+			++pRuntime->m_vFailed[edge.m_nModule];
+		}
+		else
+		{
+			continue;
+		}
+		if (--pRuntime->m_vRemaining[edge.m_nModule] > 0)
+		{
+			continue;
+		}
+		count += FSMModuleReady(pRuntime, pLine->m_vModules[edge.m_nModule], lErrorMods);
+	}
+
+	return count;
+}
+
+/// 模块的必要条件集合均已有结果，运行模块或置为error
+int RuntimeShard::FSMModuleReady(Runtime_t* pRuntime, LineModule_t* pLineMod, list< LineModule_t* >& lErrorMods)
+{
+	ModContext_t* pCtx;
+
+	assert(pRuntime && pLineMod);
+	pCtx = pRuntime->m_vModCtxs[pLineMod->m_nIndex];
+	if (pCtx->m_nStat.load(boost::memory_order_acquire) != RTS_WAIT)		// line quit, do not run
+	{
+		return 0;
+	}
+	if (pRuntime->m_vFailed[pLineMod->m_nIndex] > 0)
+	{
+		pCtx->m_nStat.store(RTS_ERROR, boost::memory_order_relaxed);
+		pRuntime->m_vPropagated[pLineMod->m_nIndex] = true;
+		lErrorMods.push_back(pLineMod);
+		return 1;
+	}
+	if (pLineMod->m_nGroup != JFR_LINE_NO_GROUP)
+	{
+		switch (FSMGroupAdmit(pRuntime, pLineMod))
+		{
+			case GA_HOLD:
+				return 0;
+			case GA_CANCEL:
+				pCtx->m_nStat.store(RTS_CANCEL, boost::memory_order_relaxed);
+				pRuntime->m_vPropagated[pLineMod->m_nIndex] = true;
+				return 1;
+			default:
+				break;
+		}
+	}
+	pCtx->m_nStat.store(RTS_RUN, boost::memory_order_relaxed);
+	if (Submit(pRuntime, pLineMod) == -1)
+	{
+		m_pLogger->LogWrite(FATAL, MODULE_JFR, "call module instance failed, module name: %s.", pLineMod->m_pModule->m_sName.c_str());
+		m_pLogger->LogWrite(DEBUG_1, MODULE_JFR, LOG_FUNC_STRING, LOG_FUNC_VALUE);
+	}
+
+	return 1;
+}
+
+ModContext_t* RuntimeShard::JobContext(Runtime_t* pRuntime, LineModule_t* pLineMod)
+{
+	return pLineMod ? pRuntime->m_vModCtxs[pLineMod->m_nIndex] : pRuntime->m_pTriggerCtx;
+}
+
+/// 提交任务到线程池，pLineMod为NULL时提交触发器
+// 返回0表示已提交，1表示线程池已满，-1表示出错
+int RuntimeShard::Dispatch(Runtime_t* pRuntime, LineModule_t* pLineMod)
+{
+	assert(pRuntime);
+	if (pLineMod)
+	{
+		return ModuleCaller::Call(pRuntime, pLineMod);
+	}
+
+	return ModuleCaller::Call(pRuntime);
+}
+
+/// 任务状态已置为RTS_RUN，提交失败时改为RTS_READY并放入就绪队列
+// 就绪队列非空时直接排队，由公平队列决定提交顺序
+int RuntimeShard::Submit(Runtime_t* pRuntime, LineModule_t* pLineMod)
+{
+	int ret;
+	ReadyJob_t job;
+	ModContext_t* pCtx;
+
+	assert(pRuntime);
+	if (m_oReadyQueue.Empty())
+	{
+		ret = Dispatch(pRuntime, pLineMod);
+		if (ret != 1)
+		{
+			return ret;
+		}
+		m_pEventQueue->Starve(m_nId);
+	}
+	pCtx = JobContext(pRuntime, pLineMod);
+	pCtx->m_nStat.store(RTS_READY, boost::memory_order_relaxed);
+	job.m_pRuntime = pRuntime;
+	job.m_pLineMod = pLineMod;
+	m_oReadyQueue.Push(pRuntime->m_pLine->m_nFlow, job);
+
+	return 1;
+}
+
+/// 按优先级、权重提交就绪任务，直至线程池再次满员，返回提交的任务个数
+int RuntimeShard::DrainReadyList(void)
+{
+	int ret, count = 0;
+	ModContext_t* pCtx;
+	ReadyJob_t* pJob;
+
+	while ((pJob = m_oReadyQueue.Front()) != NULL)
+	{
+		ReadyJob_t job = *pJob;
+		pCtx = JobContext(job.m_pRuntime, job.m_pLineMod);
+		if (pCtx->m_nStat.load(boost::memory_order_acquire) != RTS_READY)		// line quit, do not run
+		{
+			m_oReadyQueue.Pop();
+			continue;
+		}
+		pCtx->m_nStat.store(RTS_RUN, boost::memory_order_relaxed);
+		ret = Dispatch(job.m_pRuntime, job.m_pLineMod);
+		if (ret == 1)
+		{
+			pCtx->m_nStat.store(RTS_READY, boost::memory_order_relaxed);
+			m_pEventQueue->Starve(m_nId);
+			break;
+		}
+		if (ret == -1)
+		{
+			m_pLogger->LogWrite(FATAL, MODULE_JFR, "call ready job failed, line name: %s.", job.m_pRuntime->m_pLine->m_sName.c_str());
+			m_pLogger->LogWrite(DEBUG_1, MODULE_JFR, LOG_FUNC_STRING, LOG_FUNC_VALUE);
+		}
+		m_oReadyQueue.Pop();
+		++count;
+	}
+
+	return count;
+}
+
+
+CLOSE_NAMESPACE_JFR
@@ -0,0 +1,120 @@
+#include "ShmSegment.h"
+
+OPEN_NAMESPACE_JFR
+
+/// 创建memfd，带O_CLOEXEC，并发启动的子进程不会继承；传给子进程时由posix_spawn的dup2清除
+int ShmSegment::Create(const char* sName)
+{
+	return memfd_create(sName, MFD_CLOEXEC | MFD_ALLOW_SEALING);
+}
+
+/// 以pBuf的内容创建memfd，失败时返回-1，errno为失败原因
+int ShmSegment::FromBuffer(const char* pBuf, size_t nLength)
+{
+	int fd, err;
+	ssize_t ret;
+
+	fd = Create("jfr_arg");
+	if (fd == -1)
+	{
+		return -1;
+	}
+	while (nLength > 0)
+	{
+		ret = write(fd, pBuf, nLength);
+		if (ret == -1)
+		{
+			if (errno == EINTR)
+			{
+				continue;
+			}
+			err = errno;
+			close(fd);
+			errno = err;
+			return -1;
+		}
+		pBuf += ret;
+		nLength -= ret;
+	}
+
+	return fd;
+}
+
+/// 封印并映射子进程写完的memfd，成功时fd归映射所有，由Free关闭；失败时返回NULL，fd由调用者关闭
+// 仍有进程以可写方式共享映射时无法封印，此时失败，避免内容在使用中被修改或截断
+char* ShmSegment::Map(int fd, size_t& nLength)
+{
+	struct stat st;
+	size_t page, total;
+	char* base;
+	Header_t* pHeader;
+
+	assert(fd >= 0);
+	if (fstat(fd, &st) == -1)
+	{
+		return NULL;
+	}
+	if (fcntl(fd, F_ADD_SEALS, F_SEAL_SHRINK | F_SEAL_GROW | F_SEAL_WRITE | F_SEAL_SEAL) == -1)
+	{
+		return NULL;
+	}
+	page = PageSize();
+	nLength = st.st_size;
+	total = page + (nLength + 1 + page - 1) / page * page;		// 内容之后至少一个字节为'\0'
+	base = (char*)mmap(NULL, total, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+	if (base == MAP_FAILED)
+	{
+		return NULL;
+	}
+	/// 内容覆盖在匿名映射上，最后一页文件末尾之后的部分为0
+	if (nLength > 0 && mmap(base + page, nLength, PROT_READ, MAP_PRIVATE | MAP_FIXED, fd, 0) == MAP_FAILED)
+	{
+		int err = errno;
+		munmap(base, total);
+		errno = err;
+		return NULL;
+	}
+	pHeader = (Header_t*)base;
+	pHeader->m_nMapSize = total;
+	pHeader->m_nLength = nLength;
+	pHeader->m_nFd = fd;
+
+	return base + page;
+}
+
+/// 参数值的释放回调函数
+void ShmSegment::Free(void* pValue)
+{
+	Header_t* pHeader;
+	size_t total;
+	int fd;
+
+	if (!pValue)
+	{
+		return;
+	}
+	pHeader = (Header_t*)((char*)pValue - PageSize());
+	total = pHeader->m_nMapSize;
+	fd = pHeader->m_nFd;
+	munmap((void*)pHeader, total);
+	close(fd);
+}
+
+/// 参数值为共享内存出参时返回其memfd，否则返回-1
+int ShmSegment::Fd(const ArgValue_t* pArgValue)
+{
+	if (!pArgValue || !pArgValue->m_pValue || pArgValue->m_pFreeFunc != &ShmSegment::Free)
+	{
+		return -1;
+	}
+	return ((const Header_t*)((const char*)pArgValue->m_pValue - PageSize()))->m_nFd;
+}
+
+size_t ShmSegment::PageSize(void)
+{
+	static const size_t page = sysconf(_SC_PAGESIZE);
+	return page;
+}
+
+
+CLOSE_NAMESPACE_JFR
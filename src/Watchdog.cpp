@@ -0,0 +1,148 @@
+#include "Watchdog.h"
+
+OPEN_NAMESPACE_JFR
+
+Watchdog::Watchdog(void)
+{
+	m_pThread = NULL;
+	m_bStop = false;
+	m_pLogger = &jfr::LoggerSingleton::get_mutable_instance();
+}
+
+Watchdog::~Watchdog(void)
+{
+	Stop();
+}
+
+int Watchdog::Start(void)
+{
+	boost::lock_guard< boost::mutex > guard(m_oMutex);
+	if (m_pThread)
+	{
+		return 0;
+	}
+	m_bStop = false;
+	m_pThread = new boost::thread(boost::bind(&Watchdog::Run, this));
+
+	return 0;
+}
+
+void Watchdog::Stop(void)
+{
+	boost::thread* pThread;
+
+	{
+		boost::lock_guard< boost::mutex > guard(m_oMutex);
+		pThread = m_pThread;
+		m_pThread = NULL;
+		m_bStop = true;
+		m_oCond.notify_one();
+	}
+	if (pThread)
+	{
+		pThread->join();
+		delete pThread;
+	}
+}
+
+/// 模块开始运行时调用，timeout单位为毫秒
+int Watchdog::Watch(ModContext_t* pCtx, unsigned int timeout)
+{
+	assert(pCtx && timeout > 0);
+	pCtx->m_oDeadline = boost::get_system_time() + boost::posix_time::milliseconds(timeout);
+	boost::lock_guard< boost::mutex > guard(m_oMutex);
+	if (m_mapDeadlines.empty() || pCtx->m_oDeadline < m_mapDeadlines.begin()->first)
+	{
+		m_oCond.notify_one();
+	}
+	m_mapDeadlines.insert(make_pair(pCtx->m_oDeadline, pCtx));
+
+	return 0;
+}
+
+/// 模块运行结束时调用，返回后Watchdog不再访问pCtx
+int Watchdog::Unwatch(ModContext_t* pCtx)
+{
+	multimap< boost::system_time, ModContext_t* >::iterator m_iter, m_end;
+
+	assert(pCtx);
+	boost::lock_guard< boost::mutex > guard(m_oMutex);
+	m_end = m_mapDeadlines.upper_bound(pCtx->m_oDeadline);
+	for (m_iter = m_mapDeadlines.lower_bound(pCtx->m_oDeadline); m_iter != m_end; ++m_iter)
+	{
+		if (m_iter->second == pCtx)
+		{
+			m_mapDeadlines.erase(m_iter);
+			return 0;
+		}
+	}
+
+	return -1;
+}
+
+void Watchdog::Run(void)
+{
+	boost::mutex::scoped_lock lock(m_oMutex);
+
+	m_pLogger->LogWrite(DEBUG_3, MODULE_JFR, "Begin to run watchdog.");
+	m_pLogger->LogWrite(DEBUG_1, MODULE_JFR, LOG_FUNC_STRING, LOG_FUNC_VALUE);
+	while (!m_bStop)
+	{
+		if (m_mapDeadlines.empty())
+		{
+			m_oCond.wait(lock);
+			continue;
+		}
+		if (m_mapDeadlines.begin()->first > boost::get_system_time())
+		{
+			m_oCond.timed_wait(lock, m_mapDeadlines.begin()->first);
+			continue;
+		}
+		/// 已超时的模块只处理一次，运行结束时Unwatch找不到记录
+		ModContext_t* pCtx = m_mapDeadlines.begin()->second;
+		m_mapDeadlines.erase(m_mapDeadlines.begin());
+		Expire(pCtx);
+	}
+	m_pLogger->LogWrite(DEBUG_3, MODULE_JFR, "End to run watchdog.");
+	m_pLogger->LogWrite(DEBUG_1, MODULE_JFR, LOG_FUNC_STRING, LOG_FUNC_VALUE);
+}
+
+/// 置取消标志为stat并杀掉进程模块的进程组，已取消的模块保留先前的取消原因，返回子进程号
+// kill期间m_nPid置为JFR_PID_BUSY，子进程回收前等待其恢复并清除，保证不会误杀复用的进程组
+int Watchdog::Cancel(ModContext_t* pCtx, unsigned int stat)
+{
+	int canceled = 0;
+	pid_t pid;
+
+	assert(pCtx && stat);
+	pCtx->m_oEnv.m_nCanceled.compare_exchange_strong(canceled, (int)stat);
+	pid = pCtx->m_nPid;
+	while (pid > 0 && !pCtx->m_nPid.compare_exchange_weak(pid, JFR_PID_BUSY))
+	{
+	}
+	if (pid <= 0)		// 未登记、已回收或其它取消方正在kill
+	{
+		return 0;
+	}
+	if (kill(-pid, SIGKILL) == -1 && errno != ESRCH)
+	{
+		m_pLogger->LogWrite(ERROR, MODULE_JFR, "kill canceled process group failed, %s, errno: %d, pid: %d.", strerror(errno), errno, pid);
+		m_pLogger->LogWrite(DEBUG_1, MODULE_JFR, LOG_FUNC_STRING, LOG_FUNC_VALUE);
+	}
+	pCtx->m_nPid = pid;
+
+	return pid;
+}
+
+/// 持有m_oMutex时调用，调用线程在Unwatch返回前不会结束模块运行
+void Watchdog::Expire(ModContext_t* pCtx)
+{
+	pid_t pid;
+
+	pid = Cancel(pCtx, RTS_TIMEOUT);
+	m_pLogger->LogWrite(WARNING, MODULE_JFR, "module timeout, timeout: %d ms, pid: %d.", pCtx->m_oEnv.m_nTimeout, pid);
+	m_pLogger->LogWrite(DEBUG_1, MODULE_JFR, LOG_FUNC_STRING, LOG_FUNC_VALUE);
+}
+
+
+CLOSE_NAMESPACE_JFR
@@ -0,0 +1,270 @@
+#include "WorkerPool.h"
+#include "ModuleCaller.h"
+
+OPEN_NAMESPACE_JFR
+
+WorkerPool::WorkerPool(const string& name, const string& filename, unsigned int workers, unsigned int maxRequests, unsigned int maxReplyBytes)
+{
+	m_sName = name;
+	m_sFileName = filename;
+	m_nWorkers = workers > 0 ? workers : 1;
+	m_nMaxRequests = maxRequests;
+	m_nMaxReplyBytes = maxReplyBytes;
+	m_nLive = 0;
+	m_pLogger = &jfr::LoggerSingleton::get_mutable_instance();
+}
+
+/// 模块引用计数归零后销毁，此时没有使用中的进程
+WorkerPool::~WorkerPool(void)
+{
+	assert(m_nLive == m_vIdle.size());
+	for (size_t i = 0; i < m_vIdle.size(); ++i)
+	{
+		Stop(m_vIdle[i]);
+	}
+	m_vIdle.clear();
+	m_nLive = 0;
+}
+
+/// 取得空闲进程，没有空闲进程且未达到进程数上限时启动新进程，否则等待；启动失败返回NULL
+Worker_t* WorkerPool::Acquire(void)
+{
+	Worker_t* pWorker;
+
+	boost::unique_lock< boost::mutex > lock(m_oMutex);
+	while (m_vIdle.empty() && m_nLive >= m_nWorkers)
+	{
+		m_oCond.wait(lock);
+	}
+	if (!m_vIdle.empty())
+	{
+		pWorker = m_vIdle.back();
+		m_vIdle.pop_back();
+		return pWorker;
+	}
+	++m_nLive;
+	lock.unlock();
+	pWorker = Start();			// 在锁外启动，不阻塞其他线程取得空闲进程
+	if (pWorker == NULL)
+	{
+		lock.lock();
+		--m_nLive;
+		m_oCond.notify_one();
+	}
+
+	return pWorker;
+}
+
+/// 归还进程，bReuse为false或处理请求数达到上限时结束进程
+void WorkerPool::Release(Worker_t* pWorker, bool bReuse)
+{
+	assert(pWorker);
+	if (bReuse && m_nMaxRequests > 0 && pWorker->m_nRequests >= m_nMaxRequests)
+	{
+		m_pLogger->LogWrite(DEBUG_3, MODULE_JFR, "worker process reached max requests, restart it, module name: %s, pid: %d, requests: %u.", \
+												m_sName.c_str(), pWorker->m_nPid, pWorker->m_nRequests);
+		m_pLogger->LogWrite(DEBUG_1, MODULE_JFR, LOG_FUNC_STRING, LOG_FUNC_VALUE);
+		bReuse = false;
+	}
+	if (!bReuse)
+	{
+		Stop(pWorker);
+		boost::lock_guard< boost::mutex > guard(m_oMutex);
+		--m_nLive;
+		m_oCond.notify_one();
+		return;
+	}
+	boost::lock_guard< boost::mutex > guard(m_oMutex);
+	m_vIdle.push_back(pWorker);
+	m_oCond.notify_one();
+}
+
+/// 发送一个请求并读取应答，输出从pArena分配，以'\0'结尾，nLength为输出长度
+// 读写失败(进程退出、被kill)或应答格式错误时返回-1，调用者应结束该进程
+int WorkerPool::Call(Worker_t* pWorker, const ArgValue_t* const* ppArgs, size_t nArgc, Arena* pArena, int& nRetValue, char*& pOutput, size_t& nLength)
+{
+	string request;
+	char len[32];
+	char* buf;
+	size_t cap, pos, head;
+	unsigned long size;
+	int ret;
+
+	assert(pWorker && pArena);
+	snprintf(len, sizeof(len), "%lu\n", (unsigned long)nArgc);
+	request.append(len);
+	for (size_t i = 0; i < nArgc; ++i)
+	{
+		const char* value = ppArgs[i]->m_pValue ? (const char*)ppArgs[i]->m_pValue : "";
+		size_t n = ppArgs[i]->m_nLength ? ppArgs[i]->m_nLength : strlen(value);		// 二进制内容按记录的长度发送
+		snprintf(len, sizeof(len), "%lu\n", (unsigned long)n);
+		request.append(len);
+		request.append(value, n);
+	}
+	++pWorker->m_nRequests;
+	if (WriteAll(pWorker->m_nIn, request.data(), request.length()))
+	{
+		return -1;
+	}
+
+	buf = NULL;
+	cap = pos = head = 0;
+	size = 0;
+	while (head == 0 || pos < head + size)
+	{
+		if (pos == cap)
+		{
+			size_t newCap = cap ? cap * 2 : 1024;
+			if (head && newCap < head + size + 1)
+			{
+				newCap = head + size + 1;
+			}
+			buf = (char*)pArena->Grow((void*)buf, pos, newCap);
+			cap = newCap;
+		}
+		ret = read(pWorker->m_nOut, buf + pos, cap - pos);
+		if (ret == -1)
+		{
+			if (errno == EINTR)
+			{
+				continue;
+			}
+			return -1;
+		}
+		else if (ret == 0)		// 进程已退出
+		{
+			return -1;
+		}
+		pos += ret;
+		if (head == 0)
+		{
+			char* nl = (char*)memchr(buf, '\n', pos);
+			if (nl == NULL)
+			{
+				continue;
+			}
+			*nl = '\0';
+			if (sscanf(buf, "%d %lu", &nRetValue, &size) != 2)
+			{
+				m_pLogger->LogWrite(WARNING, MODULE_JFR, "worker process response format error, module name: %s, pid: %d, header: %.64s.", \
+														m_sName.c_str(), pWorker->m_nPid, buf);
+				m_pLogger->LogWrite(DEBUG_1, MODULE_JFR, LOG_FUNC_STRING, LOG_FUNC_VALUE);
+				return -1;
+			}
+			if (size > m_nMaxReplyBytes)		// 不按声明的长度分配
+			{
+				m_pLogger->LogWrite(WARNING, MODULE_JFR, "worker process response too long, module name: %s, pid: %d, declared: %lu, max reply bytes: %lu.", \
+														m_sName.c_str(), pWorker->m_nPid, size, m_nMaxReplyBytes);
+				m_pLogger->LogWrite(DEBUG_1, MODULE_JFR, LOG_FUNC_STRING, LOG_FUNC_VALUE);
+				return -1;
+			}
+			head = nl - buf + 1;
+		}
+	}
+	if (pos > head + size)		// 应答之后还有数据，不再与请求对应
+	{
+		m_pLogger->LogWrite(WARNING, MODULE_JFR, "worker process response longer than declared, module name: %s, pid: %d, declared: %lu, received: %lu.", \
+												m_sName.c_str(), pWorker->m_nPid, size, (unsigned long)(pos - head));
+		m_pLogger->LogWrite(DEBUG_1, MODULE_JFR, LOG_FUNC_STRING, LOG_FUNC_VALUE);
+		return -1;
+	}
+	if (pos == cap)
+	{
+		buf = (char*)pArena->Grow((void*)buf, pos, pos + 1);
+	}
+	buf[pos] = '\0';
+	pOutput = buf + head;
+	nLength = size;
+
+	return 0;
+}
+
+/// 启动一个进程，标准输入输出均为管道，标准错误继承jfr
+Worker_t* WorkerPool::Start(void)
+{
+	int in[2], out[2];
+	char* argv[2];
+	pid_t pid;
+	Worker_t* pWorker;
+
+	if (pipe2(in, O_CLOEXEC))
+	{
+		m_pLogger->LogWrite(ERROR, MODULE_JFR, "make pipe failed, %s, errno: %d.", strerror(errno), errno);
+		m_pLogger->LogWrite(DEBUG_1, MODULE_JFR, LOG_FUNC_STRING, LOG_FUNC_VALUE);
+		return NULL;
+	}
+	if (pipe2(out, O_CLOEXEC))
+	{
+		close(in[0]);
+		close(in[1]);
+		m_pLogger->LogWrite(ERROR, MODULE_JFR, "make pipe failed, %s, errno: %d.", strerror(errno), errno);
+		m_pLogger->LogWrite(DEBUG_1, MODULE_JFR, LOG_FUNC_STRING, LOG_FUNC_VALUE);
+		return NULL;
+	}
+	argv[0] = (char*)m_sFileName.c_str();
+	argv[1] = NULL;
+	pid = ModuleCaller::Spawn(m_sFileName, argv, in[0], out[1]);
+	close(in[0]);
+	close(out[1]);
+	if (pid == -1)
+	{
+		int err = errno;
+		close(in[1]);
+		close(out[0]);
+		m_pLogger->LogWrite(ERROR, MODULE_JFR, "spawn worker process failed, module name: %s, file name: %s, %s, errno: %d.", \
+												m_sName.c_str(), m_sFileName.c_str(), strerror(err), err);
+		m_pLogger->LogWrite(DEBUG_1, MODULE_JFR, LOG_FUNC_STRING, LOG_FUNC_VALUE);
+		return NULL;
+	}
+	pWorker = new Worker_t;
+	pWorker->m_nPid = pid;
+	pWorker->m_nIn = in[1];
+	pWorker->m_nOut = out[0];
+	m_pLogger->LogWrite(DEBUG_3, MODULE_JFR, "start worker process, module name: %s, pid: %d.", m_sName.c_str(), pid);
+	m_pLogger->LogWrite(DEBUG_1, MODULE_JFR, LOG_FUNC_STRING, LOG_FUNC_VALUE);
+
+	return pWorker;
+}
+
+/// 结束进程所在的进程组并回收
+void WorkerPool::Stop(Worker_t* pWorker)
+{
+	int status;
+
+	assert(pWorker);
+	close(pWorker->m_nIn);
+	close(pWorker->m_nOut);
+	kill(-pWorker->m_nPid, SIGKILL);
+	while (waitpid(pWorker->m_nPid, &status, 0) == -1 && errno == EINTR)
+	{
+	}
+	m_pLogger->LogWrite(DEBUG_3, MODULE_JFR, "stop worker process, module name: %s, pid: %d, requests: %u.", m_sName.c_str(), pWorker->m_nPid, pWorker->m_nRequests);
+	m_pLogger->LogWrite(DEBUG_1, MODULE_JFR, LOG_FUNC_STRING, LOG_FUNC_VALUE);
+	delete pWorker;
+}
+
+/// 进程已退出时写入失败(EPIPE)，jfr忽略SIGPIPE
+int WorkerPool::WriteAll(int fd, const char* buf, size_t len)
+{
+	ssize_t ret;
+
+	while (len > 0)
+	{
+		ret = write(fd, buf, len);
+		if (ret == -1)
+		{
+			if (errno == EINTR)
+			{
+				continue;
+			}
+			return -1;
+		}
+		buf += ret;
+		len -= ret;
+	}
+
+	return 0;
+}
+
+
+CLOSE_NAMESPACE_JFR
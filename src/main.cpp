@@ -168,15 +168,21 @@ int main(int argc, char** argv)
 		logger.LogWrite(ERROR, MODULE_JFR, "daemon write pid file failed, %s start failed.", MODULE_JFR);
 		return 1;
 	}
+	/// 重新加载信号由RuntimeManager的线程等待，在创建其他线程之前屏蔽，各线程继承屏蔽字
+	sigset_t sigset;
+	sigemptyset(&sigset);
+	sigaddset(&sigset, JFR_RELOAD_SIGNAL);
+	pthread_sigmask(SIG_BLOCK, &sigset, NULL);
+	/// 常驻进程模块的进程退出后写管道返回EPIPE，不能因SIGPIPE结束jfr
+	signal(SIGPIPE, SIG_IGN);
 	logger.SetChecker();
-	/// TODO signal
 
 	ThreadPool& pool = ThreadPool::get_mutable_instance();
     pool.set_max_thread_size(config.GetMaxThreadSize());
     pool.set_max_job_size(config.GetMaxJobSize());
 
     RuntimeManager& runtime_man = RuntimeManager::get_mutable_instance();
-    ret = runtime_man.Init(config.GetMaxRunLines(), mainline_man.GetMainLines(), mainline_man.GetStaticModules());
+    ret = runtime_man.Init(config.GetMaxRunLines(), config.GetSchedulerThreads(), config.GetMaxReadyNum(), mainline_man.TakeGeneration());
     if (ret == -1)
 	{
         cerr << "runtime manager init failed." << endl;
@@ -208,6 +214,8 @@ void ShowConfig(jfr::LoggerSingleton& logger, Config& config)
         printf("max run lines: %d\n", config.GetMaxRunLines());
         printf("max thread size: %d\n", config.GetMaxThreadSize());
         printf("max job size: %d\n", config.GetMaxJobSize());
+        printf("scheduler threads: %d\n", config.GetSchedulerThreads());
+        printf("max ready num: %d\n", config.GetMaxReadyNum());
         printf("debug level: %d\n", config.GetDebugLevel());
         printf("daemonize: %s\n", config.GetDaemonFlag() ? "true" : "false");
         printf("log to terminal: %s\n", config.GetLog2TermFlag() ? "true" : "false");
@@ -222,6 +230,8 @@ void ShowConfig(jfr::LoggerSingleton& logger, Config& config)
     logger.LogWrite(INFO, MODULE_JFR, "max run lines: %d", config.GetMaxRunLines());
     logger.LogWrite(INFO, MODULE_JFR, "max thread size: %d", config.GetMaxThreadSize());
     logger.LogWrite(INFO, MODULE_JFR, "max job size: %d", config.GetMaxJobSize());
+    logger.LogWrite(INFO, MODULE_JFR, "scheduler threads: %d", config.GetSchedulerThreads());
+    logger.LogWrite(INFO, MODULE_JFR, "max ready num: %d", config.GetMaxReadyNum());
     logger.LogWrite(INFO, MODULE_JFR, "debug level: %d", config.GetDebugLevel());
     logger.LogWrite(INFO, MODULE_JFR, "daemonize: %s", config.GetDaemonFlag() ? "true" : "false");
     logger.LogWrite(INFO, MODULE_JFR, "log to terminal: %s", config.GetLog2TermFlag() ? "true" : "false");
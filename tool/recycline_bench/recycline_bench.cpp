@@ -0,0 +1,127 @@
+/**
+ * RecyclingFactory取得、回收耗时测试
+ * 先取得n个产品并持有(模拟正在运行的主线实例)，再测量：
+ * 1. 取得后立即回收一个产品的耗时
+ * 2. 回收任意一个持有的产品(位于忙碌链表中间)后再取得一个产品的耗时
+ * 两项耗时不应随持有的产品数量增长；产品较多时第2项受缓存未命中影响，
+ * 以只随机访问持有的产品、不调用工厂的耗时作为对照，两者之差为工厂本身的耗时
+ *
+ * 用法：recycline_bench [每项测试的次数]
+ **/
+
+#include <time.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <string>
+#include <vector>
+#include "RecyclineFactory/RecyclineFactory.hpp"
+
+USING_NAMESPACE_SWITCHTOOL
+
+using namespace std;
+
+
+#define BENCH_DEFAULT_ROUNDS		1000000
+#define BENCH_NAME_NUM				8			// 产品名称个数，对应主线个数
+
+
+class BenchProduct : public Product
+{
+public:
+	BenchProduct(void) : m_nUsed(0) {}
+	void Recycling(void) { m_nUsed = 0; }
+
+public:
+	unsigned long		m_nUsed;
+};
+
+typedef RecyclingFactory< BenchProduct > BenchFactory;
+
+
+static uint64_t NowNs(void)
+{
+	struct timespec ts;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return (uint64_t)ts.tv_sec * 1000000000 + ts.tv_nsec;
+}
+
+/// 持有nLive个产品时测试，返回各项测试每次操作的平均耗时(纳秒)
+static void Bench(size_t nLive, size_t nRounds, double& fPair, double& fChurn, double& fTouch)
+{
+	BenchFactory factory;
+	vector< string > vNames;
+	vector< const BenchFactory::TheProduct* > vLive;
+	uint64_t begin;
+	unsigned int seed = 1;
+
+	for (size_t i = 0; i < BENCH_NAME_NUM; ++i)
+	{
+		char name[32];
+		snprintf(name, sizeof(name), "line_%lu", (unsigned long)i);
+		vNames.push_back(name);
+	}
+	for (size_t i = 0; i < nLive; ++i)
+	{
+		vLive.push_back(factory.Produce(vNames[i % BENCH_NAME_NUM]));
+	}
+	/// 每个名称预先回收一个产品，测试中取得的均为空闲产品，不计入new的耗时
+	for (size_t i = 0; i < BENCH_NAME_NUM; ++i)
+	{
+		factory.Recycling(factory.Produce(vNames[i]));
+	}
+
+	begin = NowNs();
+	for (size_t i = 0; i < nRounds; ++i)
+	{
+		const BenchFactory::TheProduct* p = factory.Produce(vNames[i % BENCH_NAME_NUM]);
+		++p->GetProduct()->m_nUsed;
+		factory.Recycling(p);
+	}
+	fPair = (double)(NowNs() - begin) / nRounds;
+
+	begin = NowNs();
+	for (size_t i = 0; i < nRounds; ++i)
+	{
+		size_t k = rand_r(&seed) % nLive;
+		const string& name = vLive[k]->GetName();
+		factory.Recycling(vLive[k]);
+		vLive[k] = factory.Produce(name);
+	}
+	fChurn = (double)(NowNs() - begin) / nRounds;
+
+	/// 对照：同样随机访问持有的产品，不调用工厂
+	seed = 1;
+	begin = NowNs();
+	for (size_t i = 0; i < nRounds; ++i)
+	{
+		size_t k = rand_r(&seed) % nLive;
+		++vLive[k]->GetProduct()->m_nUsed;
+	}
+	fTouch = (double)(NowNs() - begin) / nRounds;
+
+	for (size_t i = 0; i < vLive.size(); ++i)
+	{
+		factory.Recycling(vLive[i]);
+	}
+}
+
+int main(int argc, char* argv[])
+{
+	size_t nRounds = BENCH_DEFAULT_ROUNDS;
+	double fPair, fChurn, fTouch;
+
+	if (argc > 1 && atol(argv[1]) > 0)
+	{
+		nRounds = atol(argv[1]);
+	}
+	printf("%10s %20s %24s %18s\n", "live", "produce+recycle(ns)", "recycle any+produce(ns)", "random touch(ns)");
+	for (size_t nLive = 100; nLive <= 100000; nLive *= 10)
+	{
+		Bench(nLive, nRounds, fPair, fChurn, fTouch);
+		printf("%10lu %20.1f %24.1f %18.1f\n", (unsigned long)nLive, fPair, fChurn, fTouch);
+	}
+
+	return 0;
+}